@@ -0,0 +1,342 @@
+/*! \file
+    \brief Per-API call counters and latency histograms for IAssetsManager
+*/
+
+#pragma once
+
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+//
+#include "types.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Вызовы IAssetsManager, по которым ведётся статистика (A- и W-версии считаются вместе)
+enum class AssetsApi : std::uint32_t
+{
+    readNutProjectComplete,
+    reloadNutProjectState,
+    updateNutManifest,
+    readAppSelectorManifest,
+    readConfTextFile,
+    readConfDataFile,
+    readConfDataFileView,
+    readConfJson,
+    readConfJsonShared,
+    readAssetsDataFile,
+    readAssetsDataFileShared,
+    readAssetsDataFileView,
+    readIconData,
+    readIconDataView,
+    readAppIconData,
+    readAssetsDataFileAsync, // Сама асинхронная работа, в потоке ввода-вывода
+    readIconDataAsync,
+    readConfJsonAsync,
+    loadTranslations,
+
+    count // Количество, не вызов
+
+}; // enum class AssetsApi : std::uint32_t
+
+inline
+const char* getAssetsApiName(AssetsApi api)
+{
+    switch(api)
+    {
+        case AssetsApi::readNutProjectComplete  : return "readNutProjectComplete";
+        case AssetsApi::reloadNutProjectState   : return "reloadNutProjectState";
+        case AssetsApi::updateNutManifest       : return "updateNutManifest";
+        case AssetsApi::readAppSelectorManifest : return "readAppSelectorManifest";
+        case AssetsApi::readConfTextFile        : return "readConfTextFile";
+        case AssetsApi::readConfDataFile        : return "readConfDataFile";
+        case AssetsApi::readConfDataFileView    : return "readConfDataFileView";
+        case AssetsApi::readConfJson            : return "readConfJson";
+        case AssetsApi::readConfJsonShared      : return "readConfJsonShared";
+        case AssetsApi::readAssetsDataFile      : return "readAssetsDataFile";
+        case AssetsApi::readAssetsDataFileShared: return "readAssetsDataFileShared";
+        case AssetsApi::readAssetsDataFileView  : return "readAssetsDataFileView";
+        case AssetsApi::readIconData            : return "readIconData";
+        case AssetsApi::readIconDataView        : return "readIconDataView";
+        case AssetsApi::readAppIconData         : return "readAppIconData";
+        case AssetsApi::readAssetsDataFileAsync : return "readAssetsDataFileAsync";
+        case AssetsApi::readIconDataAsync       : return "readIconDataAsync";
+        case AssetsApi::readConfJsonAsync       : return "readConfJsonAsync";
+        case AssetsApi::loadTranslations        : return "loadTranslations";
+        case AssetsApi::count                   : break;
+    }
+
+    return "unknown";
+}
+
+//----------------------------------------------------------------------------
+// Ошибки считаются по значению ErrorCode, последний элемент - все коды, не попавшие в таблицу
+constexpr const std::size_t apiStatsErrorSlots     = 16;
+
+// Гистограмма времени выполнения: в элементе i - вызовы длительностью [2^(i-1), 2^i) нс, в элементе 0 - меньше 1 нс.
+// Последний элемент - всё, что дольше
+constexpr const std::size_t apiStatsLatencyBuckets = 40;
+
+//------------------------------
+// Снимок статистики одного вызова
+struct ApiStats
+{
+    std::uint64_t   calls       = 0;
+    std::uint64_t   bytes       = 0; // Прочитано из хранилища (ФС, архивы, отображённые файлы); попадания в кэш не считаются
+    std::uint64_t   cacheHits   = 0;
+    std::uint64_t   cacheMisses = 0;
+    std::uint64_t   totalNs     = 0;
+
+    std::array<std::uint64_t, apiStatsErrorSlots>       errors {}; // errors[0] - успешные вызовы (ErrorCode::ok)
+    std::array<std::uint64_t, apiStatsLatencyBuckets>   latency{};
+
+    std::uint64_t getErrorCount(ErrorCode err) const
+    {
+        std::size_t idx = (std::size_t)(std::uint32_t)err;
+        return errors[idx<apiStatsErrorSlots ? idx : apiStatsErrorSlots-1];
+    }
+
+    // Верхняя граница (в нс) времени выполнения для доли вызовов p (0..1), с точностью до элемента гистограммы
+    std::uint64_t getLatencyPercentileNs(double p) const
+    {
+        std::uint64_t total = 0;
+        for(auto n : latency)
+        {
+            total += n;
+        }
+
+        if (!total)
+        {
+            return 0;
+        }
+
+        std::uint64_t target = (std::uint64_t)(p*(double)total);
+        if (target>=total)
+        {
+            target = total-1;
+        }
+
+        std::uint64_t sum = 0;
+        for(std::size_t i=0; i!=apiStatsLatencyBuckets; ++i)
+        {
+            sum += latency[i];
+            if (sum>target)
+            {
+                return i ? (std::uint64_t(1)<<i) : 1;
+            }
+        }
+
+        return std::uint64_t(1)<<(apiStatsLatencyBuckets-1);
+    }
+
+}; // struct ApiStats
+
+//----------------------------------------------------------------------------
+// Счётчики одного вызова - relaxed-атомики: писатели не ждут друг друга, снимок может быть слегка несогласованным
+struct ApiCounters
+{
+    std::atomic<std::uint64_t>   calls       {0};
+    std::atomic<std::uint64_t>   bytes       {0};
+    std::atomic<std::uint64_t>   cacheHits   {0};
+    std::atomic<std::uint64_t>   cacheMisses {0};
+    std::atomic<std::uint64_t>   totalNs     {0};
+
+    std::array<std::atomic<std::uint64_t>, apiStatsErrorSlots>       errors {};
+    std::array<std::atomic<std::uint64_t>, apiStatsLatencyBuckets>   latency{};
+
+
+    static std::size_t getLatencyBucket(std::uint64_t ns)
+    {
+        std::size_t idx = 0;
+        for(; ns && idx!=apiStatsLatencyBuckets-1; ns>>=1)
+        {
+            ++idx;
+        }
+
+        return idx;
+    }
+
+    void addCall(ErrorCode err, std::uint64_t ns)
+    {
+        std::size_t errIdx = (std::size_t)(std::uint32_t)err;
+        if (errIdx>=apiStatsErrorSlots)
+        {
+            errIdx = apiStatsErrorSlots-1;
+        }
+
+        calls.fetch_add(1, std::memory_order_relaxed);
+        totalNs.fetch_add(ns, std::memory_order_relaxed);
+        errors[errIdx].fetch_add(1, std::memory_order_relaxed);
+        latency[getLatencyBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ApiStats getStats() const
+    {
+        ApiStats stats;
+        stats.calls       = calls      .load(std::memory_order_relaxed);
+        stats.bytes       = bytes      .load(std::memory_order_relaxed);
+        stats.cacheHits   = cacheHits  .load(std::memory_order_relaxed);
+        stats.cacheMisses = cacheMisses.load(std::memory_order_relaxed);
+        stats.totalNs     = totalNs    .load(std::memory_order_relaxed);
+
+        for(std::size_t i=0; i!=apiStatsErrorSlots; ++i)
+        {
+            stats.errors[i] = errors[i].load(std::memory_order_relaxed);
+        }
+
+        for(std::size_t i=0; i!=apiStatsLatencyBuckets; ++i)
+        {
+            stats.latency[i] = latency[i].load(std::memory_order_relaxed);
+        }
+
+        return stats;
+    }
+
+    void reset()
+    {
+        calls      .store(0, std::memory_order_relaxed);
+        bytes      .store(0, std::memory_order_relaxed);
+        cacheHits  .store(0, std::memory_order_relaxed);
+        cacheMisses.store(0, std::memory_order_relaxed);
+        totalNs    .store(0, std::memory_order_relaxed);
+
+        for(auto &n : errors)
+        {
+            n.store(0, std::memory_order_relaxed);
+        }
+
+        for(auto &n : latency)
+        {
+            n.store(0, std::memory_order_relaxed);
+        }
+    }
+
+}; // struct ApiCounters
+
+//----------------------------------------------------------------------------
+struct ApiStatsRegistry
+{
+
+protected:
+
+    std::array<ApiCounters, (std::size_t)AssetsApi::count>   m_counters;
+
+public:
+
+    ApiStatsRegistry() {}
+
+    ApiStatsRegistry(const ApiStatsRegistry &) = delete;
+    ApiStatsRegistry& operator=(const ApiStatsRegistry &) = delete;
+
+    ApiCounters& getCounters(AssetsApi api)
+    {
+        return m_counters[(std::size_t)api];
+    }
+
+    ApiStats getStats(AssetsApi api) const
+    {
+        if ((std::size_t)api>=m_counters.size())
+        {
+            return ApiStats();
+        }
+
+        return m_counters[(std::size_t)api].getStats();
+    }
+
+    void reset()
+    {
+        for(auto &c : m_counters)
+        {
+            c.reset();
+        }
+    }
+
+}; // struct ApiStatsRegistry
+
+//----------------------------------------------------------------------------
+// Учёт одного вызова API. Пока объект жив, он - текущий вызов своего потока: прочитанные байты и обращения к кэшам
+// (countBytes/countCacheHit/countCacheMiss из глубины реализации) записываются на него.
+// При вложенных вызовах учитывается самый внутренний
+struct ApiCallScope
+{
+
+protected:
+
+    typedef std::chrono::steady_clock   Clock;
+
+    ApiCounters            &m_counters;
+    ApiCounters            *m_pPrevCounters;
+    Clock::time_point       m_start;
+
+    static ApiCounters*& current()
+    {
+        thread_local ApiCounters *pCounters = 0;
+        return pCounters;
+    }
+
+public:
+
+    ApiCallScope(ApiStatsRegistry &registry, AssetsApi api)
+    : m_counters(registry.getCounters(api))
+    , m_pPrevCounters(current())
+    , m_start(Clock::now())
+    {
+        current() = &m_counters;
+    }
+
+    ~ApiCallScope()
+    {
+        current() = m_pPrevCounters;
+    }
+
+    ApiCallScope(const ApiCallScope &) = delete;
+    ApiCallScope& operator=(const ApiCallScope &) = delete;
+
+    // Завершение вызова, возвращает err для return apiScope.done(...)
+    ErrorCode done(ErrorCode err)
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now()-m_start).count();
+        m_counters.addCall(err, ns>0 ? (std::uint64_t)ns : 0u);
+        return err;
+    }
+
+    static void countBytes(std::uint64_t bytes)
+    {
+        if (ApiCounters *pCounters = current())
+        {
+            pCounters->bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    static void countCacheHit()
+    {
+        if (ApiCounters *pCounters = current())
+        {
+            pCounters->cacheHits.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void countCacheMiss()
+    {
+        if (ApiCounters *pCounters = current())
+        {
+            pCounters->cacheMisses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+}; // struct ApiCallScope
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
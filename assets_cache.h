@@ -0,0 +1,200 @@
+/*! \file
+    \brief Shared LRU cache for assets file data
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//
+#include "file_stamp.h"
+#include "types.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Кэш содержимого файлов ассетов.
+// Ключ - нормализованное полное имя файла в VFS (/assets/...), вместе с данными хранится отметка файла,
+// с которой он был прочитан. Данные выдаются только при совпадении отметки, как в ConfJsonCache.
+// Данные хранятся в неизменяемых разделяемых буферах, поэтому выданный наружу буфер
+// остаётся валидным и после вытеснения из кэша.
+// Суммарный объём ограничен бюджетом, при превышении вытесняются давно не использовавшиеся элементы (LRU).
+// Нулевой бюджет отключает кэширование.
+struct AssetsDataCache
+{
+
+protected:
+
+    struct Entry
+    {
+        std::wstring        key  ;
+        FileStamp           stamp;
+        SharedDataBuffer    data ;
+    };
+
+    typedef std::list<Entry>                                       EntryList;
+    typedef std::unordered_map<std::wstring, EntryList::iterator>  EntryMap ;
+
+    mutable std::mutex    m_mutex   ;
+    EntryList             m_lruList ; // в начале - самые свежие
+    EntryMap              m_entries ;
+    std::size_t           m_budget   = 0;
+    std::size_t           m_usedSize = 0;
+
+
+    static std::size_t getBufferSize(const SharedDataBuffer &data)
+    {
+        return data ? data->size() : 0u;
+    }
+
+    // Вызывается под захваченным мьютексом
+    void evictToFitUnlocked(std::size_t budget)
+    {
+        while(!m_lruList.empty() && m_usedSize>budget)
+        {
+            const Entry &e = m_lruList.back();
+            m_usedSize -= getBufferSize(e.data);
+            m_entries.erase(e.key);
+            m_lruList.pop_back();
+        }
+    }
+
+
+public:
+
+    explicit AssetsDataCache(std::size_t budget=0)
+    : m_budget(budget)
+    {}
+
+    AssetsDataCache(const AssetsDataCache &) = delete;
+    AssetsDataCache& operator=(const AssetsDataCache &) = delete;
+
+
+    void setBudget(std::size_t budget)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_budget = budget;
+        evictToFitUnlocked(m_budget);
+    }
+
+    std::size_t getBudget() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_budget;
+    }
+
+    std::size_t getUsedSize() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_usedSize;
+    }
+
+    bool isEnabled() const
+    {
+        return getBudget()!=0;
+    }
+
+
+    // Поместится ли элемент такого размера в кэш - чтобы не готовить данные для insert впустую
+    bool canFit(std::size_t dataSize) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return dataSize<=m_budget;
+    }
+
+    bool find(const std::wstring &key, const FileStamp &stamp, SharedDataBuffer &data)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_entries.find(key);
+        if (it==m_entries.end())
+        {
+            return false;
+        }
+
+        if (it->second->stamp!=stamp)
+        {
+            // Файл изменился - элемент больше не нужен
+            m_usedSize -= getBufferSize(it->second->data);
+            m_lruList.erase(it->second);
+            m_entries.erase(it);
+            return false;
+        }
+
+        // Перемещаем в начало списка - элемент только что использовался
+        m_lruList.splice(m_lruList.begin(), m_lruList, it->second);
+
+        data = it->second->data;
+
+        return true;
+    }
+
+    void insert(const std::wstring &key, const FileStamp &stamp, SharedDataBuffer data)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::size_t dataSize = getBufferSize(data);
+        if (!data || dataSize>m_budget)
+        {
+            // Не влезает в бюджет целиком - не кэшируем
+            return;
+        }
+
+        auto it = m_entries.find(key);
+        if (it!=m_entries.end())
+        {
+            m_usedSize -= getBufferSize(it->second->data);
+            m_lruList.erase(it->second);
+            m_entries.erase(it);
+        }
+
+        evictToFitUnlocked(m_budget-dataSize);
+
+        m_lruList.emplace_front(Entry{key, stamp, std::move(data)});
+        m_entries[key] = m_lruList.begin();
+        m_usedSize += dataSize;
+    }
+
+    void erase(const std::wstring &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_entries.find(key);
+        if (it==m_entries.end())
+        {
+            return;
+        }
+
+        m_usedSize -= getBufferSize(it->second->data);
+        m_lruList.erase(it->second);
+        m_entries.erase(it);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        m_lruList.clear();
+        m_usedSize = 0;
+    }
+
+}; // struct AssetsDataCache
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
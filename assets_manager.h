@@ -8,10 +8,17 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <unordered_map>
 #include <unordered_set>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 //
 #include "i_assets_manager.h"
+#include "i_assets_manager_diagnostics.h"
 
 //
 #include "umba/filename.h"
@@ -25,6 +32,26 @@
 
 //
 #include "defs.h"
+#include "assets_cache.h"
+#include "conf_json_cache.h"
+#include "dir_listing_cache.h"
+#include "mount_index.h"
+#include "mapped_file.h"
+#include "worker_pool.h"
+#include "file_stamp.h"
+#include "hash_utils.h"
+#include "case_fold.h"
+#include "nut_project_cache.h"
+#include "nut_bytecode_bundle.h"
+#include "packed_archive.h"
+#include "async_requests.h"
+#include "nut_type_matcher.h"
+#include "json_schema.h"
+#include "config_text_format.h"
+#include "text_encoding.h"
+#include "nut_project_sax.h"
+#include "profiler.h"
+#include "api_stats.h"
 
 //
 #include "marty_virtual_fs/i_app_paths.h"
@@ -51,13 +78,91 @@ namespace marty_assets_manager {
 
 // Тут у нас нет понятия текущий каталог, путь начинается с корня - '/', если корень отсутствует явно, то считается, что все равно путь начинается с корня
 struct AssetsManager : public IAssetsManager
+                     , public IAssetsManagerDiagnostics
 {
 
 protected:
 
+    // Настройки менеджера. Опубликованный экземпляр не меняется: при любой перенастройке создаётся
+    // изменённая копия и атомарно подменяется (RCU). Читатели берут снимок через getConfig() без блокировок,
+    // снимок остаётся валидным, пока на него есть ссылка
+    struct Config
+    {
+        std::wstring                                   projectName;
+
+        // Точки монтирования VFS, для которых известен каталог локальной ФС
+        std::unordered_map<std::wstring, std::wstring> nativeMountPoints;
+
+        // Точки монтирования VFS, подменённые упакованными архивами
+        std::unordered_map<std::wstring, std::shared_ptr<PackedArchive> > packedMounts;
+
+        // Индексы содержимого локальных точек монтирования (см. MountIndex), строятся только по запросу
+        std::unordered_map<std::wstring, std::shared_ptr<const MountIndex> > mountIndexes;
+
+        // Пул потоков для параллельной загрузки, создаётся только по запросу
+        std::shared_ptr<WorkerPool>                    pLoaderPool;
+
+        // Каталог локальной ФС для кэша разобранных проектов. Пустой - кэш отключен
+        std::wstring                                   projectCacheDir;
+
+        // Сериализовать обращения к IFileSystem (для реализаций, не допускающих параллельного чтения)
+        bool                                           serializeFsAccess = false;
+    };
+
+    typedef std::shared_ptr<const Config>          ConfigPtr;
+
+
     std::shared_ptr<marty_virtual_fs::IFileSystem> m_pFs        ;
-    std::wstring                                   m_projectName;
 
+    mutable AssetsDataCache                        m_assetsCache;
+    mutable ConfJsonCache                          m_confJsonCache;
+    mutable NativeDirListingCache                  m_dirListingCache;
+    mutable ApiStatsRegistry                       m_apiStats;
+
+    #if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<ConfigPtr>                         m_pConfig    ;
+    #else
+    ConfigPtr                                      m_pConfig    ; // Только через std::atomic_load/std::atomic_store
+    #endif
+    std::mutex                                     m_configUpdateMutex; // Писатели конфигурации выполняются по очереди
+
+    mutable std::mutex                             m_fsMutex    ; // См. Config::serializeFsAccess
+
+    // Асинхронные запросы - ключ запроса это нормализованное полное имя файла в VFS
+    mutable AsyncRequestCoalescer<AsyncDataResult> m_asyncDataRequests;
+    mutable AsyncRequestCoalescer<AsyncJsonResult> m_asyncJsonRequests;
+
+    // Пул потоков ввода-вывода для асинхронных запросов, создаётся при первом запросе.
+    // Последняя ссылка на него - у менеджера (см. ~AssetsManager, setAsyncIoThreadsCount)
+    mutable std::mutex                             m_asyncIoPoolMutex;
+    std::size_t                                    m_asyncIoThreadsCount = MARTY_ASSMAN_ASYNC_IO_DEFAULT_THREADS;
+    mutable std::shared_ptr<WorkerPool>            m_pAsyncIoPool;
+
+
+    ConfigPtr getConfig() const
+    {
+        #if defined(__cpp_lib_atomic_shared_ptr)
+            return m_pConfig.load();
+        #else
+            return std::atomic_load(&m_pConfig);
+        #endif
+    }
+
+    // Копирует текущую конфигурацию, применяет к копии func(Config&) и публикует результат
+    template<typename Func>
+    void updateConfig(Func func)
+    {
+        std::lock_guard<std::mutex> lock(m_configUpdateMutex);
+
+        auto pNewConfig = std::make_shared<Config>(*getConfig());
+        func(*pNewConfig);
+
+        #if defined(__cpp_lib_atomic_shared_ptr)
+            m_pConfig.store(ConfigPtr(pNewConfig));
+        #else
+            std::atomic_store(&m_pConfig, ConfigPtr(pNewConfig));
+        #endif
+    }
 
     template<typename StringType>
     StringType filenameFromText(const std::string &str) const
@@ -73,1126 +178,910 @@ protected:
     }
 
     template<typename StringType>
-    StringType decodeText(const std::string &str) const
+    std::wstring makeWideFilename(const StringType &str) const
     {
         if constexpr (sizeof(typename StringType::value_type)>1)
         {
-            return m_pFs->decodeText(str);
+            return str;
         }
         else
         {
-            return str;
+            return m_pFs->decodeFilename(str);
         }
     }
 
+    // Разбивает полное имя файла в VFS на имя точки монтирования и путь внутри неё
     template<typename StringType>
-    std::string encodeText(const StringType &str) const
+    bool splitVfsMountPointName(const StringType &vfsFileName, std::wstring &mountPointName, std::wstring &subPath) const
     {
-        if constexpr (sizeof(typename StringType::value_type)>1)
+        std::wstring name = makeWideFilename(vfsFileName);
+
+        std::wstring::size_type pos = name.find_first_not_of(L"/\\");
+        if (pos==name.npos)
         {
-            return m_pFs->encodeText(str);
+            return false;
         }
-        else
+
+        std::wstring::size_type sepPos = name.find_first_of(L"/\\", pos);
+        if (sepPos==name.npos)
         {
-            return str;
+            mountPointName = name.substr(pos);
+            subPath.clear();
+            return true;
         }
-    }
 
+        mountPointName = name.substr(pos, sepPos-pos);
+        subPath        = name.substr(sepPos+1);
 
-    nlohmann::json readGenericJsonFromUtfString( const std::string &jsonStr
-                                               , const std::string &fileName
-                                               ) const
-    {
-        return marty_simplesquirrel::json_helpers::readGenericJsonFromUtfString(jsonStr, fileName);
-    }
+        // Нормализованное имя не должно выходить за пределы точки монтирования, но проверим
+        std::wstring::size_type dotsPos = subPath.find(L"..");
+        while(dotsPos!=subPath.npos)
+        {
+            bool startsPart = dotsPos==0 || subPath[dotsPos-1]==L'/' || subPath[dotsPos-1]==L'\\';
+            bool endsPart   = dotsPos+2==subPath.size() || subPath[dotsPos+2]==L'/' || subPath[dotsPos+2]==L'\\';
+            if (startsPart && endsPart)
+            {
+                return false;
+            }
 
-    nlohmann::json readGenericJsonFromUtfString( const std::string &jsonStr
-                                               , const std::wstring &fileName
-                                               ) const
-    {
-        return marty_simplesquirrel::json_helpers::readGenericJsonFromUtfString(jsonStr, m_pFs->encodeFilename(fileName));
+            dotsPos = subPath.find(L"..", dotsPos+2);
+        }
+
+        return true;
     }
 
+    // Полное имя файла в VFS, один раз нормализованное и разбитое на точку монтирования и путь внутри неё, вместе
+    // со снимком конфигурации. Проверки одного обращения (архив, индекс, локальная ФС) идут по нему, не повторяя
+    // нормализацию и разбор имени, и видят одну и ту же конфигурацию
+    struct VfsFileLocation
+    {
+        ConfigPtr       pConfig       ;
+        std::wstring    mountPointName;
+        std::wstring    subPath       ;
+        bool            valid = false ;
+    };
 
     template<typename StringType>
-    NutType detectFileNutTypeImpl(const StringType &fname) const
+    VfsFileLocation locateVfsFile(const StringType &vfsFileName) const
     {
-        StringType fnameUpper = umba::string_plus::toupper_copy(fname);
-
-
-        static const StringType nutExt           = umba::string_plus::make_string<StringType>(".NUT") ; // single file suffix
+        VfsFileLocation loc;
+        loc.pConfig = getConfig();
+        loc.valid   = splitVfsMountPointName(m_pFs->normalizeFilename(vfsFileName), loc.mountPointName, loc.subPath);
+        return loc;
+    }
 
-        if (umba::string_plus::ends_with(fnameUpper, nutExt))
+    // Поиск имени файла в локальной ФС
+    bool resolveNativeFilename(const VfsFileLocation &loc, std::wstring &nativeFileName) const
+    {
+        if (!loc.valid)
         {
-            return NutType::nutFile;
+            return false;
         }
 
-
-        static const StringType nutsJsnProjExt1  = umba::string_plus::make_string<StringType>(".NUTSJSNPROJ"); // project suffix
-        static const StringType nutsJsnProjExt2  = umba::string_plus::make_string<StringType>(".NUTJSNPROJ"); // project suffix
-        static const StringType nutsJsonExt      = umba::string_plus::make_string<StringType>(".NUTS.JSON"); // project suffix (double ext)
-
-        static const StringType nutsYmlProjExt1  = umba::string_plus::make_string<StringType>(".NUTSYMLPROJ"); // project suffix
-        static const StringType nutsYmlProjExt2  = umba::string_plus::make_string<StringType>(".NUTYMLPROJ"); // project suffix
-        static const StringType nutsYamlExt      = umba::string_plus::make_string<StringType>(".NUTS.YAML"); // project suffix (double ext)
-
-        if ( umba::string_plus::ends_with(fnameUpper, nutsJsnProjExt1)
-          || umba::string_plus::ends_with(fnameUpper, nutsJsnProjExt2)
-          || umba::string_plus::ends_with(fnameUpper, nutsJsonExt)
-          || umba::string_plus::ends_with(fnameUpper, nutsYmlProjExt1)
-          || umba::string_plus::ends_with(fnameUpper, nutsYmlProjExt2)
-          || umba::string_plus::ends_with(fnameUpper, nutsYamlExt)
-           )
+        auto mpIt = loc.pConfig->nativeMountPoints.find(loc.mountPointName);
+        if (mpIt==loc.pConfig->nativeMountPoints.end())
         {
-            return NutType::dotNutProject;
+            return false;
         }
 
+        nativeFileName = loc.subPath.empty() ? mpIt->second : umba::filename::appendPath(mpIt->second, loc.subPath);
 
-        static const StringType appSelectorExtJ  = umba::string_plus::make_string<StringType>("DOTNUT.APP-SELECTOR.MANIFEST.JSON");
-        static const StringType appSelectorExtY  = umba::string_plus::make_string<StringType>("DOTNUT.APP-SELECTOR.MANIFEST.YAML");
+        return true;
+    }
 
-        if ( umba::string_plus::ends_with(fnameUpper, appSelectorExtJ)
-          || umba::string_plus::ends_with(fnameUpper, appSelectorExtY)
-           )
+    template<typename StringType>
+    bool resolveNativeFilename(const StringType &vfsFileName, std::wstring &nativeFileName) const
+    {
+        if (getConfig()->nativeMountPoints.empty())
         {
-            return NutType::dotNutAppSelector;
+            return false;
         }
 
+        return resolveNativeFilename(locateVfsFile(vfsFileName), nativeFileName);
+    }
 
-        static const StringType manifestExt1     = umba::string_plus::make_string<StringType>(".DOTNUT-MANIFEST.JSON");
-        static const StringType manifestExt2     = umba::string_plus::make_string<StringType>(".MANIFEST.JSON");
-        static const StringType manifestExt3     = umba::string_plus::make_string<StringType>(".DOTNUT-MANIFEST.YAML");
-        static const StringType manifestExt4     = umba::string_plus::make_string<StringType>(".MANIFEST.YAML");
-
-        if ( umba::string_plus::ends_with(fnameUpper, manifestExt1)
-          || umba::string_plus::ends_with(fnameUpper, manifestExt2)
-          || umba::string_plus::ends_with(fnameUpper, manifestExt3)
-          || umba::string_plus::ends_with(fnameUpper, manifestExt4)
-           )
+    // Поиск упакованного архива, подключенного вместо каталога.
+    // Имя файла внутри архива возвращается в UTF-8 с разделителем '/'
+    std::shared_ptr<const PackedArchive> findPackedArchive(const VfsFileLocation &loc, std::string &nameInArchive) const
+    {
+        if (!loc.valid || loc.subPath.empty())
         {
-            return NutType::dotNutManifect;
+            return 0;
         }
 
-        static const StringType jsonExt          = umba::string_plus::make_string<StringType>(".JSON"); // project suffix
-        static const StringType yamlExt          = umba::string_plus::make_string<StringType>(".YAML"); // project suffix
-
-        if ( umba::string_plus::ends_with(fnameUpper, jsonExt)
-          || umba::string_plus::ends_with(fnameUpper, yamlExt)
-           )
+        auto mpIt = loc.pConfig->packedMounts.find(loc.mountPointName);
+        if (mpIt==loc.pConfig->packedMounts.end())
         {
-            return NutType::dotNutProject;
+            return 0;
         }
 
-        return NutType::unknownNutType;
+        nameInArchive = umba::toUtf8(loc.subPath);
+        std::replace(nameInArchive.begin(), nameInArchive.end(), '\\', '/');
 
+        return mpIt->second;
     }
 
     template<typename StringType>
-    ErrorCode readNutProjectImpl( const StringType               &fileName
-                                , NutProjectT<StringType>        &prj
-                                , std::unordered_set<StringType> &loadedProjects
-                                , std::unordered_set<StringType> &loadedNuts
-                                ) const
+    std::shared_ptr<const PackedArchive> findPackedArchive(const StringType &vfsFileName, std::string &nameInArchive) const
     {
-        if (!m_pFs->isFileExistAndReadable(fileName))
+        if (getConfig()->packedMounts.empty())
         {
-            return ErrorCode::notFound;
+            return 0;
         }
 
+        return findPackedArchive(locateVfsFile(vfsFileName), nameInArchive);
+    }
 
-        StringType fileNameUpper = umba::string_plus::toupper_copy(fileName);
+    template<typename StringType>
+    bool getNativeFileNameImpl(const StringType &vfsFileName, std::wstring &nativeFileName) const
+    {
+        const VfsFileLocation loc = locateVfsFile(vfsFileName);
+        if (!loc.valid || loc.pConfig->packedMounts.find(loc.mountPointName)!=loc.pConfig->packedMounts.end())
+        {
+            return false;
+        }
 
-        bool isProjectFile = true;
+        return resolveNativeFilename(loc, nativeFileName);
+    }
 
-        NutType nutType = detectFileNutTypeImpl(fileName);
-        if (nutType!=NutType::dotNutProject)
+    // Индекс точки монтирования файла, если он построен
+    std::shared_ptr<const MountIndex> findMountIndex(const VfsFileLocation &loc) const
+    {
+        if (!loc.valid)
         {
-            isProjectFile = false;
+            return 0;
         }
 
-        
-        //if (!umba::string_plus::ends_with(fileNameUpper, nutsJsonExt))
-        if (!isProjectFile)
+        auto it = loc.pConfig->mountIndexes.find(loc.mountPointName);
+        if (it==loc.pConfig->mountIndexes.end())
         {
-            // Читаем проект из единственного .nut файла
-
-            if (loadedNuts.find(fileNameUpper)!=loadedNuts.end())
-            {
-                return ErrorCode::ok; // уже есть такой
-            }
- 
-            loadedNuts.insert(fileNameUpper);
+            return 0;
+        }
 
-            prj.projectFileName = fileName ;
-            prj.nuts.emplace_back(fileName);
+        return it->second;
+    }
 
-            return ErrorCode::ok;
-        }
-        else
+    // subPath - путь файла внутри точки монтирования
+    template<typename StringType>
+    std::shared_ptr<const MountIndex> findMountIndex(const StringType &vfsFileName, std::wstring &subPath) const
+    {
+        if (getConfig()->mountIndexes.empty())
         {
-            // read JSON project  here
+            return 0;
+        }
 
-            StringType filePath = m_pFs->getPath(fileName);
+        VfsFileLocation loc = locateVfsFile(vfsFileName);
+        subPath = loc.subPath;
 
-            try
-            {
-                std::string nutsJsonPrjText;
-                ErrorCode err = m_pFs->readTextFile(fileName, nutsJsonPrjText);
-                if (err!=ErrorCode::ok)
-                {
-                    return err;
-                }
+        return findMountIndex(loc);
+    }
 
-                //StringType fileNameUpper = umba::string_plus::toupper_copy(fileName);
-                loadedProjects.insert(fileNameUpper);
+    // Поиск файла по актуальному индексу точки монтирования. false - индекса нет, ответ надо искать в ФС
+    bool lookupMountIndex(const VfsFileLocation &loc, bool &fileExists) const
+    {
+        auto pIndex = findMountIndex(loc);
+        if (!pIndex || pIndex->isStale())
+        {
+            return false;
+        }
 
-                auto jConf = readGenericJsonFromUtfString(nutsJsonPrjText, fileName);
+        const MountIndexEntry *pEntry = pIndex->find(loc.subPath);
+        fileExists = pEntry && !pEntry->isDir;
 
-                auto filesNodeIter = jConf.find("files");
-                if (filesNodeIter!=jConf.end())
-                {
-                    auto &jFiles = filesNodeIter.value();
-                    if (!jFiles.is_array())
-                    {
-                        umba::lout << ".nuts.json: 'files' node must be an array\n";
-                        umba::gmesg(fileName, ".nuts.json: 'files' node must be an array");
-                        return ErrorCode::invalidFormat;
-                    }
+        return true;
+    }
 
-                    for (nlohmann::json::iterator jFileIt=jFiles.begin(); jFileIt!=jFiles.end(); ++jFileIt)
-                    {
-                        auto &jFileNode = jFileIt.value();
+    // Файла точно нет по закэшированному списку файлов его локального каталога (см. NativeDirListingCache).
+    // Индекс точки монтирования здесь не проверяется - см. isFileKnownMissing
+    bool isNativeFileKnownMissing(const VfsFileLocation &loc) const
+    {
+        std::wstring nativeFileName;
+        if (!resolveNativeFilename(loc, nativeFileName))
+        {
+            return false;
+        }
 
-                        if (jFileNode.is_object()) 
-                        {
-                            // разбор импорта
-                            auto includeNodeIter = jFileNode.find("include");
-                            if (includeNodeIter==jFileNode.end())
-                            {
-                               // continue; // Это объект, но там нет include - хз, что это, может ошибка 
-                               return ErrorCode::invalidFormat; // сообщим, что формат некорректный
-                            }
+        return !m_dirListingCache.mayExist(nativeFileName);
+    }
 
-                            auto &jIcludeNode    = includeNodeIter.value();
+    // Файла точно нет - по индексу точки монтирования (см. MountIndex), а если актуального индекса нет - по списку
+    // файлов его локального каталога. Для файлов вне известных менеджеру точек монтирования ничего не утверждаем
+    bool isFileKnownMissing(const VfsFileLocation &loc) const
+    {
+        bool indexedExists = false;
+        if (lookupMountIndex(loc, indexedExists))
+        {
+            return !indexedExists;
+        }
 
-                            // Импорт может быть как для одного элемента, и тогда нет массива, или для списка элементов
-                            // Но мы всегда сначала собираем всё это в вектор
-                            std::vector<StringType> includeProjectFiles;
+        return isNativeFileKnownMissing(loc);
+    }
 
-                            if (!jIcludeNode.is_array())
-                            {
-                                auto str = jIcludeNode.get<std::string>();
-                                includeProjectFiles.emplace_back(filenameFromText<StringType>(str));
-                            }
-                            else
-                            {
-                                for (nlohmann::json::iterator jIncFileIt=jIcludeNode.begin(); jIncFileIt!=jIcludeNode.end(); ++jIncFileIt)
-                                {
-                                    //auto &jIncFileNode = jIncFileIt.value();
-                                    auto str = jIncFileIt->get<std::string>();
-                                    includeProjectFiles.emplace_back(filenameFromText<StringType>(str));
-                                }
-                            }
+    // Учёт прочитанных из хранилища данных - для замеров (profiler.h) и статистики вызовов (api_stats.h)
+    static void countReadBytes(std::uint64_t bytes)
+    {
+        MARTY_ASSMAN_PROFILE_COUNT_BYTES(bytes);
+        ApiCallScope::countBytes(bytes);
+    }
 
-                            for(const auto& incPrjFile : includeProjectFiles)
-                            {
-                                auto incPrjFullName = m_pFs->normalizeFilename(m_pFs->appendPath(filePath, incPrjFile));
-                                StringType incPrjFullNameUpper = umba::string_plus::toupper_copy(incPrjFullName);
+    // Обёртки над IFileSystem: файлы из упакованных архивов читаются из архива, остальные - через VFS.
+    // Отсутствующие локальные файлы отсекаются по индексу точки монтирования или по кэшу списков каталогов,
+    // без обращения к VFS. Для проиндексированных точек монтирования и наличие файла определяется по индексу
 
-                                if (loadedProjects.find(incPrjFullNameUpper)!=loadedProjects.end())
-                                {
-                                    continue;
-                                }
+    template<typename StringType>
+    bool fsIsFileExistAndReadable(const StringType &fileName) const
+    {
+        const VfsFileLocation loc = locateVfsFile(fileName);
 
-                                loadedProjects.insert(incPrjFullNameUpper);
+        std::string nameInArchive;
+        if (auto pArchive = findPackedArchive(loc, nameInArchive))
+        {
+            return pArchive->exists(nameInArchive);
+        }
 
-                                NutProjectT<StringType> incPrj;
-                                ErrorCode err2 = readNutProjectImpl(incPrjFullName, incPrj, loadedProjects, loadedNuts);
-                                if (err2!=ErrorCode::ok)
-                                {
-                                    return err2;
-                                }
+        bool indexedExists = false;
+        if (lookupMountIndex(loc, indexedExists))
+        {
+            return indexedExists;
+        }
 
-                                prj.nuts.insert(prj.nuts.end(), incPrj.nuts.begin(), incPrj.nuts.end());
+        if (isNativeFileKnownMissing(loc))
+        {
+            return false;
+        }
 
-                            }
+        std::unique_lock<std::mutex> lock(m_fsMutex, std::defer_lock);
+        if (loc.pConfig->serializeFsAccess)
+        {
+            lock.lock();
+        }
 
-                        }
-                        else // single file
-                        {
-                            auto str             = jFileIt->get<std::string>();
-                            auto nutFile         = m_pFs->normalizeFilename(m_pFs->appendPath(filePath, filenameFromText<StringType>(str)));
-                            auto nutFileUpper    = umba::string_plus::toupper_copy(nutFile);
+        return m_pFs->isFileExistAndReadable(fileName);
+    }
 
-                            if (loadedNuts.find(nutFileUpper)!=loadedNuts.end())
-                            {
-                                continue;
-                            }
-                             
-                            loadedNuts.insert(nutFileUpper);
+    template<typename FileNameStringType>
+    ErrorCode fsReadDataFile(const FileNameStringType &fileName, std::vector<std::uint8_t> &fData) const
+    {
+        MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "fsReadDataFile");
 
-                            prj.nuts.emplace_back(nutFile);
-                            
-                            if (!m_pFs->isFileExistAndReadable(prj.nuts.back()))
-                            {
-                                //umba::lout << "Missing file '" << m_pFs->encodeFilename(prj.nuts.back()) << "\n";
-                                umba::lout << "Missing file '" << m_pFs->encodeText(prj.nuts.back()) << "'\n";
-                                umba::gmesg("Missing file '" + m_pFs->encodeText(prj.nuts.back()) + "'");
-                                return ErrorCode::missingFiles;
-                            }
-                        }
+        const VfsFileLocation loc = locateVfsFile(fileName);
 
-                    }
-                }
+        std::string nameInArchive;
+        if (auto pArchive = findPackedArchive(loc, nameInArchive))
+        {
+            ErrorCode err = pArchive->readData(nameInArchive, fData);
+            countReadBytes(err==ErrorCode::ok ? fData.size() : 0u);
+            return err;
+        }
 
-                prj.projectFileName = fileName;
-                
-            }
-            catch(const std::exception &e)
-            {
-                // Заллогировать
-                // e.what()
-                //MARTY_ASSMAN_ARG_USED(e);
-                //umba::lout << "Failed to read nut project '" << m_pFs->encodeFilename(fileName) << "': " << e.what() << "\n";
-                umba::lout << "Failed to read nut project '" << m_pFs->encodeText(fileName) << "': " << e.what() << "\n";
-                umba::lout.flush();
-                umba::gmesg(fileName, std::string("Failed to read nut project: ") + e.what());
+        if (isFileKnownMissing(loc))
+        {
+            return ErrorCode::notFound;
+        }
 
-                return ErrorCode::unknownFormat;
-                // ErrorCode::invalidFormat;
-            }
-        
-            return ErrorCode::ok;
+        std::unique_lock<std::mutex> lock(m_fsMutex, std::defer_lock);
+        if (loc.pConfig->serializeFsAccess)
+        {
+            lock.lock();
         }
 
+        ErrorCode err = m_pFs->readDataFile(fileName, fData);
+        countReadBytes(err==ErrorCode::ok ? fData.size() : 0u);
+        return err;
     }
 
-    template<typename StringType>
-    ErrorCode readNutProjectFilesImpl(NutProjectT<StringType> &prj) const
+    template<typename FileNameStringType, typename TextStringType>
+    ErrorCode fsReadTextFile(const FileNameStringType &fileName, TextStringType &fText) const
     {
-        for(auto nutFile : prj.nuts)
+        MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "fsReadTextFile");
+
+        const VfsFileLocation loc = locateVfsFile(fileName);
+
+        std::string nameInArchive;
+        if (auto pArchive = findPackedArchive(loc, nameInArchive))
         {
-            StringType fileText;
-            ErrorCode err = m_pFs->readTextFile(nutFile, fileText);
+            DataView view;
+            ErrorCode err = pArchive->readDataView(nameInArchive, view);
             if (err!=ErrorCode::ok)
             {
-                return err; // По идее, этого не должно происходить, файлы на доступность для чтения уже проверены
+                return err;
+            }
+
+            // Кодировка определяется по BOM, как и при чтении через VFS; текст без BOM должен быть в UTF-8
+            std::string utf8Text;
+            if (!decodeTextBytesToUtf8(view.data, view.size, utf8Text))
+            {
+                return ErrorCode::invalidFormat;
             }
 
-            prj.nutsData.emplace_back(fileText);
+            fText = decodeText<TextStringType>(utf8Text);
+            countReadBytes(view.size);
+
+            return ErrorCode::ok;
         }
 
-        return ErrorCode::ok;
+        if (isFileKnownMissing(loc))
+        {
+            return ErrorCode::notFound;
+        }
+
+        std::unique_lock<std::mutex> lock(m_fsMutex, std::defer_lock);
+        if (loc.pConfig->serializeFsAccess)
+        {
+            lock.lock();
+        }
 
+        ErrorCode err = m_pFs->readTextFile(fileName, fText);
+        countReadBytes(err==ErrorCode::ok ? fText.size()*sizeof(typename TextStringType::value_type) : 0u);
+        return err;
     }
 
     template<typename StringType>
-    ErrorCode readAppSelectorManifestImpl(NutAppSelectorManifestT<StringType> &appSel) const
+    StringType decodeText(const std::string &str) const
     {
-        static StringType nutAppSelectorManifest = umba::string_plus::make_string<StringType>("dotnut.app-selector.manifest.json");
-
-        if (!m_pFs->isFileExistAndReadable(nutAppSelectorManifest))
+        if constexpr (sizeof(typename StringType::value_type)>1)
         {
-            return ErrorCode::notFound;
+            return m_pFs->decodeText(str);
+        }
+        else
+        {
+            return str;
         }
+    }
 
-        std::string nutsJsonPrjText;
-        ErrorCode err = m_pFs->readTextFile(nutAppSelectorManifest, nutsJsonPrjText);
-        if (err!=ErrorCode::ok)
+    template<typename StringType>
+    std::string encodeText(const StringType &str) const
+    {
+        if constexpr (sizeof(typename StringType::value_type)>1)
         {
-            return err;
+            return m_pFs->encodeText(str);
+        }
+        else
+        {
+            return str;
         }
+    }
 
-        try
+
+    nlohmann::json readGenericJsonFromUtfString( const std::string &jsonStr
+                                               , const std::string &fileName
+                                               ) const
+    {
+        return marty_simplesquirrel::json_helpers::readGenericJsonFromUtfString(jsonStr, fileName);
+    }
+
+    nlohmann::json readGenericJsonFromUtfString( const std::string &jsonStr
+                                               , const std::wstring &fileName
+                                               ) const
+    {
+        return marty_simplesquirrel::json_helpers::readGenericJsonFromUtfString(jsonStr, m_pFs->encodeFilename(fileName));
+    }
+
+    // JSON (по расширению файла или по содержимому) разбирается напрямую, без универсального (YAML-совместимого) разбора.
+    // YAML, или не разобравшийся как JSON текст отдаётся универсальному разбору - он же и сообщит об ошибке
+    template<typename StringType>
+    nlohmann::json readJsonFromUtfString(const std::string &text, const StringType &fileName) const
+    {
+        if (detectConfigTextFormat(fileName, text)==ConfigTextFormat::json)
         {
-            auto jConf = readGenericJsonFromUtfString(nutsJsonPrjText, nutAppSelectorManifest);
-    
-            auto appListNodeIter = jConf.find("app-list");
-            if (appListNodeIter==jConf.end())
+            nlohmann::json j = nlohmann::json::parse(text, nullptr, false /* allow_exceptions */);
+            if (!j.is_discarded())
             {
-                umba::gmesg("dotnut.app-selector.manifest.json", "no 'app-list' node found");
-                return ErrorCode::invalidFormat;
-                //return ErrorCode::notFound;
+                return j;
             }
-    
-            auto &jAppListNode = appListNodeIter.value();
-            if (!jAppListNode.is_array())
+        }
+
+        return readGenericJsonFromUtfString(text, fileName);
+    }
+
+
+    template<typename StringType>
+    NutType detectFileNutTypeImpl(const StringType &fname) const
+    {
+        return getNutTypeSuffixMatcher().match(fname);
+    }
+
+    // Состояние разбора проекта: уже подключенные проекты и nut-файлы (для исключения повторов),
+    // а также разобранные файлы проектов - для повторного использования при перезагрузке.
+    // loadedProjects/loadedNuts ссылаются на имена из разобранных файлов (pReuseFiles и localFiles)
+    // и на имя, с которого начат разбор - все они живут дольше контекста
+    template<typename StringType>
+    struct NutProjectParseContext
+    {
+        CaseFoldNameSet<StringType>                                          loadedProjects;
+        CaseFoldNameSet<StringType>                                          loadedNuts    ;
+
+        const std::unordered_map<StringType, NutProjectFileT<StringType> >  *pReuseFiles   = 0; // Не изменившиеся с прошлого разбора
+        std::unordered_map<StringType, NutProjectFileT<StringType> >        *pParsedFiles  = 0; // Сюда складываются все разобранные файлы
+
+        std::unordered_map<StringType, NutProjectFileT<StringType> >         localFiles    ; // Разобранные в этом проходе, в том числе заранее
+        bool                                                                 includesPrefetched = false;
+        bool                                                                 takeStamps    = false; // Отметки файлов нужны состоянию проекта или кэшу проекта
+    };
+
+    // Разбор одного файла проекта. Подключения не раскрываются.
+    // takeStamp==false - отметка файла не нужна (простое чтение проекта), лишнее обращение к ФС не делаем.
+    // reportErrors==false - ошибки только возвращаются, без сообщений (для разбора заранее, см. prefetchNutProjectIncludesImpl)
+    template<typename StringType>
+    ErrorCode parseNutProjectFileImpl(const StringType &fileName, NutProjectFileT<StringType> &prjFile, bool takeStamp, bool reportErrors=true) const
+    {
+        prjFile.fileName = fileName;
+        prjFile.items.clear();
+
+        // Отметку берём до чтения - если файл поменяют во время чтения, при следующей проверке он будет перечитан
+        if (!takeStamp || !getFileStampImpl(fileName, prjFile.stamp))
+        {
+            prjFile.stamp = FileStamp();
+        }
+
+        StringType filePath = m_pFs->getPath(fileName);
+
+        try
+        {
+            std::string nutsJsonPrjText;
+            ErrorCode err = fsReadTextFile(fileName, nutsJsonPrjText);
+            if (err!=ErrorCode::ok)
             {
-                umba::gmesg("dotnut.app-selector.manifest.json", "'app-list' node is not an array");
-                return ErrorCode::invalidFormat;
+                return err;
             }
-    
-            appSel.manifestItems.clear();
-    
-            for (nlohmann::json::iterator jAppListItemsIt=jAppListNode.begin(); jAppListItemsIt!=jAppListNode.end(); ++jAppListItemsIt)
+
+            // JSON разбираем потоково, без построения дерева
+            if (detectConfigTextFormat(fileName, nutsJsonPrjText)==ConfigTextFormat::json)
             {
-                // title/app-name
-                auto jAppNameIter = jAppListItemsIt->find("app-name");
-                if (jAppNameIter==jAppListItemsIt->end())
+                NutProjectJsonSaxHandler handler;
+                if (parseNutProjectJsonText(nutsJsonPrjText, handler))
                 {
-                    continue;
+                    prjFile.items.reserve(handler.items.size());
+                    for(const auto &item : handler.items)
+                    {
+                        prjFile.items.emplace_back(item.first, m_pFs->normalizeFilename(m_pFs->appendPath(filePath, filenameFromText<StringType>(item.second))));
+                    }
+
+                    return ErrorCode::ok;
                 }
-    
-                try
+
+                if (!handler.syntaxError)
                 {
-                    std::string strAppName           = jAppNameIter->get<std::string>();
-                    StringType  strAppNameStringType = filenameFromText<StringType>(strAppName);
-                    if (strAppNameStringType.empty())
+                    if (!reportErrors || handler.quietError)
                     {
-                        continue;
+                        // Объект без 'include' - разбор через DOM тоже возвращает только код
                     }
-    
-                    std::string strAppTitle;
-                    auto jAppTitleIter = jAppListItemsIt->find("title");
-                    if (jAppTitleIter!=jAppListItemsIt->end())
+                    else if (handler.errorCode==ErrorCode::invalidFormat)
                     {
-                        strAppTitle = jAppTitleIter->get<std::string>();
+                        umba::lout << ".nuts.json: " << handler.errorText << "\n";
+                        umba::gmesg(fileName, ".nuts.json: " + handler.errorText);
                     }
-    
-                    StringType strAppTitleStringType = filenameFromText<StringType>(strAppTitle);
-                    if (strAppTitleStringType.empty())
+                    else
                     {
-                        strAppTitleStringType = strAppNameStringType;
+                        umba::lout << "Failed to read nut project '" << m_pFs->encodeText(fileName) << "': " << handler.errorText << "\n";
+                        umba::lout.flush();
+                        umba::gmesg(fileName, "Failed to read nut project: " + handler.errorText);
                     }
-    
-                    appSel.manifestItems.emplace_back(NutAppSelectorManifestItemT<StringType>{strAppTitleStringType, strAppNameStringType});
+
+                    return handler.errorCode;
                 }
-                catch(const std::exception &e)
+
+                // Синтаксическая ошибка JSON - пробуем универсальный разбор
+            }
+
+            auto jConf = readGenericJsonFromUtfString(nutsJsonPrjText, fileName);
+
+            auto filesNodeIter = jConf.find("files");
+            if (filesNodeIter!=jConf.end())
+            {
+                auto &jFiles = filesNodeIter.value();
+                if (!jFiles.is_array())
                 {
-                    MARTY_ASSMAN_ARG_USED(e);
+                    if (reportErrors)
+                    {
+                        umba::lout << ".nuts.json: 'files' node must be an array\n";
+                        umba::gmesg(fileName, ".nuts.json: 'files' node must be an array");
+                    }
+                    return ErrorCode::invalidFormat;
                 }
-                catch(...)
+
+                for (nlohmann::json::iterator jFileIt=jFiles.begin(); jFileIt!=jFiles.end(); ++jFileIt)
                 {
+                    auto &jFileNode = jFileIt.value();
+
+                    if (jFileNode.is_object()) 
+                    {
+                        // разбор импорта
+                        auto includeNodeIter = jFileNode.find("include");
+                        if (includeNodeIter==jFileNode.end())
+                        {
+                           // continue; // Это объект, но там нет include - хз, что это, может ошибка 
+                           return ErrorCode::invalidFormat; // сообщим, что формат некорректный
+                        }
+
+                        auto &jIcludeNode    = includeNodeIter.value();
+
+                        // Импорт может быть как для одного элемента, и тогда нет массива, или для списка элементов
+                        if (!jIcludeNode.is_array())
+                        {
+                            auto str = jIcludeNode.get<std::string>();
+                            prjFile.items.emplace_back(true, m_pFs->normalizeFilename(m_pFs->appendPath(filePath, filenameFromText<StringType>(str))));
+                        }
+                        else
+                        {
+                            for (nlohmann::json::iterator jIncFileIt=jIcludeNode.begin(); jIncFileIt!=jIcludeNode.end(); ++jIncFileIt)
+                            {
+                                auto str = jIncFileIt->get<std::string>();
+                                prjFile.items.emplace_back(true, m_pFs->normalizeFilename(m_pFs->appendPath(filePath, filenameFromText<StringType>(str))));
+                            }
+                        }
+                    }
+                    else // single file
+                    {
+                        auto str = jFileIt->get<std::string>();
+                        prjFile.items.emplace_back(false, m_pFs->normalizeFilename(m_pFs->appendPath(filePath, filenameFromText<StringType>(str))));
+                    }
+
                 }
-                
             }
-    
         }
         catch(const std::exception &e)
         {
-            umba::lout << "Failed to read 'dotnut.app-selector.manifest.json': " << e.what() << "\n";
-            umba::lout.flush();
-            //umba::gmesg("dotnut.app-selector.manifest.json", e.what());
-            umba::gmesg(e.what());
-            return ErrorCode::invalidFormat;
-        }
-        catch(...)
-        {
-            umba::lout << "Failed to read 'dotnut.app-selector.manifest.json': " << "unknown error" << "\n";
-            umba::lout.flush();
-            umba::gmesg("dotnut.app-selector.manifest.json", "unknown error");
-            //umba::gmesg(e.what());
-            return ErrorCode::invalidFormat;
+            // Заллогировать
+            // e.what()
+            //MARTY_ASSMAN_ARG_USED(e);
+            //umba::lout << "Failed to read nut project '" << m_pFs->encodeFilename(fileName) << "': " << e.what() << "\n";
+            if (reportErrors)
+            {
+                umba::lout << "Failed to read nut project '" << m_pFs->encodeText(fileName) << "': " << e.what() << "\n";
+                umba::lout.flush();
+                umba::gmesg(fileName, std::string("Failed to read nut project: ") + e.what());
+            }
+
+            return ErrorCode::unknownFormat;
+            // ErrorCode::invalidFormat;
         }
 
         return ErrorCode::ok;
     }
 
+    // Разбор заранее всех подключаемых файлов проектов дерева. Разбор идёт волнами: файлы, подключаемые из файлов
+    // предыдущей волны, разбираются параллельно, так что время определяется самой длинной цепочкой подключений,
+    // а не их суммой. Сам проект потом собирается обычным последовательным проходом - порядок nut-файлов и исключение
+    // повторов остаются прежними. Файлы с ошибками не сохраняются - их разберёт последовательный проход, он же и сообщит об ошибке
     template<typename StringType>
-    ErrorCode readNutProjectCompleteImpl(NutProjectT<StringType> &prj) const
+    void prefetchNutProjectIncludesImpl( const NutProjectFileT<StringType>  &rootFile
+                                       , NutProjectParseContext<StringType> &ctx
+                                       , WorkerPool                         &loaderPool
+                                       ) const
     {
-        StringType projectName;
-        ErrorCode err = getProjectName(projectName);
-        if (err!=ErrorCode::ok)
+        CaseFoldNameSet<StringType>                       seenFiles;
+        std::vector<const NutProjectFileT<StringType>*>   pending  ; // Разобранные, но ещё не просмотренные файлы
+        std::vector<StringType>                           wave     ;
+
+        seenFiles.insert(rootFile.fileName);
+        pending.emplace_back(&rootFile);
+
+        for(;;)
         {
-            return err;
-        }
+            while(!pending.empty())
+            {
+                const NutProjectFileT<StringType> *pPrjFile = pending.back();
+                pending.pop_back();
 
-        StringType fullNameBase     = m_pFs->appendPath(umba::string_plus::make_string<StringType>("/nuts"), projectName);
-        
-        std::vector<StringType> projectFileNames;
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.json"  )));
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.jsn"   )));
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutsjsnproj")));
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutjsnproj" )));
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.yaml"  )));
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.yml"   )));
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutsymlproj")));
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutymlproj" )));
-        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nut"        )));
+                for(const auto &item : pPrjFile->items)
+                {
+                    if (!item.first || detectFileNutTypeImpl(item.second)!=NutType::dotNutProject)
+                    {
+                        continue;
+                    }
 
-        //StringType fullNameNut      = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nut"        ));
+                    if (!seenFiles.insert(item.second).second)
+                    {
+                        continue;
+                    }
 
-        // // .nutsjsnproj .nutjsnproj .nuts.json
-        // StringType fullNameNutJson1 = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutsjsnproj"));
-        // StringType fullNameNutJson2 = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutjsnproj" ));
-        // StringType fullNameNutJson3 = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.json"  ));
-        // StringType fullNameNutJson4 = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.jsn"   ));
-        // StringType fullNameNutYaml1 = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutsymlproj"));
-        // StringType fullNameNutYaml2 = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutymlproj" ));
-        // StringType fullNameNutYaml3 = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.yaml"  ));
-        // StringType fullNameNutYaml4 = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.yml"   ));
-        // StringType fullNameNut      = m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nut"        ));
+                    if (ctx.pReuseFiles)
+                    {
+                        auto it = ctx.pReuseFiles->find(item.second);
+                        if (it!=ctx.pReuseFiles->end())
+                        {
+                            // Разбирать не нужно, но его подключения тоже надо просмотреть
+                            pending.emplace_back(&it->second);
+                            continue;
+                        }
+                    }
 
-        std::unordered_set<StringType> loadedProjects;
-        std::unordered_set<StringType> loadedNuts    ;
+                    wave.emplace_back(item.second);
+                }
+            }
 
-        for(const auto &prjFileName : projectFileNames)
-        {
-            err = readNutProjectImpl(prjFileName, prj, loadedProjects, loadedNuts);
-            if (err==ErrorCode::ok)
+            if (wave.empty())
             {
                 break;
             }
 
-            if ( err==ErrorCode::missingFiles  // не все файлы в проекте реально существуют
-              || err==ErrorCode::invalidFormat // проект есть, но ошибка формата/синтаксиса файла JSON/YAML
-              || err==ErrorCode::unknownFormat // проект есть, но ошибка формата, не JSON/YAML
-               )
+            std::vector< NutProjectFileT<StringType> > parsedFiles(wave.size());
+            std::vector<ErrorCode>                     errors(wave.size(), ErrorCode::ok);
+
+            loaderPool.parallelFor( wave.size()
+                                  , [&](std::size_t idx)
+                                    {
+                                        try
+                                        {
+                                            errors[idx] = parseNutProjectFileImpl(wave[idx], parsedFiles[idx], ctx.takeStamps, false /* reportErrors */);
+                                        }
+                                        catch(...)
+                                        {
+                                            errors[idx] = ErrorCode::genericError;
+                                        }
+                                    }
+                                  );
+
+            for(std::size_t i=0; i!=wave.size(); ++i)
             {
-                // Файл проекта есть, но там ошибка - отдельный nut файл не пытаемся читать - у нас есть файл проекта, просто там косяк
-                return err;
+                if (errors[i]!=ErrorCode::ok)
+                {
+                    continue;
+                }
+
+                auto res = ctx.localFiles.emplace(wave[i], std::move(parsedFiles[i]));
+                pending.emplace_back(&res.first->second); // Элементы unordered_map не перемещаются при вставке
             }
 
+            wave.clear();
         }
+    }
 
-        // if (err!=ErrorCode::ok)
-        // {
-        //     err = readNutProjectImpl(fullNameNut, prj, loadedProjects, loadedNuts);
-        // }
-
-        if (err!=ErrorCode::ok)
+    template<typename StringType>
+    ErrorCode readNutProjectImpl( const StringType                   &fileName
+                                , NutProjectT<StringType>            &prj
+                                , NutProjectParseContext<StringType> &ctx
+                                ) const
+    {
+        if (!fsIsFileExistAndReadable(fileName))
         {
-            return err;
+            return ErrorCode::notFound;
         }
 
-        return readNutProjectFilesImpl(prj);
-
-    }
-
-    // void updateNutManifestGraphics(nlohmann::json j)
-    // nlohmann::json
+        bool isProjectFile = true;
 
-    
+        NutType nutType = detectFileNutTypeImpl(fileName);
+        if (nutType!=NutType::dotNutProject)
+        {
+            isProjectFile = false;
+        }
 
-    // nlohmann::json::iterator findJsonAnyChild(nlohmann::json &j, const std::string &n1) const
-    // {
-    //     return j.find(n1.c_str());
-    // }
-    //  
-    // nlohmann::json::iterator findJsonAnyChild(nlohmann::json &j, const std::string &n1, const std::string &n2) const
-    // {
-    //     auto iter = j.find(n1.c_str());
-    //     if (iter==j.end())
-    //         iter = j.find(n2.c_str());
-    //     return iter;
-    // }
-    
-    bool getEnvironmentVariable(const std::string &name, std::string &val) const
-    {
-        return umba::env::getVar(name, val);
-    }
+        
+        //if (!umba::string_plus::ends_with(fileNameUpper, nutsJsonExt))
+        if (!isProjectFile)
+        {
+            // Читаем проект из единственного .nut файла
 
-    bool getAllEnvironmentVariables(std::vector<std::pair<std::string,std::string> > &lst) const
-    {
-        return umba::env::getEnvVarsList(lst);
-    }
+            if (!ctx.loadedNuts.insert(fileName).second)
+            {
+                return ErrorCode::ok; // уже есть такой
+            }
 
-    bool getEnvironmentVariable(const std::wstring &name, std::wstring &val) const
-    {
-        #if defined(WIN32) || defined(_WIN32)
+            prj.projectFileName = fileName ;
+            prj.nuts.emplace_back(fileName);
 
-            return umba::env::getVar(name, val);
+            return ErrorCode::ok;
+        }
+        else
+        {
+            // Файл проекта разбираем, только если он изменился с прошлого разбора
+            const NutProjectFileT<StringType> *pPrjFile = 0;
 
-        #else
+            if (ctx.pReuseFiles)
+            {
+                auto it = ctx.pReuseFiles->find(fileName);
+                if (it!=ctx.pReuseFiles->end())
+                {
+                    pPrjFile = &it->second;
+                }
+            }
 
-            std::string strVal;
-            if (!umba::env::getVar(encodeText(name), strVal))
+            if (!pPrjFile)
             {
-                return false;
+                auto it = ctx.localFiles.find(fileName);
+                if (it!=ctx.localFiles.end())
+                {
+                    pPrjFile = &it->second;
+                }
             }
 
-            val = decodeText<std::wstring>(strVal);
+            if (!pPrjFile)
+            {
+                NutProjectFileT<StringType> parsedFile;
+                ErrorCode err = parseNutProjectFileImpl(fileName, parsedFile, ctx.takeStamps);
+                if (err!=ErrorCode::ok)
+                {
+                    return err;
+                }
 
-            return true;
+                // Храним в контексте - на имена из файла ссылаются loadedProjects/loadedNuts
+                pPrjFile = &ctx.localFiles.emplace(fileName, std::move(parsedFile)).first->second;
+            }
 
-        #endif
-        
-    }
+            // Подключаемые файлы всего дерева разбираем заранее и параллельно, если задан пул загрузки
+            if (!ctx.includesPrefetched)
+            {
+                ctx.includesPrefetched = true;
 
-    bool getAllEnvironmentVariables(std::vector<std::pair<std::wstring,std::wstring> > &lst) const
-    {
-        #if defined(WIN32) || defined(_WIN32)
+                const std::shared_ptr<WorkerPool> pLoaderPool = getConfig()->pLoaderPool;
+                if (pLoaderPool)
+                {
+                    prefetchNutProjectIncludesImpl(*pPrjFile, ctx, *pLoaderPool);
+                }
+            }
 
-            return umba::env::getEnvVarsList(lst);
+            if (ctx.pParsedFiles)
+            {
+                (*ctx.pParsedFiles)[fileName] = *pPrjFile;
+            }
 
-        #else
+            ctx.loadedProjects.insert(fileName);
 
-            std::vector<std::pair<std::string,std::string> > strLst;
-            if (!umba::env::getEnvVarsList(strLst))
-            {
-                return false;
-            }
-
-            lst.clear();
-
-            for(const auto &p: strLst)
-            {
-                lst.emplace_back(std::make_pair(decodeText<std::wstring>(p.first),decodeText<std::wstring>(p.second)))
-            }
-
-            return true;
-
-        #endif
-        
-    }
-
-
-    template<typename StringType>
-    ErrorCode updateNutManifestImpl(const StringType &fileName, NutManifestT<StringType> &manifest) const
-    {
-        using marty_simplesquirrel::json_helpers::findJsonAnyChild;
-
-        //MARTY_ASSMAN_ARG_USED(fileName);
-        MARTY_ASSMAN_ARG_USED(manifest);
-
-        std::string maifestText;
-        ErrorCode err = m_pFs->readTextFile(fileName, maifestText);
-        if (err!=ErrorCode::ok)
-        {
-            return err;
-        }
-
-        try
-        {
-            manifest.manifestFileName = fileName;
-
-            auto jManifest = readGenericJsonFromUtfString(maifestText, fileName);
-
-            auto 
-            // jiter = jManifest.find("appGroup");
-            jiter = findJsonAnyChild(jManifest, "appGroup", "app-group");
-            if (jiter!=jManifest.end())
-            {
-                std::string strAppGroup = jiter->get<std::string>();
-                manifest.appGroup = filenameFromText<StringType>(strAppGroup);
-            }
-
-            // jiter = jManifest.find("graphicsMode");
-            jiter = findJsonAnyChild(jManifest, "graphicsMode", "graphics-mode");
-            if (jiter!=jManifest.end())
-            {
-                std::string strMode = jiter->get<std::string>();
-                auto newVal = enum_deserialize_NutManifestGraphicsMode(strMode, NutManifestGraphicsMode::invalid);
-                if (newVal!=NutManifestGraphicsMode::invalid)
-                {
-                    manifest.manifestGraphicsMode = newVal;
-                }
-            }
+            const std::size_t curPrjIdx = prj.projectFiles.size();
+            prj.projectFiles.emplace_back(fileName);
 
-            //jiter = jManifest.find("window");
-            jiter = findJsonAnyChild(jManifest, "window");
-            if (jiter!=jManifest.end())
+            for(const auto &item : pPrjFile->items)
             {
-                if (!jiter->is_object())
-                {
-                    throw std::runtime_error("'window' node is not an object");
-                }
-
-                auto jWindow = jiter.value();
-                //jiter = jWindow.find("title");
-                jiter = findJsonAnyChild(jWindow, "title");
-                if (jiter!=jWindow.end())
-                {
-                    std::string str = jiter->get<std::string>();
-                    manifest.window.title = decodeText<StringType>(str);
-                }
-
-                jiter = findJsonAnyChild(jWindow, "icon");
-                if (jiter!=jWindow.end())
-                {
-                    std::string str = jiter->get<std::string>();
-                    manifest.window.iconName = decodeText<StringType>(str);
-                }
-
-                jiter = findJsonAnyChild(jWindow, "allowMaximize", "allow-maximize");
-                if (jiter!=jWindow.end())
-                {
-                    manifest.window.allowMaximize = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jWindow, "allowMinimize", "allow-minimize");
-                if (jiter!=jWindow.end())
-                {
-                    manifest.window.allowMinimize = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jWindow, "allowResize", "allow-resize");
-                if (jiter!=jWindow.end())
-                {
-                    manifest.window.allowResize = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jWindow, "showTitle", "show-title");
-                if (jiter!=jWindow.end())
-                {
-                    manifest.window.showTitle = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jWindow, "showSysMenu", "show-sys-menu");
-                if (jiter!=jWindow.end())
-                {
-                    manifest.window.showSysMenu = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jWindow, "showStatusBar", "show-status-bar");
-                if (jiter!=jWindow.end())
-                {
-                    manifest.window.showStatusBar = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jWindow, "showClientEdge", "show-client-edge");
-                if (jiter!=jWindow.end())
+                if (item.first)
                 {
-                    manifest.window.showClientEdge = jiter->get<bool>();
-                }
+                    const StringType &incPrjFullName = item.second;
 
-
-                {
-                    static
-                    const std::unordered_map<std::string, NutManifestSizeUnits> unitsMap = 
-                    { {"unknown", NutManifestSizeUnits::unknown }
-                    , {"px", NutManifestSizeUnits::px }
-                    , {"pixel", NutManifestSizeUnits::px }
-                    , {"pixels", NutManifestSizeUnits::px }
-                    , {"dbu", NutManifestSizeUnits::dbu }
-                    , {"DialogBaseUnit", NutManifestSizeUnits::dbu }
-                    , {"DialogBaseUnits", NutManifestSizeUnits::dbu }
-                    , {"du", NutManifestSizeUnits::du }
-                    , {"dtu", NutManifestSizeUnits::du }
-                    , {"dialogTemplateUnit", NutManifestSizeUnits::du }
-                    , {"dialogTemplateUnits", NutManifestSizeUnits::du }
-                    , {"percent", NutManifestSizeUnits::percent }
-                    , {"percents", NutManifestSizeUnits::percent }
-                    , {"%", NutManifestSizeUnits::percent }
-                    };
-
-                    jiter = findJsonAnyChild(jWindow, "width");
-                    if (jiter!=jWindow.end())
+                    if (!ctx.loadedProjects.insert(incPrjFullName).second)
                     {
-                        std::string strWidth = jiter->get<std::string>();
-                        manifest.window.size.xSize = WindowSize::ValueWithUnits::fromString( strWidth 
-                                                                                           , unitsMap
-                                                                                           , NutManifestSizeUnits::px
-                                                                                           , true // ignore case
-                                                                                           );
+                        continue;
                     }
 
-                    jiter = findJsonAnyChild(jWindow, "height");
-                    if (jiter!=jWindow.end())
+                    NutProjectT<StringType> incPrj;
+                    ErrorCode err2 = readNutProjectImpl(incPrjFullName, incPrj, ctx);
+                    if (err2!=ErrorCode::ok)
                     {
-                        std::string strHeight = jiter->get<std::string>();
-                        manifest.window.size.ySize = WindowSize::ValueWithUnits::fromString( strHeight 
-                                                                                           , unitsMap
-                                                                                           , NutManifestSizeUnits::px
-                                                                                           , true // ignore case
-                                                                                           );
+                        return err2;
                     }
 
-                    jiter = findJsonAnyChild(jWindow, "minWidth", "min-width");
-                    if (jiter!=jWindow.end())
-                    {
-                        std::string strWidth = jiter->get<std::string>();
-                        manifest.window.sizeMin.xSize = WindowSize::ValueWithUnits::fromString( strWidth 
-                                                                                              , unitsMap
-                                                                                              , NutManifestSizeUnits::px
-                                                                                              , true // ignore case
-                                                                                              );
-                    }
+                    prj.nuts.insert(prj.nuts.end(), std::make_move_iterator(incPrj.nuts.begin()), std::make_move_iterator(incPrj.nuts.end()));
 
-                    jiter = findJsonAnyChild(jWindow, "minHeight", "min-height");
-                    if (jiter!=jWindow.end())
+                    if (!incPrj.projectFiles.empty()) // Подключили проект, а не отдельный nut
                     {
-                        std::string strHeight = jiter->get<std::string>();
-                        manifest.window.sizeMin.ySize = WindowSize::ValueWithUnits::fromString( strHeight 
-                                                                                              , unitsMap
-                                                                                              , NutManifestSizeUnits::px
-                                                                                              , true // ignore case
-                                                                                              );
-                    }
-
-                }
-
-            }
-
-
-            //jiter = jManifest.find("startup");
-            jiter = findJsonAnyChild(jManifest, "startup");
-            if (jiter!=jManifest.end())
-            {
-                if (!jiter->is_object())
-                {
-                    throw std::runtime_error("'startup' node is not an object");
-                }
-
-                auto jStartup = jiter.value();
-                //jiter = jStartup.find("runFullscreen");
-                jiter = findJsonAnyChild(jStartup, "runFullscreen", "run-fullscreen");
-                if (jiter!=jStartup.end())
-                {
-                    manifest.startupManifest.runFullscreen = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jStartup, "runMaximized", "run-maximized");
-                if (jiter!=jStartup.end())
-                {
-                    manifest.startupManifest.runMaximized = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jStartup, "centerWindow", "center-window");
-                if (jiter!=jStartup.end())
-                {
-                    manifest.startupManifest.centerWindow = jiter->get<bool>();
-                }
-
-            }
-
+                        const std::size_t incBaseIdx = prj.projectFiles.size();
 
+                        prj.projectIncludes.emplace_back(curPrjIdx, incBaseIdx);
+                        for(const auto &inc : incPrj.projectIncludes)
+                        {
+                            prj.projectIncludes.emplace_back(inc.first+incBaseIdx, inc.second+incBaseIdx);
+                        }
 
-            //jiter = jManifest.find("hotkeys");
-            jiter = findJsonAnyChild(jManifest, "hotkeys");
-            if (jiter!=jManifest.end())
-            {
-                if (!jiter->is_object())
-                {
-                    throw std::runtime_error("'hotkeys' node is not an object");
-                }
+                        prj.projectFiles.insert(prj.projectFiles.end(), std::make_move_iterator(incPrj.projectFiles.begin()), std::make_move_iterator(incPrj.projectFiles.end()));
+                    }
 
-                auto jHotkeys = jiter.value();
-                
-                //jiter = jHotkeys.find("allowReloadScript");
-                jiter = findJsonAnyChild(jHotkeys, "allowReloadScript", "allow-reload-script");
-                if (jiter!=jHotkeys.end())
-                {
-                    manifest.hotkeysManifest.allowReloadScript = jiter->get<bool>();
                 }
-
-                //jiter = jHotkeys.find("allowFullscreen");
-                jiter = findJsonAnyChild(jHotkeys, "allowFullscreen", "allow-fullscreen");
-                if (jiter!=jHotkeys.end())
+                else // single file
                 {
-                    manifest.hotkeysManifest.allowFullscreen = jiter->get<bool>();
-                }
-                
-            }
-
-    // bool getAllEnvironmentVariables(std::vector<std::pair<std::wstring,std::wstring> > &lst) const
-    // bool getEnvironmentVariable(const std::string &name, std::string &val) const
+                    const StringType &nutFile = item.second;
 
-            jiter = findJsonAnyChild(jManifest, "importEnvironmentVariables", "import-environment-variables");
-            if (jiter!=jManifest.end())
-            {
-                if (jiter->is_boolean())
-                {
-                    std::vector<std::pair<StringType,StringType> > lst;
-                    getAllEnvironmentVariables(lst);
-                    for(const auto &p: lst)
+                    if (!ctx.loadedNuts.insert(nutFile).second)
                     {
-                        manifest.envVars[p.first] = p.second;
-                    }
-                }
-                else if (jiter->is_array())
-                {
-                    auto jClearVariables = jiter.value();
-                    for (nlohmann::json::iterator jClrVarIt=jClearVariables.begin(); jClrVarIt!=jClearVariables.end(); ++jClrVarIt)
-                    {
-                        auto &jClrVar = jClrVarIt.value();
-                        auto strVal = jClrVar.get<std::string>();
-                        auto varName = decodeText<StringType>(strVal);
-                        StringType val;
-                        if (getEnvironmentVariable(varName, val))
-                        {
-                            manifest.envVars[varName] = val;
-                        }
+                        continue;
                     }
-                }
-                else
-                {
-                    throw std::runtime_error("'clearVariables' node is not an array nor boolean");
-                }
-            }
-
 
-            jiter = findJsonAnyChild(jManifest, "clearVariables", "clear-variables");
-            if (jiter!=jManifest.end())
-            {
-                if (jiter->is_boolean())
-                {
-                    manifest.envVars.clear();
-                }
-                else if (jiter->is_array())
-                {
-                    auto jClearVariables = jiter.value();
-                    for (nlohmann::json::iterator jClrVarIt=jClearVariables.begin(); jClrVarIt!=jClearVariables.end(); ++jClrVarIt)
+                    prj.nuts.emplace_back(nutFile);
+                    
+                    if (!fsIsFileExistAndReadable(prj.nuts.back()))
                     {
-                        auto &jClrVar = jClrVarIt.value();
-                        auto strVal = jClrVar.get<std::string>();
-                        manifest.envVars.erase(decodeText<StringType>(strVal));
+                        //umba::lout << "Missing file '" << m_pFs->encodeFilename(prj.nuts.back()) << "\n";
+                        umba::lout << "Missing file '" << m_pFs->encodeText(prj.nuts.back()) << "'\n";
+                        umba::gmesg("Missing file '" + m_pFs->encodeText(prj.nuts.back()) + "'");
+                        return ErrorCode::missingFiles;
                     }
                 }
-                else
-                {
-                    throw std::runtime_error("'clearVariables' node is not an array nor boolean");
-                }
-            }
-
-
-            jiter = jManifest.find("variables");
-            if (jiter!=jManifest.end())
-            {
-                if (!jiter->is_object())
-                {
-                    throw std::runtime_error("'variables' node is not an object");
-                }
-
-                auto jVariables = jiter.value();
-                for (auto& el : jVariables.items())
-                {
-                    std::string strKey = el.key();
-                    std::string strVal = el.value();
-
-                    manifest.envVars[decodeText<StringType>(strKey)] = decodeText<StringType>(strVal);
-                }
 
             }
 
-            //std::unordered_map<StringType, StringType>      envVars           ;
-
-            //jiter = jManifest.find("filesystem");
-            jiter = findJsonAnyChild(jManifest, "filesystem");
-            if (jiter!=jManifest.end())
-            {
-                if (!jiter->is_object())
-                {
-                    throw std::runtime_error("'filesystem' node is not an object");
-                }
-
-                auto jFilesystem = jiter.value();
-
-                //jiter = jFilesystem.find("mountLocalFilesystem");
-                jiter = findJsonAnyChild(jFilesystem, "mountLocalFilesystem", "mount-local-filesystem");
-                if (jiter!=jFilesystem.end())
-                {
-                    manifest.filesystemManifest.mountLocalFilesystem = jiter->get<bool>();
-                }
-
-                jiter = findJsonAnyChild(jFilesystem, "remountOnMediaChanges", "remount-on-media-changes");
-                if (jiter!=jFilesystem.end())
-                {
-                    manifest.filesystemManifest.remountOnMediaChanges = jiter->get<bool>();
-                }
-
-                //jiter = jFilesystem.find("mountHome");
-                jiter = findJsonAnyChild(jFilesystem, "mountHome", "mount-home");
-                if (jiter!=jFilesystem.end())
-                {
-                    manifest.filesystemManifest.mountHome = jiter->get<bool>();
-                }
-
-                //jiter = jFilesystem.find("homeMountPointName");
-                jiter = findJsonAnyChild(jFilesystem, "homeMountPointName", "home-mount-point-name");
-                if (jiter!=jFilesystem.end())
-                {
-                    auto str = jiter->get<std::string>();
-                    manifest.filesystemManifest.homeMountPointName = decodeText<StringType>(str);
-                }
-
-                //jiter = jFilesystem.find("homeMountTarget");
-                jiter = findJsonAnyChild(jFilesystem, "homeMountTarget", "home-mount-target");
-                if (jiter!=jFilesystem.end())
-                {
-                    auto str = jiter->get<std::string>();
-                    manifest.filesystemManifest.homeMountTarget = decodeText<StringType>(str);
-                }
-
-
-                //jiter = jFilesystem.find("mountTemp");
-                jiter = findJsonAnyChild(jFilesystem, "mountTemp", "mount-temp");
-                if (jiter!=jFilesystem.end())
-                {
-                    manifest.filesystemManifest.mountTemp = jiter->get<bool>();
-                }
-
-                //jiter = jFilesystem.find("tempMountPointName");
-                jiter = findJsonAnyChild(jFilesystem, "tempMountPointName", "temp-mount-point-name");
-                if (jiter!=jFilesystem.end())
-                {
-                    auto str = jiter->get<std::string>();
-                    manifest.filesystemManifest.tempMountPointName = decodeText<StringType>(str);
-                }
-
-                //jiter = jFilesystem.find("tempMountTarget");
-                jiter = findJsonAnyChild(jFilesystem, "tempMountTarget", "temp-mount-target");
-                if (jiter!=jFilesystem.end())
-                {
-                    auto str = jiter->get<std::string>();
-                    manifest.filesystemManifest.tempMountTarget = decodeText<StringType>(str);
-                }
-
+            prj.projectFileName = fileName;
+        
+            return ErrorCode::ok;
+        }
 
-                //jiter = jFilesystem.find("mountLogs");
-                jiter = findJsonAnyChild(jFilesystem, "mountLogs", "mount-logs");
-                if (jiter!=jFilesystem.end())
-                {
-                    manifest.filesystemManifest.mountLogs = jiter->get<bool>();
-                }
+    }
 
-                //jiter = jFilesystem.find("logsMountPointName");
-                jiter = findJsonAnyChild(jFilesystem, "logsMountPointName", "logs-mount-point-name");
-                if (jiter!=jFilesystem.end())
-                {
-                    auto str = jiter->get<std::string>();
-                    manifest.filesystemManifest.logsMountPointName = decodeText<StringType>(str);
-                }
+    template<typename StringType>
+    ErrorCode readNutProjectFilesParallelImpl(NutProjectT<StringType> &prj, WorkerPool &loaderPool) const
+    {
+        const std::size_t numNuts = prj.nuts.size();
 
-                //jiter = jFilesystem.find("logsMountTarget");
-                jiter = findJsonAnyChild(jFilesystem, "logsMountTarget", "logs-mount-target");
-                if (jiter!=jFilesystem.end())
-                {
-                    auto str = jiter->get<std::string>();
-                    manifest.filesystemManifest.logsMountTarget = decodeText<StringType>(str);
-                }
+        std::vector<StringType> texts(numNuts);
+        std::vector<ErrorCode>  errors(numNuts, ErrorCode::ok);
 
+        loaderPool.parallelFor( numNuts
+                              , [&](std::size_t idx)
+                                {
+                                    try
+                                    {
+                                        errors[idx] = fsReadTextFile(prj.nuts[idx], texts[idx]);
+                                    }
+                                    catch(...)
+                                    {
+                                        errors[idx] = ErrorCode::genericError;
+                                    }
+                                }
+                              );
 
-                //jiter = jFilesystem.find("clearExistingMountPoints");
-                jiter = findJsonAnyChild(jFilesystem, "clearExistingMountPoints", "clear-existing-mount-points");
-                if (jiter!=jFilesystem.end())
-                {
-                    bool bClear = jiter->get<bool>();
-                    if (bClear)
-                    {
-                        manifest.filesystemManifest.customMountPoints.clear();
-                    }
+        // Возвращаем ошибку первого по порядку файла, как и при последовательной загрузке
+        for(auto err : errors)
+        {
+            if (err!=ErrorCode::ok)
+            {
+                return err;
+            }
+        }
 
-                }
+        prj.nutsData.reserve(prj.nutsData.size()+numNuts);
+        prj.nutsData.insert(prj.nutsData.end(), std::make_move_iterator(texts.begin()), std::make_move_iterator(texts.end()));
 
-                //jiter = jFilesystem.find("mountPoints");
-                jiter = findJsonAnyChild(jFilesystem, "mountPoints", "mount-points");
-                if (jiter!=jFilesystem.end())
-                {
-                    //if (!jiter->is_object())
-                    if (!jiter->is_array())
-                    {
-                        //throw std::runtime_error("'filesystem/mountPoints' node is not an object");
-                        throw std::runtime_error("'filesystem/mountPoints' node is not an array");
-                    }
+        return ErrorCode::ok;
+    }
 
-                    auto jMountPoints = jiter.value();
-                    for (nlohmann::json::iterator jMp=jMountPoints.begin(); jMp!=jMountPoints.end(); ++jMp)
-                    {
-                        NutFilesystemManifestMountPointInfoT<StringType> mpi;
+    template<typename StringType>
+    ErrorCode readNutProjectFilesImpl(NutProjectT<StringType> &prj) const
+    {
+        // Держим пул, даже если его подменят во время загрузки
+        const std::shared_ptr<WorkerPool> pLoaderPool = getConfig()->pLoaderPool;
+        if (pLoaderPool && prj.nuts.size()>1)
+        {
+            return readNutProjectFilesParallelImpl(prj, *pLoaderPool);
+        }
 
-                        jiter = jMp->find("name");
-                        if (jiter==jMp->end())
-                        {
-                            throw std::runtime_error("'filesystem/mountPoints': mount point must contain 'name' string");
-                        }
-                        else
-                        {
-                            auto str = jiter->get<std::string>();
-                            mpi.mountPointName = decodeText<StringType>(str);
-                        }
+        prj.nutsData.reserve(prj.nutsData.size()+prj.nuts.size());
 
-                        jiter = jMp->find("target");
-                        if (jiter==jMp->end())
-                        {
-                            throw std::runtime_error("'filesystem/mountPoints': mount point must contain 'target' string");
-                        }
-                        else
-                        {
-                            auto str = jiter->get<std::string>();
-                            mpi.mountPointTargetPath = decodeText<StringType>(str);
-                        }
+        for(const auto &nutFile : prj.nuts)
+        {
+            StringType fileText;
+            ErrorCode err = fsReadTextFile(nutFile, fileText);
+            if (err!=ErrorCode::ok)
+            {
+                return err; // По идее, этого не должно происходить, файлы на доступность для чтения уже проверены
+            }
 
-                        manifest.filesystemManifest.customMountPoints.emplace_back(mpi);
+            prj.nutsData.emplace_back(std::move(fileText));
+        }
 
-                    }
+        return ErrorCode::ok;
 
-                }
+    }
 
-            // auto &jAppListNode = appListNodeIter.value();
-            // if (!jAppListNode.is_array())
-            // {
-            //     umba::gmesg("dotnut.app-selector.manifest.json", "'app-list' node is not an array");
-            //     return ErrorCode::invalidFormat;
-            // }
-            //  
-            // appSel.manifestItems.clear();
-            //  
-            // for (nlohmann::json::iterator jAppListItemsIt=jAppListNode.begin(); jAppListItemsIt!=jAppListNode.end(); ++jAppListItemsIt)
-            // {
-            //     // title/app-name
-            //     auto jAppNameIter = jAppListItemsIt->find("app-name");
-            //     if (jAppNameIter==jAppListItemsIt->end())
-            //     {
-            //         continue;
-            //     }
-            //  
-            //     try
-            //     {
-            //         std::string strAppName           = jAppNameIter->get<std::string>();
-            //         StringType  strAppNameStringType = filenameFromText<StringType>(strAppName);
-            //         if (strAppNameStringType.empty())
-            //         {
-            //             continue;
-            //         }
-            //  
-            //         std::string strAppTitle;
-            //         auto jAppTitleIter = jAppListItemsIt->find("title");
-            //         if (jAppTitleIter!=jAppListItemsIt->end())
-            //         {
-            //             strAppTitle = jAppTitleIter->get<std::string>();
-            //         }
-
-
-                //manifest.filesystemManifest
-                //NutFilesystemManifestT<StringType>   filesystemManifest;
-
-                // template<typename StringType>
-                // struct NutFilesystemManifestT
-                // {
-                //     bool       mountLocalFilesystem = true;
-                //  
-                //     bool       mountHome            = true;
-                //     StringType homeMountPointName   = umba::string_plus::make_string<StringType>("~Home");
-                //  
-                //     bool       mountTemp            = true;
-                //     StringType tempMountPointName   = umba::string_plus::make_string<StringType>("$Temp");
-                //  
-                //     bool       mountLogs            = true;
-                //     StringType logsMountPointName   = umba::string_plus::make_string<StringType>(".Logs");
-                //  
-                //     std::vector< NutFilesystemManifestMountPointInfoT<StringType> > customMountPoints;
-                //  
-                // }; // struct NutFilesystemManifestT
-
-                // template<typename StringType>
-                // struct NutFilesystemManifestMountPointInfoT
-                // {
-                //     StringType    mountPointName;
-                //     StringType    mountPointTargetPath;  // Мы сами можем определить, является ли таргет каталогом или файлом
-                //  
-                //     // static
-                //     // NutFilesystemManifestMountPointInfoT<StringType> fromJsonNode(nlohmann::json &j)
-                //     // {
-                //     //     NutFilesystemManifestMountPointInfoT<StringType>
-                //     // }
-                // };
+    template<typename StringType>
+    ErrorCode readAppSelectorManifestImpl(NutAppSelectorManifestT<StringType> &appSel) const
+    {
+        static StringType nutAppSelectorManifest = umba::string_plus::make_string<StringType>("dotnut.app-selector.manifest.json");
 
+        if (!fsIsFileExistAndReadable(nutAppSelectorManifest))
+        {
+            return ErrorCode::notFound;
+        }
 
-            }
+        std::string nutsJsonPrjText;
+        ErrorCode err = fsReadTextFile(nutAppSelectorManifest, nutsJsonPrjText);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
 
-#if 0
-            ///
+        try
+        {
+            auto jConf = readJsonFromUtfString(nutsJsonPrjText, nutAppSelectorManifest);
+    
             auto appListNodeIter = jConf.find("app-list");
             if (appListNodeIter==jConf.end())
             {
-                return ErrorCode::notFound;
+                umba::gmesg("dotnut.app-selector.manifest.json", "no 'app-list' node found");
+                return ErrorCode::invalidFormat;
+                //return ErrorCode::notFound;
             }
     
             auto &jAppListNode = appListNodeIter.value();
             if (!jAppListNode.is_array())
             {
+                umba::gmesg("dotnut.app-selector.manifest.json", "'app-list' node is not an array");
                 return ErrorCode::invalidFormat;
             }
     
@@ -1215,397 +1104,2260 @@ protected:
                     {
                         continue;
                     }
-
-
-            ///
-
-#endif
-
-
-
-        }
+    
+                    std::string strAppTitle;
+                    auto jAppTitleIter = jAppListItemsIt->find("title");
+                    if (jAppTitleIter!=jAppListItemsIt->end())
+                    {
+                        strAppTitle = jAppTitleIter->get<std::string>();
+                    }
+    
+                    StringType strAppTitleStringType = filenameFromText<StringType>(strAppTitle);
+                    if (strAppTitleStringType.empty())
+                    {
+                        strAppTitleStringType = strAppNameStringType;
+                    }
+    
+                    appSel.manifestItems.emplace_back(NutAppSelectorManifestItemT<StringType>{strAppTitleStringType, strAppNameStringType});
+                }
+                catch(const std::exception &e)
+                {
+                    MARTY_ASSMAN_ARG_USED(e);
+                }
+                catch(...)
+                {
+                }
+                
+            }
+    
+        }
         catch(const std::exception &e)
         {
-            umba::lout << "Failed to read manifest file: " << e.what() << "\n";
+            umba::lout << "Failed to read 'dotnut.app-selector.manifest.json': " << e.what() << "\n";
             umba::lout.flush();
-            umba::gmesg(fileName, std::string("Failed to read manifest file: ") + e.what());
+            //umba::gmesg("dotnut.app-selector.manifest.json", e.what());
+            umba::gmesg(e.what());
             return ErrorCode::invalidFormat;
         }
         catch(...)
         {
-            umba::lout << "Failed to read manifest file: " << "unknown error" << "\n";
+            umba::lout << "Failed to read 'dotnut.app-selector.manifest.json': " << "unknown error" << "\n";
             umba::lout.flush();
-            umba::gmesg(fileName, std::string("Failed to read manifest file: ") + "unknown error");
+            umba::gmesg("dotnut.app-selector.manifest.json", "unknown error");
+            //umba::gmesg(e.what());
+            return ErrorCode::invalidFormat;
+        }
+
+        return ErrorCode::ok;
+    }
+
+    // Бандл байткода лежит рядом с файлом проекта
+    template<typename StringType>
+    StringType getNutProjectBytecodeBundleName(const NutProjectT<StringType> &prj) const
+    {
+        return m_pFs->appendExt(prj.projectFileName, umba::string_plus::make_string<StringType>("nutbc"));
+    }
+
+    template<typename StringType>
+    ErrorCode readNutProjectBytecodeImpl(NutProjectT<StringType> &prj) const
+    {
+        prj.nutsBytecode.clear();
+        prj.nutsBytecode.resize(prj.nuts.size());
+
+        if (prj.nutsData.size()!=prj.nuts.size())
+        {
+            return ErrorCode::genericError; // Без исходников нельзя проверить актуальность байткода
+        }
+
+        // Записи ссылаются на данные бандла и живут вместе с проектом, а writeNutProjectBytecode заменяет
+        // этот же файл - поэтому бандл не отображается в память, а читается в буфер
+        DataView bundle;
+        ErrorCode err = readDataFileViewImpl(getNutProjectBytecodeBundleName(prj), bundle, false /* allowMapping */);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        std::unordered_map<StringType, NutBytecodeBundleEntry> entries;
+        if (!parseNutBytecodeBundle(bundle, entries))
+        {
             return ErrorCode::invalidFormat;
         }
 
+        for(std::size_t i=0; i!=prj.nuts.size(); ++i)
+        {
+            auto it = entries.find(prj.nuts[i]);
+            if (it==entries.end())
+            {
+                continue;
+            }
+
+            const NutBytecodeBundleEntry &entry  = it->second;
+            const NutSourceDigest         digest = getNutSourceDigest(prj.nutsData[i]);
+            if (entry.sourceSize!=digest.size || entry.sourceHash!=digest.hash)
+            {
+                continue; // Исходник изменился, байткод устарел
+            }
+
+            prj.nutsBytecode[i] = entry.bytecode;
+        }
+
+        return ErrorCode::ok;
+    }
+
+    template<typename StringType>
+    ErrorCode writeNutProjectBytecodeImpl(const NutProjectT<StringType> &prj) const
+    {
+        const StringType bundleName = getNutProjectBytecodeBundleName(prj);
+
+        std::string  nameInArchive;
+        std::wstring nativeBundleName;
+        if ( findPackedArchive(bundleName, nameInArchive) // Архив только для чтения
+          || !resolveNativeFilename(bundleName, nativeBundleName)
+           )
+        {
+            return ErrorCode::notSupported;
+        }
+
+        std::vector<std::uint8_t> data;
+        if (!serializeNutBytecodeBundle(prj, data))
+        {
+            return ErrorCode::genericError;
+        }
+
+        ErrorCode err = writeNativeBinaryFile(nativeBundleName, data);
+        if (err==ErrorCode::ok)
+        {
+            // Файл мог только что появиться - индекс точки монтирования о нём не знает
+            std::wstring subPath;
+            if (auto pIndex = findMountIndex(bundleName, subPath))
+            {
+                pIndex->markStale();
+            }
+        }
+
+        return err;
+    }
+
+    // Бандл байткода необязателен - его отсутствие или порча не является ошибкой загрузки проекта
+    template<typename StringType>
+    ErrorCode readNutProjectFilesAndBytecodeImpl(NutProjectT<StringType> &prj) const
+    {
+        {
+            MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "readNutProjectFiles");
+
+            ErrorCode err = readNutProjectFilesImpl(prj);
+            if (err!=ErrorCode::ok)
+            {
+                return err;
+            }
+        }
+
+        MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "readNutProjectBytecode");
+        readNutProjectBytecodeImpl(prj);
+
         return ErrorCode::ok;
+    }
+
+    template<typename StringType>
+    bool getFileStampImpl(const StringType &vfsFileName, FileStamp &stamp) const
+    {
+        const VfsFileLocation loc = locateVfsFile(vfsFileName);
+
+        // Для файлов из архива изменением считается любое изменение самого архива
+        std::string nameInArchive;
+        if (auto pArchive = findPackedArchive(loc, nameInArchive))
+        {
+            stamp = getNativeFileStamp(pArchive->getNativeFileName());
+            if (!pArchive->exists(nameInArchive))
+            {
+                stamp.exists = false;
+                stamp.size   = 0;
+            }
+
+            return true;
+        }
+
+        std::wstring nativeFileName;
+        if (!resolveNativeFilename(loc, nativeFileName))
+        {
+            return false;
+        }
+
+        stamp = getNativeFileStamp(nativeFileName);
+        if (stamp.exists)
+        {
+            m_dirListingCache.noteExisting(nativeFileName);
+        }
+
+        return true;
+    }
+
+    // Файл не изменился с момента получения отметки stamp. Если изменился - на диске что-то поменялось,
+    // и закэшированным спискам каталогов больше не доверяем (иначе новые файлы были бы не видны до их перепроверки).
+    // Индекс точки монтирования, не знающий о новом состоянии файла, помечается устаревшим до перестроения
+    template<typename StringType>
+    bool isFileStampCurrentImpl(const StringType &vfsFileName, const FileStamp &stamp) const
+    {
+        FileStamp curStamp;
+        bool      stampKnown = getFileStampImpl(vfsFileName, curStamp);
+        if (stampKnown && curStamp==stamp)
+        {
+            return true;
+        }
+
+        m_dirListingCache.clear();
+
+        std::wstring subPath;
+        auto pIndex = findMountIndex(vfsFileName, subPath);
+        if (pIndex && (!stampKnown || !pIndex->matchesStamp(subPath, curStamp)))
+        {
+            pIndex->markStale();
+        }
+
+        return false;
+    }
+
+    template<typename StringType>
+    std::wstring getProjectCacheFileName(const StringType &projectName) const
+    {
+        std::wstring cacheFileName = makeWideFilename(projectName);
+        if constexpr (sizeof(typename StringType::value_type)>1)
+        {
+            cacheFileName.append(L".w");
+        }
+        else
+        {
+            cacheFileName.append(L".a");
+        }
+
+        cacheFileName.append(L".nutprj-cache");
+
+        return umba::filename::appendPath(getConfig()->projectCacheDir, cacheFileName);
+    }
+
+    // Проект из кэша берётся, только если не изменился ни один файл, от которого зависит результат разбора
+    template<typename StringType>
+    bool loadNutProjectFromCache(const StringType &projectName, NutProjectT<StringType> &prj) const
+    {
+        std::vector<std::uint8_t> data;
+        if (readNativeBinaryFile(getProjectCacheFileName(projectName), data)!=ErrorCode::ok)
+        {
+            return false;
+        }
+
+        NutProjectCacheT<StringType> cache;
+        if (!deserializeNutProjectCache(data, cache) || cache.projectName!=projectName)
+        {
+            return false;
+        }
+
+        for(const auto &st : cache.stamps)
+        {
+            if (!isFileStampCurrentImpl(st.first, st.second))
+            {
+                return false;
+            }
+        }
+
+        prj.projectFileName = std::move(cache.project.projectFileName);
+        prj.nuts            = std::move(cache.project.nuts           );
+        prj.projectFiles    = std::move(cache.project.projectFiles   );
+        prj.projectIncludes = std::move(cache.project.projectIncludes);
+
+        return true;
+    }
+
+    // Кэшировать можно, только если все файлы лежат на локальном диске - иначе нечем проверить их актуальность.
+    // Для файлов проекта используются отметки, взятые при разборе (ctx.takeStamps) - до чтения файлов
+    template<typename StringType>
+    void storeNutProjectToCache( const StringType                         &projectName
+                               , const std::vector<StringType>            &probedFileNames
+                               , const NutProjectT<StringType>            &prj
+                               , const NutProjectParseContext<StringType> &ctx
+                               ) const
+    {
+        NutProjectCacheT<StringType> cache;
+        cache.projectName = projectName;
+
+        auto addStamps = [&](const std::vector<StringType> &names)
+        {
+            for(const auto &name : names)
+            {
+                auto it = ctx.localFiles.find(name);
+                if (it!=ctx.localFiles.end() && it->second.stamp.exists)
+                {
+                    cache.stamps.emplace_back(name, it->second.stamp);
+                    continue;
+                }
+
+                FileStamp stamp;
+                if (!getFileStampImpl(name, stamp))
+                {
+                    return false;
+                }
+
+                cache.stamps.emplace_back(name, stamp);
+            }
+
+            return true;
+        };
+
+        if (!addStamps(probedFileNames) || !addStamps(prj.projectFiles) || !addStamps(prj.nuts))
+        {
+            return;
+        }
+
+        cache.project.projectFileName = prj.projectFileName;
+        cache.project.nuts            = prj.nuts           ;
+        cache.project.projectFiles    = prj.projectFiles   ;
+        cache.project.projectIncludes = prj.projectIncludes;
+
+        std::vector<std::uint8_t> data;
+        serializeNutProjectCache(cache, data);
+
+        // Не удалось записать кэш - не страшно, в следующий раз проект будет разобран заново
+        writeNativeBinaryFile(getProjectCacheFileName(projectName), data);
+    }
+
+    // Кандидаты в имя основного файла проекта, в порядке приоритета
+    template<typename StringType>
+    std::vector<StringType> getNutProjectFileCandidates(const StringType &projectName) const
+    {
+        StringType fullNameBase     = m_pFs->appendPath(umba::string_plus::make_string<StringType>("/nuts"), projectName);
         
+        std::vector<StringType> projectFileNames;
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.json"  )));
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.jsn"   )));
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutsjsnproj")));
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutjsnproj" )));
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.yaml"  )));
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nuts.yml"   )));
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutsymlproj")));
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nutymlproj" )));
+        projectFileNames.emplace_back(m_pFs->appendExt(fullNameBase, umba::string_plus::make_string<StringType>("nut"        )));
+
+        return projectFileNames;
     }
 
+    // Разбор проекта по первому подходящему кандидату. numProbedFiles - количество кандидатов, которые не подошли
     template<typename StringType>
-    ErrorCode updateNutManifestImpl(NutManifestT<StringType> &manifest) const
+    ErrorCode resolveNutProjectImpl( const std::vector<StringType>      &projectFileNames
+                                   , NutProjectT<StringType>            &prj
+                                   , NutProjectParseContext<StringType> &ctx
+                                   , std::size_t                        &numProbedFiles
+                                   ) const
     {
-        MARTY_ASSMAN_ARG_USED(manifest);
+        ErrorCode err = ErrorCode::notFound;
+
+        numProbedFiles = 0; // Кандидаты, которые не подошли - их появление изменит результат
+
+        for(const auto &prjFileName : projectFileNames)
+        {
+            err = readNutProjectImpl(prjFileName, prj, ctx);
+            if (err==ErrorCode::ok)
+            {
+                break;
+            }
+
+            ++numProbedFiles;
+
+            if ( err==ErrorCode::missingFiles  // не все файлы в проекте реально существуют
+              || err==ErrorCode::invalidFormat // проект есть, но ошибка формата/синтаксиса файла JSON/YAML
+              || err==ErrorCode::unknownFormat // проект есть, но ошибка формата, не JSON/YAML
+               )
+            {
+                // Файл проекта есть, но там ошибка - отдельный nut файл не пытаемся читать - у нас есть файл проекта, просто там косяк
+                return err;
+            }
+
+        }
+
+        return err;
+    }
+
+    template<typename StringType>
+    ErrorCode readNutProjectCompleteImpl(NutProjectT<StringType> &prj) const
+    {
+        MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "readNutProjectComplete");
+
+        StringType projectName;
+        ErrorCode err = getProjectName(projectName);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        std::vector<StringType> projectFileNames = getNutProjectFileCandidates(projectName);
+
+        const bool useProjectCache = !getConfig()->projectCacheDir.empty();
+
+        if (useProjectCache)
+        {
+            if (loadNutProjectFromCache(projectName, prj))
+            {
+                ApiCallScope::countCacheHit();
+                return readNutProjectFilesAndBytecodeImpl(prj);
+            }
+
+            ApiCallScope::countCacheMiss();
+        }
+
+        NutProjectParseContext<StringType> ctx;
+        ctx.takeStamps = useProjectCache;
+        std::size_t numProbedFiles = 0;
+
+        {
+            MARTY_ASSMAN_PROFILE_SCOPE(resolveProfileScope, "resolveNutProject");
+
+            err = resolveNutProjectImpl(projectFileNames, prj, ctx, numProbedFiles);
+            if (err!=ErrorCode::ok)
+            {
+                return err;
+            }
+        }
+
+        if (useProjectCache)
+        {
+            projectFileNames.resize(numProbedFiles);
+            storeNutProjectToCache(projectName, projectFileNames, prj, ctx);
+        }
+
+        return readNutProjectFilesAndBytecodeImpl(prj);
+
+    }
+
+    // Перезагрузка проекта с учётом отметок файлов из state. Файлы проектов перечитываются и разбираются,
+    // только если изменились они сами (или появился более приоритетный кандидат в основной файл проекта),
+    // nut-файлы перечитываются, только если изменились их отметки. Файлы, для которых отметку получить нельзя
+    // (не в локальной ФС), перечитываются всегда, а изменения nut-файлов определяются по хэшу текста.
+    // При ошибке state не меняется
+    template<typename StringType>
+    ErrorCode reloadNutProjectStateImpl(NutProjectStateT<StringType> &state, NutProjectChangesT<StringType> &changes) const
+    {
+        changes = NutProjectChangesT<StringType>();
+
+        StringType projectName;
+        ErrorCode err = getProjectName(projectName);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        auto isStampCurrent = [&](const StringType &name, const FileStamp &stamp)
+        {
+            return isFileStampCurrentImpl(name, stamp);
+        };
+
+        // Структура проекта не изменилась, если на месте все не подошедшие кандидаты и не изменился ни один файл проекта
+        bool structureValid = state.loaded;
+        for(std::size_t i=0; structureValid && i!=state.probedStamps.size(); ++i)
+        {
+            structureValid = isStampCurrent(state.probedStamps[i].first, state.probedStamps[i].second);
+        }
+
+        for(std::size_t i=0; structureValid && i!=state.parsedFiles.size(); ++i)
+        {
+            structureValid = state.parsedFiles[i].stamp.exists && isStampCurrent(state.parsedFiles[i].fileName, state.parsedFiles[i].stamp);
+        }
+
+        NutProjectStateT<StringType> newState;
+        newState.loaded = true;
+
+        if (structureValid)
+        {
+            newState.probedStamps            = state.probedStamps           ;
+            newState.parsedFiles             = state.parsedFiles            ;
+            newState.project.projectFileName = state.project.projectFileName;
+            newState.project.nuts            = state.project.nuts           ;
+            newState.project.projectFiles    = state.project.projectFiles   ;
+            newState.project.projectIncludes = state.project.projectIncludes;
+        }
+        else
+        {
+            std::unordered_map<StringType, NutProjectFileT<StringType> > reuseFiles;
+            std::unordered_map<StringType, NutProjectFileT<StringType> > parsedFiles;
+
+            for(const auto &prjFile : state.parsedFiles)
+            {
+                if (prjFile.stamp.exists && isStampCurrent(prjFile.fileName, prjFile.stamp))
+                {
+                    reuseFiles[prjFile.fileName] = prjFile;
+                }
+            }
+
+            NutProjectParseContext<StringType> ctx;
+            ctx.pReuseFiles  = &reuseFiles ;
+            ctx.pParsedFiles = &parsedFiles;
+            ctx.takeStamps   = true;
+
+            std::vector<StringType> projectFileNames = getNutProjectFileCandidates(projectName);
+            std::size_t numProbedFiles = 0;
+
+            err = resolveNutProjectImpl(projectFileNames, newState.project, ctx, numProbedFiles);
+            if (err!=ErrorCode::ok)
+            {
+                return err;
+            }
+
+            for(std::size_t i=0; i!=numProbedFiles; ++i)
+            {
+                FileStamp stamp;
+                getFileStampImpl(projectFileNames[i], stamp);
+                newState.probedStamps.emplace_back(projectFileNames[i], stamp);
+            }
+
+            for(const auto &prjFileName : newState.project.projectFiles)
+            {
+                newState.parsedFiles.emplace_back(parsedFiles[prjFileName]);
+                if (reuseFiles.find(prjFileName)==reuseFiles.end())
+                {
+                    changes.reparsedProjectFiles.emplace_back(prjFileName);
+                }
+            }
+        }
+
+        // Прежние nut-файлы по именам
+        std::unordered_map<StringType, std::size_t> oldNutIndices;
+        for(std::size_t i=0; i!=state.project.nuts.size(); ++i)
+        {
+            oldNutIndices[state.project.nuts[i]] = i;
+        }
+
+        NutProjectT<StringType> &prj = newState.project;
+        const std::size_t numNuts = prj.nuts.size();
+
+        prj.nutsData    .resize(numNuts);
+        prj.nutsBytecode.resize(numNuts);
+        newState.nutStamps.resize(numNuts);
+        newState.nutHashes.resize(numNuts);
+
+        std::vector<std::size_t> oldIdx(numNuts, (std::size_t)-1);
+
+        // Отметки берём до чтения, а перечитываем разом - так чтение идёт параллельно, если есть пул загрузчиков
+        NutProjectT<StringType>  readPrj;
+        std::vector<std::size_t> readIdx;
+
+        for(std::size_t i=0; i!=numNuts; ++i)
+        {
+            bool stampKnown = getFileStampImpl(prj.nuts[i], newState.nutStamps[i]);
+            if (!stampKnown)
+            {
+                newState.nutStamps[i] = FileStamp();
+            }
+
+            auto it = oldNutIndices.find(prj.nuts[i]);
+            if (it!=oldNutIndices.end())
+            {
+                oldIdx[i] = it->second;
+
+                if ( stampKnown && newState.nutStamps[i].exists
+                  && it->second<state.nutStamps.size() && newState.nutStamps[i]==state.nutStamps[it->second]
+                  && it->second<state.nutHashes.size() && it->second<state.project.nutsData.size()
+                   )
+                {
+                    prj.nutsData    [i]   = state.project.nutsData[it->second];
+                    newState.nutHashes[i] = state.nutHashes[it->second];
+                    if (it->second<state.project.nutsBytecode.size())
+                    {
+                        prj.nutsBytecode[i] = state.project.nutsBytecode[it->second];
+                    }
+
+                    continue;
+                }
+            }
+
+            readPrj.nuts.emplace_back(prj.nuts[i]);
+            readIdx.emplace_back(i);
+        }
+
+        err = readNutProjectFilesImpl(readPrj);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        for(std::size_t k=0; k!=readIdx.size(); ++k)
+        {
+            const std::size_t i = readIdx[k];
+
+            prj.nutsData[i]       = std::move(readPrj.nutsData[k]);
+            newState.nutHashes[i] = hashStringFnv1a64(prj.nutsData[i]);
+
+            if ( oldIdx[i]!=(std::size_t)-1
+              && oldIdx[i]<state.nutHashes.size() && newState.nutHashes[i]==state.nutHashes[oldIdx[i]]
+              && oldIdx[i]<state.project.nutsData.size() && prj.nutsData[i]==state.project.nutsData[oldIdx[i]]
+               )
+            {
+                // Отметка изменилась, а текст - нет
+                if (oldIdx[i]<state.project.nutsBytecode.size())
+                {
+                    prj.nutsBytecode[i] = state.project.nutsBytecode[oldIdx[i]];
+                }
+
+                continue;
+            }
+
+            changes.changedNuts.emplace_back(i);
+        }
+
+        std::sort(changes.changedNuts.begin(), changes.changedNuts.end());
+
+        changes.nutsListChanged = prj.nuts!=state.project.nuts;
+        if (changes.nutsListChanged)
+        {
+            std::unordered_set<StringType> newNuts(prj.nuts.begin(), prj.nuts.end());
+            for(const auto &nut : state.project.nuts)
+            {
+                if (newNuts.find(nut)==newNuts.end())
+                {
+                    changes.removedNuts.emplace_back(nut);
+                }
+            }
+        }
+
+        if (!state.loaded)
+        {
+            // Первая загрузка - байткод берём из бандла, дальше у изменившихся файлов он просто сбрасывается
+            readNutProjectBytecodeImpl(prj);
+        }
+
+        state = std::move(newState);
+
+        return ErrorCode::ok;
+    }
+
+    // void updateNutManifestGraphics(nlohmann::json j)
+    // nlohmann::json
+
+    
+
+    // nlohmann::json::iterator findJsonAnyChild(nlohmann::json &j, const std::string &n1) const
+    // {
+    //     return j.find(n1.c_str());
+    // }
+    //  
+    // nlohmann::json::iterator findJsonAnyChild(nlohmann::json &j, const std::string &n1, const std::string &n2) const
+    // {
+    //     auto iter = j.find(n1.c_str());
+    //     if (iter==j.end())
+    //         iter = j.find(n2.c_str());
+    //     return iter;
+    // }
+    
+    bool getEnvironmentVariable(const std::string &name, std::string &val) const
+    {
+        return umba::env::getVar(name, val);
+    }
+
+    bool getAllEnvironmentVariables(std::vector<std::pair<std::string,std::string> > &lst) const
+    {
+        return umba::env::getEnvVarsList(lst);
+    }
+
+    bool getEnvironmentVariable(const std::wstring &name, std::wstring &val) const
+    {
+        #if defined(WIN32) || defined(_WIN32)
+
+            return umba::env::getVar(name, val);
+
+        #else
+
+            std::string strVal;
+            if (!umba::env::getVar(encodeText(name), strVal))
+            {
+                return false;
+            }
+
+            val = decodeText<std::wstring>(strVal);
+
+            return true;
+
+        #endif
+        
+    }
+
+    bool getAllEnvironmentVariables(std::vector<std::pair<std::wstring,std::wstring> > &lst) const
+    {
+        #if defined(WIN32) || defined(_WIN32)
+
+            return umba::env::getEnvVarsList(lst);
+
+        #else
+
+            std::vector<std::pair<std::string,std::string> > strLst;
+            if (!umba::env::getEnvVarsList(strLst))
+            {
+                return false;
+            }
+
+            lst.clear();
+
+            for(const auto &p: strLst)
+            {
+                lst.emplace_back(std::make_pair(decodeText<std::wstring>(p.first),decodeText<std::wstring>(p.second)));
+            }
+
+            return true;
+
+        #endif
+        
+    }
+
+
+    // Разбор манифеста по таблицам полей (json_schema.h). Каждый объект JSON проходится один раз,
+    // поддеревья не копируются; оба написания ключа (camelCase и kebab-case) - в таблице
+
+    template<typename ObjectType>
+    using ManifestSchema = JsonSchemaT<AssetsManager, ObjectType>;
+
+    template<typename ObjectType>
+    using ManifestField  = JsonFieldT<AssetsManager, ObjectType>;
+
+    template<typename ObjectType>
+    static ManifestField<ObjectType> manifestBoolField(const char *name, const char *altName, bool ObjectType::*pMember)
+    {
+        return ManifestField<ObjectType>{ name, altName
+                                        , [pMember](const AssetsManager &, const nlohmann::json &j, ObjectType &obj)
+                                          {
+                                              obj.*pMember = j.get<bool>();
+                                          }
+                                        };
+    }
+
+    template<typename ObjectType, typename StringType>
+    static ManifestField<ObjectType> manifestTextField(const char *name, const char *altName, StringType ObjectType::*pMember)
+    {
+        return ManifestField<ObjectType>{ name, altName
+                                        , [pMember](const AssetsManager &am, const nlohmann::json &j, ObjectType &obj)
+                                          {
+                                              obj.*pMember = am.decodeText<StringType>(j.get<std::string>());
+                                          }
+                                        };
+    }
+
+    template<typename ObjectType>
+    static ManifestField<ObjectType> manifestSizeField(const char *name, const char *altName, WindowSize ObjectType::*pSize, WindowSize::ValueWithUnits WindowSize::*pMember)
+    {
+        return ManifestField<ObjectType>{ name, altName
+                                        , [pSize, pMember](const AssetsManager &, const nlohmann::json &j, ObjectType &obj)
+                                          {
+                                              static
+                                              const std::unordered_map<std::string, NutManifestSizeUnits> unitsMap = 
+                                              { {"unknown", NutManifestSizeUnits::unknown }
+                                              , {"px", NutManifestSizeUnits::px }
+                                              , {"pixel", NutManifestSizeUnits::px }
+                                              , {"pixels", NutManifestSizeUnits::px }
+                                              , {"dbu", NutManifestSizeUnits::dbu }
+                                              , {"DialogBaseUnit", NutManifestSizeUnits::dbu }
+                                              , {"DialogBaseUnits", NutManifestSizeUnits::dbu }
+                                              , {"du", NutManifestSizeUnits::du }
+                                              , {"dtu", NutManifestSizeUnits::du }
+                                              , {"dialogTemplateUnit", NutManifestSizeUnits::du }
+                                              , {"dialogTemplateUnits", NutManifestSizeUnits::du }
+                                              , {"percent", NutManifestSizeUnits::percent }
+                                              , {"percents", NutManifestSizeUnits::percent }
+                                              , {"%", NutManifestSizeUnits::percent }
+                                              };
+
+                                              (obj.*pSize).*pMember = WindowSize::ValueWithUnits::fromString( j.get<std::string>()
+                                                                                                            , unitsMap
+                                                                                                            , NutManifestSizeUnits::px
+                                                                                                            , true // ignore case
+                                                                                                            );
+                                          }
+                                        };
+    }
+
+    // Вложенный объект, разбираемый по своей схеме
+    template<typename ObjectType, typename MemberType>
+    static ManifestField<ObjectType> manifestObjectField(const char *name, MemberType ObjectType::*pMember, const ManifestSchema<MemberType> &schema)
+    {
+        const ManifestSchema<MemberType> *pSchema = &schema;
+
+        return ManifestField<ObjectType>{ name, 0
+                                        , [name, pMember, pSchema](const AssetsManager &am, const nlohmann::json &j, ObjectType &obj)
+                                          {
+                                              if (!j.is_object())
+                                              {
+                                                  throw std::runtime_error(std::string("'") + name + "' node is not an object");
+                                              }
+
+                                              pSchema->apply(am, j, obj.*pMember);
+                                          }
+                                        };
+    }
+
+    template<typename StringType>
+    static const ManifestSchema< NutWindowManifestT<StringType> >& getNutWindowManifestSchema()
+    {
+        typedef NutWindowManifestT<StringType> Obj;
+
+        static const ManifestSchema<Obj> schema =
+        { manifestTextField("title"         , 0                 , &Obj::title         )
+        , manifestTextField("icon"          , 0                 , &Obj::iconName      )
+        , manifestBoolField("allowMaximize" , "allow-maximize"  , &Obj::allowMaximize )
+        , manifestBoolField("allowMinimize" , "allow-minimize"  , &Obj::allowMinimize )
+        , manifestBoolField("allowResize"   , "allow-resize"    , &Obj::allowResize   )
+        , manifestBoolField("showTitle"     , "show-title"      , &Obj::showTitle     )
+        , manifestBoolField("showSysMenu"   , "show-sys-menu"   , &Obj::showSysMenu   )
+        , manifestBoolField("showStatusBar" , "show-status-bar" , &Obj::showStatusBar )
+        , manifestBoolField("showClientEdge", "show-client-edge", &Obj::showClientEdge)
+        , manifestSizeField("width"         , 0                 , &Obj::size   , &WindowSize::xSize)
+        , manifestSizeField("height"        , 0                 , &Obj::size   , &WindowSize::ySize)
+        , manifestSizeField("minWidth"      , "min-width"       , &Obj::sizeMin, &WindowSize::xSize)
+        , manifestSizeField("minHeight"     , "min-height"      , &Obj::sizeMin, &WindowSize::ySize)
+        };
+
+        return schema;
+    }
+
+    static const ManifestSchema<NutStartupManifest>& getNutStartupManifestSchema()
+    {
+        typedef NutStartupManifest Obj;
+
+        static const ManifestSchema<Obj> schema =
+        { manifestBoolField("runFullscreen", "run-fullscreen", &Obj::runFullscreen)
+        , manifestBoolField("runMaximized" , "run-maximized" , &Obj::runMaximized )
+        , manifestBoolField("centerWindow" , "center-window" , &Obj::centerWindow )
+        };
+
+        return schema;
+    }
+
+    static const ManifestSchema<NutHotkeysManifest>& getNutHotkeysManifestSchema()
+    {
+        typedef NutHotkeysManifest Obj;
+
+        static const ManifestSchema<Obj> schema =
+        { manifestBoolField("allowReloadScript", "allow-reload-script", &Obj::allowReloadScript)
+        , manifestBoolField("allowFullscreen"  , "allow-fullscreen"   , &Obj::allowFullscreen  )
+        };
+
+        return schema;
+    }
+
+    template<typename StringType>
+    static const ManifestSchema< NutFilesystemManifestT<StringType> >& getNutFilesystemManifestSchema()
+    {
+        typedef NutFilesystemManifestT<StringType> Obj;
+
+        // Порядок важен: clearExistingMountPoints обрабатывается до mountPoints
+        static const ManifestSchema<Obj> schema =
+        { manifestBoolField("mountLocalFilesystem" , "mount-local-filesystem"  , &Obj::mountLocalFilesystem )
+        , manifestBoolField("remountOnMediaChanges", "remount-on-media-changes", &Obj::remountOnMediaChanges)
+        , manifestBoolField("mountHome"            , "mount-home"              , &Obj::mountHome            )
+        , manifestTextField("homeMountPointName"   , "home-mount-point-name"   , &Obj::homeMountPointName   )
+        , manifestTextField("homeMountTarget"      , "home-mount-target"       , &Obj::homeMountTarget      )
+        , manifestBoolField("mountTemp"            , "mount-temp"              , &Obj::mountTemp            )
+        , manifestTextField("tempMountPointName"   , "temp-mount-point-name"   , &Obj::tempMountPointName   )
+        , manifestTextField("tempMountTarget"      , "temp-mount-target"       , &Obj::tempMountTarget      )
+        , manifestBoolField("mountLogs"            , "mount-logs"              , &Obj::mountLogs            )
+        , manifestTextField("logsMountPointName"   , "logs-mount-point-name"   , &Obj::logsMountPointName   )
+        , manifestTextField("logsMountTarget"      , "logs-mount-target"       , &Obj::logsMountTarget      )
+        , ManifestField<Obj>{ "clearExistingMountPoints", "clear-existing-mount-points"
+                            , [](const AssetsManager &, const nlohmann::json &j, Obj &obj)
+                              {
+                                  if (j.get<bool>())
+                                  {
+                                      obj.customMountPoints.clear();
+                                  }
+                              }
+                            }
+        , ManifestField<Obj>{ "mountPoints", "mount-points"
+                            , [](const AssetsManager &am, const nlohmann::json &j, Obj &obj)
+                              {
+                                  if (!j.is_array())
+                                  {
+                                      throw std::runtime_error("'filesystem/mountPoints' node is not an array");
+                                  }
+
+                                  for(const auto &jMp : j)
+                                  {
+                                      NutFilesystemManifestMountPointInfoT<StringType> mpi;
+
+                                      auto jiter = jMp.find("name");
+                                      if (jiter==jMp.end())
+                                      {
+                                          throw std::runtime_error("'filesystem/mountPoints': mount point must contain 'name' string");
+                                      }
+
+                                      mpi.mountPointName = am.decodeText<StringType>(jiter->get<std::string>());
+
+                                      jiter = jMp.find("target");
+                                      if (jiter==jMp.end())
+                                      {
+                                          throw std::runtime_error("'filesystem/mountPoints': mount point must contain 'target' string");
+                                      }
+
+                                      mpi.mountPointTargetPath = am.decodeText<StringType>(jiter->get<std::string>());
+
+                                      obj.customMountPoints.emplace_back(std::move(mpi));
+                                  }
+                              }
+                            }
+        };
+
+        return schema;
+    }
+
+    template<typename StringType>
+    static const ManifestSchema< NutManifestT<StringType> >& getNutManifestSchema()
+    {
+        typedef NutManifestT<StringType> Obj;
+
+        // Порядок важен: переменные окружения сначала импортируются, потом очищаются, потом задаются
+        static const ManifestSchema<Obj> schema =
+        { ManifestField<Obj>{ "appGroup", "app-group"
+                            , [](const AssetsManager &am, const nlohmann::json &j, Obj &obj)
+                              {
+                                  obj.appGroup = am.filenameFromText<StringType>(j.get<std::string>());
+                              }
+                            }
+        , ManifestField<Obj>{ "graphicsMode", "graphics-mode"
+                            , [](const AssetsManager &, const nlohmann::json &j, Obj &obj)
+                              {
+                                  auto newVal = enum_deserialize_NutManifestGraphicsMode(j.get<std::string>(), NutManifestGraphicsMode::invalid);
+                                  if (newVal!=NutManifestGraphicsMode::invalid)
+                                  {
+                                      obj.manifestGraphicsMode = newVal;
+                                  }
+                              }
+                            }
+        , manifestObjectField("window" , &Obj::window         , getNutWindowManifestSchema<StringType>())
+        , manifestObjectField("startup", &Obj::startupManifest, getNutStartupManifestSchema())
+        , manifestObjectField("hotkeys", &Obj::hotkeysManifest, getNutHotkeysManifestSchema())
+        , ManifestField<Obj>{ "importEnvironmentVariables", "import-environment-variables"
+                            , [](const AssetsManager &am, const nlohmann::json &j, Obj &obj)
+                              {
+                                  if (j.is_boolean())
+                                  {
+                                      std::vector<std::pair<StringType,StringType> > lst;
+                                      am.getAllEnvironmentVariables(lst);
+                                      for(const auto &p: lst)
+                                      {
+                                          obj.envVars[p.first] = p.second;
+                                      }
+                                  }
+                                  else if (j.is_array())
+                                  {
+                                      for(const auto &jVar : j)
+                                      {
+                                          auto varName = am.decodeText<StringType>(jVar.get<std::string>());
+                                          StringType val;
+                                          if (am.getEnvironmentVariable(varName, val))
+                                          {
+                                              obj.envVars[varName] = val;
+                                          }
+                                      }
+                                  }
+                                  else
+                                  {
+                                      throw std::runtime_error("'clearVariables' node is not an array nor boolean");
+                                  }
+                              }
+                            }
+        , ManifestField<Obj>{ "clearVariables", "clear-variables"
+                            , [](const AssetsManager &am, const nlohmann::json &j, Obj &obj)
+                              {
+                                  if (j.is_boolean())
+                                  {
+                                      obj.envVars.clear();
+                                  }
+                                  else if (j.is_array())
+                                  {
+                                      for(const auto &jVar : j)
+                                      {
+                                          obj.envVars.erase(am.decodeText<StringType>(jVar.get<std::string>()));
+                                      }
+                                  }
+                                  else
+                                  {
+                                      throw std::runtime_error("'clearVariables' node is not an array nor boolean");
+                                  }
+                              }
+                            }
+        , ManifestField<Obj>{ "variables", 0
+                            , [](const AssetsManager &am, const nlohmann::json &j, Obj &obj)
+                              {
+                                  if (!j.is_object())
+                                  {
+                                      throw std::runtime_error("'variables' node is not an object");
+                                  }
+
+                                  for(auto it=j.begin(); it!=j.end(); ++it)
+                                  {
+                                      obj.envVars[am.decodeText<StringType>(it.key())] = am.decodeText<StringType>(it.value().get<std::string>());
+                                  }
+                              }
+                            }
+        , manifestObjectField("filesystem", &Obj::filesystemManifest, getNutFilesystemManifestSchema<StringType>())
+        };
+
+        return schema;
+    }
+
+    template<typename StringType>
+    ErrorCode updateNutManifestImpl(const StringType &fileName, NutManifestT<StringType> &manifest) const
+    {
+        MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "updateNutManifest");
+
+        std::string maifestText;
+        ErrorCode err = fsReadTextFile(fileName, maifestText);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        try
+        {
+            manifest.manifestFileName = fileName;
+
+            const nlohmann::json jManifest = readJsonFromUtfString(maifestText, fileName);
+            if (jManifest.is_object()) // Пустой манифест ничего не меняет
+            {
+                getNutManifestSchema<StringType>().apply(*this, jManifest, manifest);
+            }
+        }
+        catch(const std::exception &e)
+        {
+            umba::lout << "Failed to read manifest file: " << e.what() << "\n";
+            umba::lout.flush();
+            umba::gmesg(fileName, std::string("Failed to read manifest file: ") + e.what());
+            return ErrorCode::invalidFormat;
+        }
+        catch(...)
+        {
+            umba::lout << "Failed to read manifest file: " << "unknown error" << "\n";
+            umba::lout.flush();
+            umba::gmesg(fileName, std::string("Failed to read manifest file: ") + "unknown error");
+            return ErrorCode::invalidFormat;
+        }
+
+        return ErrorCode::ok;
+        
+    }
+
+    template<typename StringType>
+    ErrorCode updateNutManifestImpl(NutManifestT<StringType> &manifest) const
+    {
+        MARTY_ASSMAN_ARG_USED(manifest);
+
+        StringType appName;
+        ErrorCode err = getProjectName(appName);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        StringType appManifestBase = m_pFs->appendPath(umba::string_plus::make_string<StringType>("/manifests"), appName);
+
+        StringType jsonName = m_pFs->appendExt(appManifestBase, umba::string_plus::make_string<StringType>("dotnut-manifest.json"));
+        StringType yamlName = m_pFs->appendExt(appManifestBase, umba::string_plus::make_string<StringType>("dotnut-manifest.yaml"));
+
+        err = updateNutManifestImpl(jsonName, manifest);
+        if (err!=ErrorCode::ok)
+        {
+            err = updateNutManifestImpl(yamlName, manifest);
+        }
+
+        // manifests/
+        // test_simplesquirrel03.dotnut-manifest.json
+        //m_pFs
+
+        return err;
+    }
+
+
+#if 0
+
+enum class ErrorCode : std::uint32_t
+{
+    invalid              = (std::uint32_t)(-1),
+    unknown              = (std::uint32_t)(-1),
+    ok                   = 0x00,
+    genericError         = 0x01,
+    notFound             = 0x02,
+    notExist             = 0x03,
+    alreadyExist         = 0x04,
+    accessDenied         = 0x05,
+    invalidName          = 0x06,
+    notSupported         = 0x07,
+    invalidMountPoint    = 0x08,
+    invalidMountTarget   = 0x09,
+    notDirectory         = 0x0A,
+    invalidFormat        = 0x0B,
+    unknownFormat        = 0x0C,
+    missingFiles         = 0x0D
+
+}; // enum class ErrorCode : std::uint32_t
+
+#endif
+
+public:
+
+    AssetsManager(std::shared_ptr<marty_virtual_fs::IFileSystem> pFs)
+    : m_pFs(pFs)
+    , m_assetsCache(MARTY_ASSMAN_ASSETS_CACHE_DEFAULT_BUDGET)
+    , m_pConfig(std::make_shared<const Config>())
+    {}
+
+    // Асинхронные задачи обращаются к членам менеджера - пул разрушается (с выполнением всех поставленных
+    // задач) до них. Деструктор может выполняться и в потоке ввода-вывода, если последнюю ссылку на менеджер
+    // отпустил колбэк, - такой случай ~WorkerPool обрабатывает сам
+    ~AssetsManager()
+    {
+        std::shared_ptr<WorkerPool> pPool;
+
+        {
+            std::lock_guard<std::mutex> lock(m_asyncIoPoolMutex);
+            pPool.swap(m_pAsyncIoPool);
+        }
+
+        pPool.reset();
+    }
+
+
+    virtual NutType detectFileNutType(const std::string  &fname) const override
+    {
+        return detectFileNutTypeImpl(fname);
+    }
+
+    virtual NutType detectFileNutType(const std::wstring &fname) const override
+    {
+        return detectFileNutTypeImpl(fname);
+    }
+
+    virtual void detectFileNutTypes(const std::string_view  *pNames, std::size_t count, NutType *pTypes) const override
+    {
+        getNutTypeSuffixMatcher().match(pNames, count, pTypes);
+    }
+
+    virtual void detectFileNutTypes(const std::wstring_view *pNames, std::size_t count, NutType *pTypes) const override
+    {
+        getNutTypeSuffixMatcher().match(pNames, count, pTypes);
+    }
+    
+    
+    virtual ErrorCode setProjectName(const std::string  &projectName) override
+    {
+        return setProjectName(m_pFs->decodeFilename(projectName));
+    }
+
+    virtual ErrorCode setProjectName(const std::wstring &projectName) override
+    {
+        updateConfig([&](Config &cfg) { cfg.projectName = projectName; });
+        return ErrorCode::ok;
+    }
+
+
+    virtual ErrorCode setNativeMountPoint(const std::string  &mountPointName, const std::string  &nativePath) override
+    {
+        return setNativeMountPoint(m_pFs->decodeFilename(mountPointName), m_pFs->decodeFilename(nativePath));
+    }
+
+    virtual ErrorCode setNativeMountPoint(const std::wstring &mountPointName, const std::wstring &nativePath) override
+    {
+        if (mountPointName.empty() || nativePath.empty())
+        {
+            return ErrorCode::invalidName;
+        }
+
+        updateConfig([&](Config &cfg)
+                     {
+                         cfg.nativeMountPoints[mountPointName] = nativePath;
+                         cfg.mountIndexes.erase(mountPointName); // Индекс был построен для другого каталога
+                     }
+                    );
+        m_confJsonCache.clear();
+        return ErrorCode::ok;
+    }
+
+    virtual void clearNativeMountPoints() override
+    {
+        updateConfig([](Config &cfg)
+                     {
+                         cfg.nativeMountPoints.clear();
+                         cfg.mountIndexes.clear();
+                     }
+                    );
+        m_confJsonCache.clear();
+    }
+
+
+    virtual ErrorCode buildMountIndex(const std::string  &mountPointName) override
+    {
+        return buildMountIndex(m_pFs->decodeFilename(mountPointName));
+    }
+
+    virtual ErrorCode buildMountIndex(const std::wstring &mountPointName) override
+    {
+        std::wstring nativePath;
+        {
+            const ConfigPtr pConfig = getConfig();
+            auto it = pConfig->nativeMountPoints.find(mountPointName);
+            if (it==pConfig->nativeMountPoints.end())
+            {
+                return ErrorCode::invalidMountPoint;
+            }
+
+            nativePath = it->second;
+        }
+
+        // Каталог обходим без блокировки - читатели продолжают работать со старым индексом
+        auto pIndex = std::make_shared<MountIndex>();
+        ErrorCode err = pIndex->build(nativePath);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        updateConfig([&](Config &cfg)
+                     {
+                         // Точку монтирования могли перенастроить, пока строился индекс
+                         auto it = cfg.nativeMountPoints.find(mountPointName);
+                         if (it!=cfg.nativeMountPoints.end() && it->second==nativePath)
+                         {
+                             cfg.mountIndexes[mountPointName] = pIndex;
+                         }
+                     }
+                    );
+
+        return ErrorCode::ok;
+    }
+
+    virtual ErrorCode buildMountIndexes() override
+    {
+        std::vector<std::wstring> names;
+        {
+            const ConfigPtr pConfig = getConfig();
+            for(const auto &kv : pConfig->nativeMountPoints)
+            {
+                names.emplace_back(kv.first);
+            }
+        }
+
+        ErrorCode res = ErrorCode::ok;
+        for(const auto &name : names)
+        {
+            ErrorCode err = buildMountIndex(name);
+            if (err!=ErrorCode::ok && res==ErrorCode::ok)
+            {
+                res = err;
+            }
+        }
+
+        return res;
+    }
+
+    virtual void rebuildMountIndexes() override
+    {
+        std::vector<std::wstring> names;
+        {
+            const ConfigPtr pConfig = getConfig();
+            for(const auto &kv : pConfig->mountIndexes)
+            {
+                names.emplace_back(kv.first);
+            }
+        }
+
+        for(const auto &name : names)
+        {
+            if (buildMountIndex(name)!=ErrorCode::ok)
+            {
+                // Каталога больше нет - устаревший индекс не оставляем
+                updateConfig([&](Config &cfg) { cfg.mountIndexes.erase(name); });
+            }
+        }
+    }
+
+    virtual void dropMountIndexes() override
+    {
+        updateConfig([](Config &cfg) { cfg.mountIndexes.clear(); });
+    }
+
+    virtual std::shared_ptr<const MountIndex> getMountIndex(const std::string  &mountPointName) const override
+    {
+        return getMountIndex(m_pFs->decodeFilename(mountPointName));
+    }
+
+    virtual std::shared_ptr<const MountIndex> getMountIndex(const std::wstring &mountPointName) const override
+    {
+        const ConfigPtr pConfig = getConfig();
+        auto it = pConfig->mountIndexes.find(mountPointName);
+        if (it==pConfig->mountIndexes.end())
+        {
+            return 0;
+        }
+
+        return it->second;
+    }
+
+
+    virtual ErrorCode mountPackedArchive(const std::string  &mountPointName, const std::string  &nativeArchiveFileName) override
+    {
+        return mountPackedArchive(m_pFs->decodeFilename(mountPointName), m_pFs->decodeFilename(nativeArchiveFileName));
+    }
+
+    virtual ErrorCode mountPackedArchive(const std::wstring &mountPointName, const std::wstring &nativeArchiveFileName) override
+    {
+        if (mountPointName.empty() || nativeArchiveFileName.empty())
+        {
+            return ErrorCode::invalidName;
+        }
+
+        auto pArchive = std::make_shared<PackedArchive>();
+        ErrorCode err = pArchive->open(nativeArchiveFileName);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        updateConfig([&](Config &cfg) { cfg.packedMounts[mountPointName] = pArchive; });
+
+        // Содержимое точки монтирования сменилось
+        m_assetsCache.clear();
+        m_confJsonCache.clear();
+
+        return ErrorCode::ok;
+    }
+
+    virtual void unmountPackedArchives() override
+    {
+        updateConfig([](Config &cfg) { cfg.packedMounts.clear(); });
+        m_assetsCache.clear();
+        m_confJsonCache.clear();
+    }
+
+    virtual bool getNativeFileName(const std::string  &fileName, std::wstring &nativeFileName) const override
+    {
+        return getNativeFileNameImpl(fileName, nativeFileName);
+    }
+
+    virtual bool getNativeFileName(const std::wstring &fileName, std::wstring &nativeFileName) const override
+    {
+        return getNativeFileNameImpl(fileName, nativeFileName);
+    }
+
+
+    virtual ErrorCode getProjectName(std::string  &projectName) const override
+    {
+        const ConfigPtr pConfig = getConfig();
+        if (pConfig->projectName.empty())
+        {
+            projectName = "nutApplication";
+        }
+        else
+        {
+            projectName = m_pFs->encodeFilename(pConfig->projectName);
+        }
+
+        return ErrorCode::ok;
+    }
+
+    virtual ErrorCode getProjectName(std::wstring &projectName) const override
+    {
+        const ConfigPtr pConfig = getConfig();
+        if (pConfig->projectName.empty())
+        {
+            projectName = L"nutApplication";
+        }
+        else
+        {
+            projectName = pConfig->projectName;
+        }
+
+        return ErrorCode::ok;
+    }
+
+
+    virtual ErrorCode readNutProject(const std::string  &fileName, NutProjectA &prj) const override
+    {
+        NutProjectParseContext<std::string> ctx;
+        prj.clear();
+        return readNutProjectImpl(fileName, prj, ctx);
+    }
+
+    virtual ErrorCode readNutProject(const std::wstring &fileName, NutProjectW &prj) const override
+    {
+        NutProjectParseContext<std::wstring> ctx;
+        prj.clear();
+        return readNutProjectImpl(fileName, prj, ctx);
+    }
+
+
+    virtual ErrorCode readNutProjectFiles(NutProjectA &prj) const override
+    {
+        return readNutProjectFilesImpl(prj);
+    }
+
+    virtual ErrorCode readNutProjectFiles(NutProjectW &prj) const override
+    {
+        return readNutProjectFilesImpl(prj);
+    }
+
+    // Чтение проекта (из одного nut-файла или из файла проекта), а также всех nut-файлов
+    virtual ErrorCode readNutProjectComplete(NutProjectA &prj) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readNutProjectComplete);
+        return apiScope.done(readNutProjectCompleteImpl(prj));
+    }
+
+    virtual ErrorCode readNutProjectComplete(NutProjectW &prj) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readNutProjectComplete);
+        return apiScope.done(readNutProjectCompleteImpl(prj));
+    }
+
+    virtual ErrorCode readNutProjectState(NutProjectStateA &state) const override
+    {
+        NutProjectStateA   newState;
+        NutProjectChangesA changes;
+        ErrorCode err = reloadNutProjectStateImpl(newState, changes);
+        if (err==ErrorCode::ok)
+        {
+            state = std::move(newState);
+        }
+
+        return err;
+    }
+
+    virtual ErrorCode readNutProjectState(NutProjectStateW &state) const override
+    {
+        NutProjectStateW   newState;
+        NutProjectChangesW changes;
+        ErrorCode err = reloadNutProjectStateImpl(newState, changes);
+        if (err==ErrorCode::ok)
+        {
+            state = std::move(newState);
+        }
+
+        return err;
+    }
+
+    virtual ErrorCode reloadNutProjectState(NutProjectStateA &state, NutProjectChangesA &changes) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::reloadNutProjectState);
+        return apiScope.done(reloadNutProjectStateImpl(state, changes));
+    }
+
+    virtual ErrorCode reloadNutProjectState(NutProjectStateW &state, NutProjectChangesW &changes) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::reloadNutProjectState);
+        return apiScope.done(reloadNutProjectStateImpl(state, changes));
+    }
+
+    virtual ErrorCode readNutProjectBytecode(NutProjectA &prj) const override
+    {
+        return readNutProjectBytecodeImpl(prj);
+    }
+
+    virtual ErrorCode readNutProjectBytecode(NutProjectW &prj) const override
+    {
+        return readNutProjectBytecodeImpl(prj);
+    }
+
+    virtual ErrorCode writeNutProjectBytecode(const NutProjectA &prj) const override
+    {
+        return writeNutProjectBytecodeImpl(prj);
+    }
+
+    virtual ErrorCode writeNutProjectBytecode(const NutProjectW &prj) const override
+    {
+        return writeNutProjectBytecodeImpl(prj);
+    }
+
+    virtual ErrorCode setProjectCacheDirectory(const std::string  &nativePath) override
+    {
+        return setProjectCacheDirectory(m_pFs->decodeFilename(nativePath));
+    }
+
+    virtual ErrorCode setProjectCacheDirectory(const std::wstring &nativePath) override
+    {
+        updateConfig([&](Config &cfg) { cfg.projectCacheDir = nativePath; });
+        return ErrorCode::ok;
+    }
+
+    virtual void setLoaderThreadsCount(std::size_t numThreads) override
+    {
+        updateConfig( [&](Config &cfg)
+                      {
+                          if (numThreads==0)
+                          {
+                              cfg.pLoaderPool.reset();
+                          }
+                          else if (!cfg.pLoaderPool || cfg.pLoaderPool->getNumThreads()!=numThreads)
+                          {
+                              cfg.pLoaderPool = std::make_shared<WorkerPool>(numThreads);
+                          }
+                      }
+                    );
+    }
+
+    virtual std::size_t getLoaderThreadsCount() const override
+    {
+        const std::shared_ptr<WorkerPool> pLoaderPool = getConfig()->pLoaderPool;
+        return pLoaderPool ? pLoaderPool->getNumThreads() : 0u;
+    }
+
+    virtual void setSerializeFileSystemAccess(bool serialize) override
+    {
+        updateConfig([&](Config &cfg) { cfg.serializeFsAccess = serialize; });
+    }
+
+    virtual bool getSerializeFileSystemAccess() const override
+    {
+        return getConfig()->serializeFsAccess;
+    }
+
+    virtual ErrorCode readAppSelectorManifest(NutAppSelectorManifestA &appSel) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAppSelectorManifest);
+        return apiScope.done(readAppSelectorManifestImpl(appSel));
+    }
+
+    virtual ErrorCode readAppSelectorManifest(NutAppSelectorManifestW &appSel) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAppSelectorManifest);
+        return apiScope.done(readAppSelectorManifestImpl(appSel));
+    }
+
+    virtual ErrorCode updateNutManifest(const std::string  &fileName, NutManifestA &manifest) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::updateNutManifest);
+        return apiScope.done(updateNutManifestImpl(fileName, manifest));
+    }
+
+    virtual ErrorCode updateNutManifest(const std::wstring &fileName, NutManifestW &manifest) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::updateNutManifest);
+        return apiScope.done(updateNutManifestImpl(fileName, manifest));
+    }
+
+    virtual ErrorCode updateNutManifest(NutManifestA &manifest) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::updateNutManifest);
+        return apiScope.done(updateNutManifestImpl(manifest));
+    }
+
+    virtual ErrorCode updateNutManifest(NutManifestW &manifest) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::updateNutManifest);
+        return apiScope.done(updateNutManifestImpl(manifest));
+    }
+
+
+protected:
+
+    template<typename FileNameStringType, typename TextStringType>
+    ErrorCode readConfTextFileImpl(const FileNameStringType &fName, TextStringType &fText) const
+    {
+        FileNameStringType fullConfFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/conf")
+                               , fName
+                               );
+
+        return fsReadTextFile(fullConfFileName, fText);
+    }
+
+    template<typename FileNameStringType>
+    std::wstring makeConfJsonCacheKey(const FileNameStringType &fName) const
+    {
+        return makeWideFilename(m_pFs->normalizeFilename(m_pFs->appendPath(umba::string_plus::make_string<FileNameStringType>("/conf"), fName)));
+    }
+
+    template<typename FileNameStringType>
+    ErrorCode readConfJsonSharedImpl(const FileNameStringType &fName, SharedJson &j) const
+    {
+        FileNameStringType fullConfFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/conf")
+                               , fName
+                               );
+
+        std::wstring cacheKey = makeWideFilename(m_pFs->normalizeFilename(fullConfFileName));
+
+        // Отметку берём до чтения - если файл поменяют во время чтения, при следующем обращении он будет перечитан.
+        // Файлы, для которых отметку получить нельзя, не кэшируются
+        FileStamp stamp;
+        const bool useCache = getFileStampImpl(fullConfFileName, stamp) && stamp.exists;
+        if (useCache)
+        {
+            if (m_confJsonCache.find(cacheKey, stamp, j))
+            {
+                ApiCallScope::countCacheHit();
+                return ErrorCode::ok;
+            }
+        }
+        else
+        {
+            m_confJsonCache.addMiss();
+        }
+
+        ApiCallScope::countCacheMiss();
+
+        std::string text;
+        ErrorCode err = fsReadTextFile(fullConfFileName, text);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        try
+        {
+            j = std::make_shared<const nlohmann::json>(readJsonFromUtfString(text, fName));
+        }
+        catch(...)
+        {
+            return ErrorCode::invalidFormat;
+        }
+
+        if (useCache)
+        {
+            m_confJsonCache.insert(cacheKey, stamp, j);
+        }
+
+        return ErrorCode::ok;
+    }
+
+    template<typename FileNameStringType>
+    ErrorCode readConfDataFileImpl(const FileNameStringType &fName, std::vector<std::uint8_t> &fData) const
+    {
+        FileNameStringType fullConfFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/conf")
+                               , fName
+                               );
+
+        return fsReadDataFile(fullConfFileName, fData);
+    }
+
+    // Отметку берём до чтения - как и для конфигов (readConfJsonSharedImpl). Файлы, для которых отметку получить
+    // нельзя (доступные только через VFS - не с локального диска и не из архива), не кэшируются: иначе изменения
+    // на диске не были бы видны до clearAssetsCache. Возвращает false, если кэш для файла не используется
+    template<typename FileNameStringType>
+    bool findAssetsCacheEntry(const FileNameStringType &fullFileName, std::wstring &cacheKey, FileStamp &stamp, SharedDataBuffer &fData) const
+    {
+        if (!m_assetsCache.isEnabled())
+        {
+            return false;
+        }
+
+        if (!getFileStampImpl(fullFileName, stamp) || !stamp.exists)
+        {
+            ApiCallScope::countCacheMiss();
+            return false;
+        }
+
+        cacheKey = makeWideFilename(m_pFs->normalizeFilename(fullFileName));
+        if (m_assetsCache.find(cacheKey, stamp, fData))
+        {
+            ApiCallScope::countCacheHit();
+        }
+        else
+        {
+            ApiCallScope::countCacheMiss();
+        }
+
+        return true;
+    }
+
+    template<typename FileNameStringType>
+    ErrorCode readAssetsDataFileSharedImpl(const FileNameStringType &fName, SharedDataBuffer &fData) const
+    {
+        FileNameStringType fullFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/assets")
+                               , fName
+                               );
+
+        std::wstring cacheKey;
+        FileStamp    stamp;
+        fData.reset();
+        const bool useCache = findAssetsCacheEntry(fullFileName, cacheKey, stamp, fData);
+        if (fData)
+        {
+            return ErrorCode::ok;
+        }
+
+        auto pData = std::make_shared< std::vector<std::uint8_t> >();
+        ErrorCode err = fsReadDataFile(fullFileName, *pData);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        fData = pData;
+
+        if (useCache)
+        {
+            m_assetsCache.insert(cacheKey, stamp, fData);
+        }
+
+        return ErrorCode::ok;
+    }
+
+    template<typename FileNameStringType>
+    ErrorCode readAssetsDataFileImpl(const FileNameStringType &fName, std::vector<std::uint8_t> &fData) const
+    {
+        FileNameStringType fullFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/assets")
+                               , fName
+                               );
+
+        std::wstring     cacheKey;
+        FileStamp        stamp;
+        SharedDataBuffer pCached;
+        const bool useCache = findAssetsCacheEntry(fullFileName, cacheKey, stamp, pCached);
+        if (pCached)
+        {
+            fData.assign(pCached->begin(), pCached->end());
+            return ErrorCode::ok;
+        }
+
+        // Промах - читаем сразу в буфер вызывающего, копия делается только для кэша и только если она в него влезет
+        ErrorCode err = fsReadDataFile(fullFileName, fData);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        if (useCache && m_assetsCache.canFit(fData.size()))
+        {
+            m_assetsCache.insert(cacheKey, stamp, std::make_shared< std::vector<std::uint8_t> >(fData));
+        }
+
+        return ErrorCode::ok;
+    }
+
+
+    // Отдаёт файл прямо из упакованного архива или отображает его в память, если он лежит на локальном диске,
+    // иначе читает его через VFS. allowMapping=false - для файлов, которые мы сами же перезаписываем
+    // (живое отображение не даёт заменить файл под Windows), такие файлы читаются в буфер
+    template<typename FileNameStringType>
+    ErrorCode readDataFileViewImpl(const FileNameStringType &fullFileName, DataView &view, bool allowMapping=true) const
+    {
+        const VfsFileLocation loc = locateVfsFile(fullFileName);
+
+        std::string nameInArchive;
+        if (auto pArchive = findPackedArchive(loc, nameInArchive))
+        {
+            ErrorCode err = pArchive->readDataView(nameInArchive, view);
+            countReadBytes(err==ErrorCode::ok ? view.size : 0u);
+            return err;
+        }
+
+        bool indexedExists = true;
+        if (lookupMountIndex(loc, indexedExists) && !indexedExists)
+        {
+            return ErrorCode::notFound;
+        }
+
+        std::wstring nativeFileName;
+        if (resolveNativeFilename(loc, nativeFileName))
+        {
+            if (!allowMapping)
+            {
+                auto pData = std::make_shared< std::vector<std::uint8_t> >();
+                ErrorCode err = readNativeBinaryFile(nativeFileName, *pData);
+                if (err==ErrorCode::ok)
+                {
+                    view = makeDataView(pData);
+                }
+                countReadBytes(err==ErrorCode::ok ? view.size : 0u);
+                return err;
+            }
+
+            ErrorCode err = mapFileDataView(nativeFileName, view);
+            if (err!=ErrorCode::genericError)
+            {
+                countReadBytes(err==ErrorCode::ok ? view.size : 0u);
+                return err;
+            }
+
+            // Отобразить не удалось - пробуем прочитать обычным способом
+        }
+
+        auto pData = std::make_shared< std::vector<std::uint8_t> >();
+        ErrorCode err = fsReadDataFile(fullFileName, *pData);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        view = makeDataView(pData);
+
+        return ErrorCode::ok;
+    }
+
+    template<typename FileNameStringType>
+    ErrorCode readConfDataFileViewImpl(const FileNameStringType &fName, DataView &view) const
+    {
+        FileNameStringType fullConfFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/conf")
+                               , fName
+                               );
+
+        return readDataFileViewImpl(fullConfFileName, view);
+    }
+
+    template<typename FileNameStringType>
+    ErrorCode readAssetsDataFileViewImpl(const FileNameStringType &fName, DataView &view) const
+    {
+        FileNameStringType fullFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/assets")
+                               , fName
+                               );
+
+        const VfsFileLocation loc = locateVfsFile(fullFileName);
+
+        std::string  nameInArchive;
+        std::wstring nativeFileName;
+        if ( !findPackedArchive(loc, nameInArchive)
+          && !resolveNativeFilename(loc, nativeFileName)
+           )
+        {
+            // Не в архиве и не на локальном диске - читаем через кэш ассетов
+            SharedDataBuffer pData;
+            ErrorCode err = readAssetsDataFileSharedImpl(fName, pData);
+            if (err==ErrorCode::ok)
+            {
+                view = makeDataView(pData);
+            }
+
+            return err;
+        }
+
+        return readDataFileViewImpl(fullFileName, view);
+    }
+
+
+    // Имя файла иконки относительно /assets
+    template<typename FileNameStringType>
+    FileNameStringType makeIconResourceFileName(FileNameStringType iconName) const
+    {
+        if (iconName.empty())
+        {
+            iconName = umba::string_plus::make_string<FileNameStringType>("default_icon");
+        }
+
+        FileNameStringType iconExtUpper = umba::string_plus::toupper_copy(getExt(iconName));
+
+        FileNameStringType iconRootPath = umba::string_plus::make_string<FileNameStringType>("icons");
+
+        #if defined(WIN32) || defined(_WIN32)
+
+            iconRootPath = appendPath(iconRootPath, umba::string_plus::make_string<FileNameStringType>("windows"));
+
+            if (iconExtUpper.empty() || iconExtUpper!=umba::string_plus::make_string<FileNameStringType>("ICO"))
+            {
+                iconName = appendExt(iconName, umba::string_plus::make_string<FileNameStringType>("ico"));
+            }
+
+        #else
+
+            iconRootPath = appendPath(iconRootPath, umba::string_plus::make_string<FileNameStringType>("linux"));
+
+        #endif
 
-        StringType appName;
-        ErrorCode err = getProjectName(appName);
-        if (err!=ErrorCode::ok)
+        return appendPath(iconRootPath, iconName);
+    }
+
+    std::shared_ptr<WorkerPool> getAsyncIoPool() const
+    {
+        std::lock_guard<std::mutex> lock(m_asyncIoPoolMutex);
+        if (!m_pAsyncIoPool)
         {
-            return err;
+            m_pAsyncIoPool = std::make_shared<WorkerPool>(m_asyncIoThreadsCount);
         }
 
-        StringType appManifestBase = m_pFs->appendPath(umba::string_plus::make_string<StringType>("/manifests"), appName);
+        return m_pAsyncIoPool;
+    }
 
-        StringType jsonName = m_pFs->appendExt(appManifestBase, umba::string_plus::make_string<StringType>("dotnut-manifest.json"));
-        StringType yamlName = m_pFs->appendExt(appManifestBase, umba::string_plus::make_string<StringType>("dotnut-manifest.yaml"));
+    template<typename FileNameStringType>
+    AsyncDataFuture readAssetsDataFileAsyncImpl(AssetsApi api, const FileNameStringType &fName, AsyncDataCallback callback) const
+    {
+        FileNameStringType fullFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/assets")
+                               , fName
+                               );
 
-        err = updateNutManifestImpl(jsonName, manifest);
-        if (err!=ErrorCode::ok)
-        {
-            err = updateNutManifestImpl(yamlName, manifest);
-        }
+        // Статистика ведётся в потоке ввода-вывода, где идёт само чтение - ApiCallScope привязан к потоку.
+        // Объединённые запросы выполняются один раз и учитываются как один вызов
+        auto job = [this, api, fName]()
+                   {
+                       ApiCallScope apiScope(m_apiStats, api);
 
-        // manifests/
-        // test_simplesquirrel03.dotnut-manifest.json
-        //m_pFs
+                       AsyncDataResult res;
+                       try
+                       {
+                           res.errorCode = readAssetsDataFileSharedImpl(fName, res.data);
+                       }
+                       catch(...)
+                       {
+                           res.errorCode = ErrorCode::genericError;
+                       }
 
-        return err;
+                       apiScope.done(res.errorCode);
+                       return res;
+                   };
+
+        return m_asyncDataRequests.request( *getAsyncIoPool(), makeWideFilename(m_pFs->normalizeFilename(fullFileName))
+                                          , job, std::move(callback)
+                                          );
     }
 
+    template<typename FileNameStringType>
+    AsyncJsonFuture readConfJsonAsyncImpl(const FileNameStringType &fName, AsyncJsonCallback callback) const
+    {
+        FileNameStringType fullConfFileName
+            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/conf")
+                               , fName
+                               );
 
-#if 0
+        auto job = [this, fName]()
+                   {
+                       ApiCallScope apiScope(m_apiStats, AssetsApi::readConfJsonAsync);
 
-enum class ErrorCode : std::uint32_t
-{
-    invalid              = (std::uint32_t)(-1),
-    unknown              = (std::uint32_t)(-1),
-    ok                   = 0x00,
-    genericError         = 0x01,
-    notFound             = 0x02,
-    notExist             = 0x03,
-    alreadyExist         = 0x04,
-    accessDenied         = 0x05,
-    invalidName          = 0x06,
-    notSupported         = 0x07,
-    invalidMountPoint    = 0x08,
-    invalidMountTarget   = 0x09,
-    notDirectory         = 0x0A,
-    invalidFormat        = 0x0B,
-    unknownFormat        = 0x0C,
-    missingFiles         = 0x0D
+                       AsyncJsonResult res;
+                       try
+                       {
+                           res.errorCode = readConfJsonSharedImpl(fName, res.json);
+                       }
+                       catch(...)
+                       {
+                           res.errorCode = ErrorCode::invalidFormat;
+                       }
 
-}; // enum class ErrorCode : std::uint32_t
+                       apiScope.done(res.errorCode);
+                       return res;
+                   };
 
-#endif
+        return m_asyncJsonRequests.request( *getAsyncIoPool(), makeWideFilename(m_pFs->normalizeFilename(fullConfFileName))
+                                          , job, std::move(callback)
+                                          );
+    }
 
-public:
+    template<typename FileNameStringType>
+    ErrorCode readIconDataImpl(const FileNameStringType &iconName, std::vector<std::uint8_t> &iconData) const
+    {
+        return readAssetsDataFileImpl(makeIconResourceFileName(iconName), iconData);
+    }
 
-    AssetsManager(std::shared_ptr<marty_virtual_fs::IFileSystem> pFs)
-    : m_pFs(pFs)
-    {}
+    template<typename FileNameStringType>
+    ErrorCode readIconDataViewImpl(const FileNameStringType &iconName, DataView &view) const
+    {
+        return readAssetsDataFileViewImpl(makeIconResourceFileName(iconName), view);
+    }
 
 
-    virtual NutType detectFileNutType(const std::string  &fname) const override
+public:
+
+    // Тут автоматически работают перекодировки текста
+    virtual ErrorCode readConfTextFile(const std::string  &fName, std::string  &fText) const override
     {
-        return detectFileNutTypeImpl(fname);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfTextFile);
+        return apiScope.done(readConfTextFileImpl(fName, fText));
     }
 
-    virtual NutType detectFileNutType(const std::wstring &fname) const override
+    virtual ErrorCode readConfTextFile(const std::string  &fName, std::wstring &fText) const override
     {
-        return detectFileNutTypeImpl(fname);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfTextFile);
+        return apiScope.done(readConfTextFileImpl(fName, fText));
     }
-    
-    
-    virtual ErrorCode setProjectName(const std::string  &projectName) override
+
+    virtual ErrorCode readConfTextFile(const std::wstring &fName, std::string  &fText) const override
     {
-        m_projectName = m_pFs->decodeFilename(projectName);
-        return ErrorCode::ok;
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfTextFile);
+        return apiScope.done(readConfTextFileImpl(fName, fText));
     }
 
-    virtual ErrorCode setProjectName(const std::wstring &projectName) override
+    virtual ErrorCode readConfTextFile(const std::wstring &fName, std::wstring &fText) const override
     {
-        m_projectName = projectName;
-        return ErrorCode::ok;
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfTextFile);
+        return apiScope.done(readConfTextFileImpl(fName, fText));
     }
 
-
-    virtual ErrorCode getProjectName(std::string  &projectName) const override
+    virtual ErrorCode readConfJson(const std::string  &fName, nlohmann::json &j) const override
     {
-        if (m_projectName.empty())
-        {
-            projectName = "nutApplication";
-        }
-        else
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfJson);
+
+        SharedJson pJson;
+        ErrorCode err = readConfJsonSharedImpl(fName, pJson);
+        if (err==ErrorCode::ok)
         {
-            projectName = m_pFs->encodeFilename(m_projectName);
+            j = *pJson;
         }
 
-        return ErrorCode::ok;
+        return apiScope.done(err);
     }
 
-    virtual ErrorCode getProjectName(std::wstring &projectName) const override
+    virtual ErrorCode readConfJson(const std::wstring &fName, nlohmann::json &j) const override
     {
-        if (m_projectName.empty())
-        {
-            projectName = L"nutApplication";
-        }
-        else
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfJson);
+
+        SharedJson pJson;
+        ErrorCode err = readConfJsonSharedImpl(fName, pJson);
+        if (err==ErrorCode::ok)
         {
-            projectName = m_projectName;
+            j = *pJson;
         }
 
-        return ErrorCode::ok;
+        return apiScope.done(err);
     }
 
-
-    virtual ErrorCode readNutProject(const std::string  &fileName, NutProjectA &prj) const override
+    virtual ErrorCode readConfJsonShared(const std::string  &fName, SharedJson &j) const override
     {
-        std::unordered_set<std::string> loadedProjects;
-        std::unordered_set<std::string> loadedNuts;
-        prj.clear();
-        return readNutProjectImpl(fileName, prj, loadedProjects, loadedNuts);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfJsonShared);
+        return apiScope.done(readConfJsonSharedImpl(fName, j));
     }
 
-    virtual ErrorCode readNutProject(const std::wstring &fileName, NutProjectW &prj) const override
+    virtual ErrorCode readConfJsonShared(const std::wstring &fName, SharedJson &j) const override
     {
-        std::unordered_set<std::wstring> loadedProjects;
-        std::unordered_set<std::wstring> loadedNuts;
-        prj.clear();
-        return readNutProjectImpl(fileName, prj, loadedProjects, loadedNuts);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfJsonShared);
+        return apiScope.done(readConfJsonSharedImpl(fName, j));
     }
 
-
-    virtual ErrorCode readNutProjectFiles(NutProjectA &prj) const override
+    virtual void invalidateConfJson(const std::string  &fName) override
     {
-        return readNutProjectFilesImpl(prj);
+        m_confJsonCache.erase(makeConfJsonCacheKey(fName));
     }
 
-    virtual ErrorCode readNutProjectFiles(NutProjectW &prj) const override
+    virtual void invalidateConfJson(const std::wstring &fName) override
     {
-        return readNutProjectFilesImpl(prj);
+        m_confJsonCache.erase(makeConfJsonCacheKey(fName));
     }
 
-    // Чтение проекта (из одного nut-файла или из файла проекта), а также всех nut-файлов
-    virtual ErrorCode readNutProjectComplete(NutProjectA &prj) const override
+    virtual void clearConfJsonCache() override
     {
-        return readNutProjectCompleteImpl(prj);
+        m_confJsonCache.clear();
     }
 
-    virtual ErrorCode readNutProjectComplete(NutProjectW &prj) const override
+    virtual ConfJsonCacheStats getConfJsonCacheStats() const override
     {
-        return readNutProjectCompleteImpl(prj);
+        return m_confJsonCache.getStats();
     }
 
-    virtual ErrorCode readAppSelectorManifest(NutAppSelectorManifestA &appSel) const override
+    virtual void resetConfJsonCacheStats() override
     {
-        return readAppSelectorManifestImpl(appSel);
+        m_confJsonCache.resetStats();
     }
 
-    virtual ErrorCode readAppSelectorManifest(NutAppSelectorManifestW &appSel) const override
+    virtual void clearLookupCache() override
     {
-        return readAppSelectorManifestImpl(appSel);
+        m_dirListingCache.clear();
     }
 
-    virtual ErrorCode updateNutManifest(const std::string  &fileName, NutManifestA &manifest) const override
+    virtual ApiStats getApiStats(AssetsApi api) const override
     {
-        return updateNutManifestImpl(fileName, manifest);
+        return m_apiStats.getStats(api);
     }
 
-    virtual ErrorCode updateNutManifest(const std::wstring &fileName, NutManifestW &manifest) const override
+    virtual void resetApiStats() override
     {
-        return updateNutManifestImpl(fileName, manifest);
+        m_apiStats.reset();
     }
 
-    virtual ErrorCode updateNutManifest(NutManifestA &manifest) const override
+     
+    // Reading binary files
+    virtual ErrorCode readConfDataFile(const std::string  &fName, std::vector<std::uint8_t> &fData) const override
     {
-        return updateNutManifestImpl(manifest);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfDataFile);
+        return apiScope.done(readConfDataFileImpl(fName, fData));
     }
 
-    virtual ErrorCode updateNutManifest(NutManifestW &manifest) const override
+    virtual ErrorCode readConfDataFile(const std::wstring &fName, std::vector<std::uint8_t> &fData) const override
     {
-        return updateNutManifestImpl(manifest);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfDataFile);
+        return apiScope.done(readConfDataFileImpl(fName, fData));
     }
 
+    virtual ErrorCode readAssetsDataFile(const std::string  &fName, std::vector<std::uint8_t> &fData) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAssetsDataFile);
+        return apiScope.done(readAssetsDataFileImpl(fName, fData));
+    }
 
-protected:
-
-    template<typename FileNameStringType, typename TextStringType>
-    ErrorCode readConfTextFileImpl(const FileNameStringType &fName, TextStringType &fText) const
+    virtual ErrorCode readAssetsDataFile(const std::wstring &fName, std::vector<std::uint8_t> &fData) const override
     {
-        FileNameStringType fullConfFileName
-            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/conf")
-                               , fName
-                               );
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAssetsDataFile);
+        return apiScope.done(readAssetsDataFileImpl(fName, fData));
+    }
 
-        return m_pFs->readTextFile(fullConfFileName, fText);
+    virtual ErrorCode readAssetsDataFileShared(const std::string  &fName, SharedDataBuffer &fData) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAssetsDataFileShared);
+        return apiScope.done(readAssetsDataFileSharedImpl(fName, fData));
     }
 
-    template<typename FileNameStringType>
-    ErrorCode readConfDataFileImpl(const FileNameStringType &fName, std::vector<std::uint8_t> &fData) const
+    virtual ErrorCode readAssetsDataFileShared(const std::wstring &fName, SharedDataBuffer &fData) const override
     {
-        FileNameStringType fullConfFileName
-            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/conf")
-                               , fName
-                               );
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAssetsDataFileShared);
+        return apiScope.done(readAssetsDataFileSharedImpl(fName, fData));
+    }
 
-        return m_pFs->readDataFile(fullConfFileName, fData);
+    virtual void setAssetsCacheBudget(std::size_t budgetBytes) override
+    {
+        m_assetsCache.setBudget(budgetBytes);
     }
 
-    template<typename FileNameStringType>
-    ErrorCode readAssetsDataFileImpl(const FileNameStringType &fName, std::vector<std::uint8_t> &fData) const
+    virtual std::size_t getAssetsCacheBudget() const override
     {
-        FileNameStringType fullFileName
-            = m_pFs->appendPath( umba::string_plus::make_string<FileNameStringType>("/assets")
-                               , fName
-                               );
+        return m_assetsCache.getBudget();
+    }
 
-        return m_pFs->readDataFile(fullFileName, fData);
+    virtual void clearAssetsCache() override
+    {
+        m_assetsCache.clear();
     }
 
 
-    template<typename FileNameStringType>
-    ErrorCode readIconDataImpl(FileNameStringType iconName, std::vector<std::uint8_t> &iconData) const
-    {
-        if (iconName.empty())
-        {
-            iconName = umba::string_plus::make_string<FileNameStringType>("default_icon");
-        }
+    // ErrorCode readIconDataImpl(FileNameStringType iconName, std::vector<std::uint8_t> &fData) const
 
-        FileNameStringType iconExtUpper = umba::string_plus::toupper_copy(getExt(iconName));
+    virtual ErrorCode readIconData(const std::string  &iconName, std::vector<std::uint8_t> &iconData) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readIconData);
+        return apiScope.done(readIconDataImpl(iconName, iconData));
+    }
 
-        FileNameStringType iconRootPath = umba::string_plus::make_string<FileNameStringType>("icons");
+    virtual ErrorCode readIconData(const std::wstring &iconName, std::vector<std::uint8_t> &iconData) const override
+    {
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readIconData);
+        return apiScope.done(readIconDataImpl(iconName, iconData));
+    }
 
-        #if defined(WIN32) || defined(_WIN32)
+    virtual ErrorCode readAppIconData(std::vector<std::uint8_t> &iconData) const override
+    {
+        MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "readAppIconData");
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAppIconData);
 
-            iconRootPath = appendPath(iconRootPath, umba::string_plus::make_string<FileNameStringType>("windows"));
+        std::wstring  appName;
+        ErrorCode err = getProjectName(appName);
+        if (err!=ErrorCode::ok)
+        {
+            appName = umba::string_plus::make_string<std::wstring>("app_icon");
+        }
 
-            if (iconExtUpper.empty() || iconExtUpper!=umba::string_plus::make_string<FileNameStringType>("ICO"))
-            {
-                iconName = appendExt(iconName, umba::string_plus::make_string<FileNameStringType>("ico"));
-            }
+        return apiScope.done(readIconDataImpl(appName, iconData));
+    }
 
-        #else
 
-            iconRootPath = appendPath(iconRootPath, umba::string_plus::make_string<FileNameStringType>("linux"));
+    virtual AsyncDataFuture readAssetsDataFileAsync(const std::string  &fName) const override
+    {
+        return readAssetsDataFileAsyncImpl(AssetsApi::readAssetsDataFileAsync, fName, AsyncDataCallback());
+    }
 
-        #endif
+    virtual AsyncDataFuture readAssetsDataFileAsync(const std::wstring &fName) const override
+    {
+        return readAssetsDataFileAsyncImpl(AssetsApi::readAssetsDataFileAsync, fName, AsyncDataCallback());
+    }
 
-        FileNameStringType iconResourceFullFileName = appendPath(iconRootPath, iconName);
+    virtual AsyncDataFuture readAssetsDataFileAsync(const std::string  &fName, AsyncDataCallback callback) const override
+    {
+        return readAssetsDataFileAsyncImpl(AssetsApi::readAssetsDataFileAsync, fName, std::move(callback));
+    }
 
-        return readAssetsDataFileImpl(iconResourceFullFileName, iconData);
+    virtual AsyncDataFuture readAssetsDataFileAsync(const std::wstring &fName, AsyncDataCallback callback) const override
+    {
+        return readAssetsDataFileAsyncImpl(AssetsApi::readAssetsDataFileAsync, fName, std::move(callback));
     }
 
+    virtual AsyncDataFuture readIconDataAsync(const std::string  &iconName) const override
+    {
+        return readAssetsDataFileAsyncImpl(AssetsApi::readIconDataAsync, makeIconResourceFileName(iconName), AsyncDataCallback());
+    }
 
-public:
+    virtual AsyncDataFuture readIconDataAsync(const std::wstring &iconName) const override
+    {
+        return readAssetsDataFileAsyncImpl(AssetsApi::readIconDataAsync, makeIconResourceFileName(iconName), AsyncDataCallback());
+    }
 
-    // Тут автоматически работают перекодировки текста
-    virtual ErrorCode readConfTextFile(const std::string  &fName, std::string  &fText) const override
+    virtual AsyncDataFuture readIconDataAsync(const std::string  &iconName, AsyncDataCallback callback) const override
     {
-        return readConfTextFileImpl(fName, fText);
+        return readAssetsDataFileAsyncImpl(AssetsApi::readIconDataAsync, makeIconResourceFileName(iconName), std::move(callback));
     }
 
-    virtual ErrorCode readConfTextFile(const std::string  &fName, std::wstring &fText) const override
+    virtual AsyncDataFuture readIconDataAsync(const std::wstring &iconName, AsyncDataCallback callback) const override
     {
-        return readConfTextFileImpl(fName, fText);
+        return readAssetsDataFileAsyncImpl(AssetsApi::readIconDataAsync, makeIconResourceFileName(iconName), std::move(callback));
     }
 
-    virtual ErrorCode readConfTextFile(const std::wstring &fName, std::string  &fText) const override
+    virtual AsyncJsonFuture readConfJsonAsync(const std::string  &fName) const override
     {
-        return readConfTextFileImpl(fName, fText);
+        return readConfJsonAsyncImpl(fName, AsyncJsonCallback());
     }
 
-    virtual ErrorCode readConfTextFile(const std::wstring &fName, std::wstring &fText) const override
+    virtual AsyncJsonFuture readConfJsonAsync(const std::wstring &fName) const override
     {
-        return readConfTextFileImpl(fName, fText);
+        return readConfJsonAsyncImpl(fName, AsyncJsonCallback());
     }
 
-    virtual ErrorCode readConfJson(const std::string  &fName, nlohmann::json &j) const override
+    virtual AsyncJsonFuture readConfJsonAsync(const std::string  &fName, AsyncJsonCallback callback) const override
     {
-        std::string text;
-        ErrorCode err = readConfTextFile(fName, text);
-        if (err!=ErrorCode::ok)
-        {
-            return err;
-        }
+        return readConfJsonAsyncImpl(fName, std::move(callback));
+    }
 
-        try
-        {
-            j = marty_simplesquirrel::json_helpers::readGenericJsonFromUtfString(text, fName);
-            return ErrorCode::ok;
-        }
-        catch(...)
-        {
-            return ErrorCode::invalidFormat;
-        }
+    virtual AsyncJsonFuture readConfJsonAsync(const std::wstring &fName, AsyncJsonCallback callback) const override
+    {
+        return readConfJsonAsyncImpl(fName, std::move(callback));
     }
 
-    virtual ErrorCode readConfJson(const std::wstring &fName, nlohmann::json &j) const override
+    virtual void setAsyncIoThreadsCount(std::size_t numThreads) override
     {
-        std::string text;
-        ErrorCode err = readConfTextFile(fName, text);
-        if (err!=ErrorCode::ok)
-        {
-            return err;
-        }
+        std::shared_ptr<WorkerPool> pOldPool;
 
-        try
-        {
-            j = marty_simplesquirrel::json_helpers::readGenericJsonFromUtfString(text, encodeText(fName));
-            return ErrorCode::ok;
-        }
-        catch(...)
         {
-            return ErrorCode::invalidFormat;
+            std::lock_guard<std::mutex> lock(m_asyncIoPoolMutex);
+            m_asyncIoThreadsCount = numThreads<1 ? 1u : numThreads;
+            if (m_pAsyncIoPool && m_pAsyncIoPool->getNumThreads()!=m_asyncIoThreadsCount)
+            {
+                pOldPool.swap(m_pAsyncIoPool); // Новый пул создастся при следующем запросе
+            }
         }
 
+        // Старый пул выполняет уже поставленные задачи и разрушается здесь же, вне блокировки - после выхода
+        // ни одна его задача не выполняется. Вызов из колбэка в потоке этого пула тоже допустим (см. ~WorkerPool)
+        pOldPool.reset();
     }
 
-     
-    // Reading binary files
-    virtual ErrorCode readConfDataFile(const std::string  &fName, std::vector<std::uint8_t> &fData) const override
+    virtual std::size_t getAsyncIoThreadsCount() const override
     {
-        return readConfDataFileImpl(fName, fData);
+        std::lock_guard<std::mutex> lock(m_asyncIoPoolMutex);
+        return m_asyncIoThreadsCount;
     }
 
-    virtual ErrorCode readConfDataFile(const std::wstring &fName, std::vector<std::uint8_t> &fData) const override
+
+    virtual ErrorCode readConfDataFileView(const std::string  &fName, DataView &view) const override
     {
-        return readConfDataFileImpl(fName, fData);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfDataFileView);
+        return apiScope.done(readConfDataFileViewImpl(fName, view));
     }
 
-    virtual ErrorCode readAssetsDataFile(const std::string  &fName, std::vector<std::uint8_t> &fData) const override
+    virtual ErrorCode readConfDataFileView(const std::wstring &fName, DataView &view) const override
     {
-        return readAssetsDataFileImpl(fName, fData);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readConfDataFileView);
+        return apiScope.done(readConfDataFileViewImpl(fName, view));
     }
 
-    virtual ErrorCode readAssetsDataFile(const std::wstring &fName, std::vector<std::uint8_t> &fData) const override
+    virtual ErrorCode readAssetsDataFileView(const std::string  &fName, DataView &view) const override
     {
-        return readAssetsDataFileImpl(fName, fData);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAssetsDataFileView);
+        return apiScope.done(readAssetsDataFileViewImpl(fName, view));
     }
 
-
-    // ErrorCode readIconDataImpl(FileNameStringType iconName, std::vector<std::uint8_t> &fData) const
-
-    virtual ErrorCode readIconData(const std::string  &iconName, std::vector<std::uint8_t> &iconData) const override
+    virtual ErrorCode readAssetsDataFileView(const std::wstring &fName, DataView &view) const override
     {
-        return readIconDataImpl(iconName, iconData);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readAssetsDataFileView);
+        return apiScope.done(readAssetsDataFileViewImpl(fName, view));
     }
 
-    virtual ErrorCode readIconData(const std::wstring &iconName, std::vector<std::uint8_t> &iconData) const override
+    virtual ErrorCode readIconDataView(const std::string  &iconName, DataView &view) const override
     {
-        return readIconDataImpl(iconName, iconData);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readIconDataView);
+        return apiScope.done(readIconDataViewImpl(iconName, view));
     }
 
-    virtual ErrorCode readAppIconData(std::vector<std::uint8_t> &iconData) const override
+    virtual ErrorCode readIconDataView(const std::wstring &iconName, DataView &view) const override
     {
-        std::wstring  appName;
-        ErrorCode err = getProjectName(appName);
-        if (err!=ErrorCode::ok)
-        {
-            appName = umba::string_plus::make_string<std::wstring>("app_icon");
-        }
-
-        return readIconData(appName, iconData);
+        ApiCallScope apiScope(m_apiStats, AssetsApi::readIconDataView);
+        return apiScope.done(readIconDataViewImpl(iconName, view));
     }
 
 
@@ -1707,11 +3459,14 @@ public:
 
     virtual ErrorCode loadTranslations() const override
     {
+        MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "loadTranslations");
+        ApiCallScope apiScope(m_apiStats, AssetsApi::loadTranslations);
+
         std::wstring  appName;
         ErrorCode err = getProjectName(appName);
         if (err!=ErrorCode::ok)
         {
-            return err;
+            return apiScope.done(err);
         }
 
 
@@ -1722,7 +3477,7 @@ public:
         fullTrFileName = m_pFs->appendExt(fullTrFileName, umba::string_plus::make_string<std::wstring>(".json"));
 
         std::string trJson;
-        ErrorCode err1 = m_pFs->readTextFile(fullTrFileName, trJson);
+        ErrorCode err1 = fsReadTextFile(fullTrFileName, trJson);
         if (err1==ErrorCode::ok)
         {
             err1 = loadUserTranslationsFromJson(trJson);
@@ -1736,13 +3491,13 @@ public:
 
         trJson.clear();
 
-        ErrorCode err2 = m_pFs->readTextFile(fullTrFileName, trJson);
+        ErrorCode err2 = fsReadTextFile(fullTrFileName, trJson);
         if (err2==ErrorCode::ok)
         {
             err2 = loadUserTranslationsFromJson(trJson);
         }
 
-        return err1!=ErrorCode::ok ? err1 : err2;
+        return apiScope.done(err1!=ErrorCode::ok ? err1 : err2);
     }
 
 
@@ -1780,10 +3535,14 @@ public:
 
 
 
+// Точки монтирования к каталогам локальной ФС не привязываются. Без привязок (configureNutAssetsNativeMountPoints
+// или setNativeMountPoint) у файлов нет отметок, и кэши ассетов и конфигов не работают - всё читается через VFS
 inline
 std::shared_ptr<IAssetsManager> makeAssetsManager( std::shared_ptr<marty_virtual_fs::IFileSystem> pFileSystem
                                                  )
 {
+    MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "makeAssetsManager");
+
     auto pAppPaths = std::make_shared<marty_virtual_fs::AppPathsImpl>();
     std::wstring appName;
     pAppPaths->getAppName(appName);
@@ -0,0 +1,516 @@
+/*! \file
+    \brief Incremental reload of nut manifest and project on file changes
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//
+#include "i_assets_manager.h"
+#include "file_watcher.h"
+#include "config_text_format.h"
+
+//
+#include "nlohmann/json.hpp"
+#include "marty_simplesquirrel/json.h"
+
+//
+#include "umba/string_plus.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Секции манифеста (NutManifestT) - битовые флаги
+namespace nut_manifest_section
+{
+
+constexpr std::uint32_t none          = 0x0000;
+constexpr std::uint32_t appGroup      = 0x0001; // NutManifestT::appGroup
+constexpr std::uint32_t graphicsMode  = 0x0002; // NutManifestT::manifestGraphicsMode
+constexpr std::uint32_t window        = 0x0004; // NutManifestT::window
+constexpr std::uint32_t startup       = 0x0008; // NutManifestT::startupManifest
+constexpr std::uint32_t hotkeys       = 0x0010; // NutManifestT::hotkeysManifest
+constexpr std::uint32_t envVars       = 0x0020; // NutManifestT::envVars
+constexpr std::uint32_t filesystem    = 0x0040; // NutManifestT::filesystemManifest
+constexpr std::uint32_t all           = 0x007F;
+
+} // namespace nut_manifest_section
+
+//----------------------------------------------------------------------------
+// Секция, в которую разбирается ключ верхнего уровня файла манифеста
+inline
+std::uint32_t getNutManifestKeySection(const std::string &key)
+{
+    static const std::unordered_map<std::string, std::uint32_t> keySections =
+    { { "appGroup"                    , nut_manifest_section::appGroup     }
+    , { "app-group"                   , nut_manifest_section::appGroup     }
+    , { "graphicsMode"                , nut_manifest_section::graphicsMode }
+    , { "graphics-mode"               , nut_manifest_section::graphicsMode }
+    , { "window"                      , nut_manifest_section::window       }
+    , { "startup"                     , nut_manifest_section::startup      }
+    , { "hotkeys"                     , nut_manifest_section::hotkeys      }
+    , { "importEnvironmentVariables"  , nut_manifest_section::envVars      }
+    , { "import-environment-variables", nut_manifest_section::envVars      }
+    , { "clearVariables"              , nut_manifest_section::envVars      }
+    , { "clear-variables"             , nut_manifest_section::envVars      }
+    , { "variables"                   , nut_manifest_section::envVars      }
+    , { "filesystem"                  , nut_manifest_section::filesystem   }
+    };
+
+    auto it = keySections.find(key);
+    return it==keySections.end() ? nut_manifest_section::none : it->second;
+}
+
+//----------------------------------------------------------------------------
+// Секции, содержимое которых отличается в двух версиях файла манифеста
+inline
+std::uint32_t diffNutManifestJson(const nlohmann::json &jOld, const nlohmann::json &jNew)
+{
+    if (!jOld.is_object() || !jNew.is_object())
+    {
+        return nut_manifest_section::all;
+    }
+
+    std::uint32_t changed = nut_manifest_section::none;
+
+    for(auto it=jOld.begin(); it!=jOld.end(); ++it)
+    {
+        auto itNew = jNew.find(it.key());
+        if (itNew==jNew.end() || *itNew!=it.value())
+        {
+            changed |= getNutManifestKeySection(it.key());
+        }
+    }
+
+    for(auto it=jNew.begin(); it!=jNew.end(); ++it)
+    {
+        if (jOld.find(it.key())==jOld.end())
+        {
+            changed |= getNutManifestKeySection(it.key());
+        }
+    }
+
+    return changed;
+}
+
+//----------------------------------------------------------------------------
+template<typename StringType> inline
+void copyNutManifestSections(const NutManifestT<StringType> &from, NutManifestT<StringType> &to, std::uint32_t sections)
+{
+    to.manifestFileName = from.manifestFileName;
+
+    if (sections&nut_manifest_section::appGroup    ) to.appGroup             = from.appGroup            ;
+    if (sections&nut_manifest_section::graphicsMode) to.manifestGraphicsMode = from.manifestGraphicsMode;
+    if (sections&nut_manifest_section::window      ) to.window               = from.window              ;
+    if (sections&nut_manifest_section::startup     ) to.startupManifest      = from.startupManifest     ;
+    if (sections&nut_manifest_section::hotkeys     ) to.hotkeysManifest      = from.hotkeysManifest     ;
+    if (sections&nut_manifest_section::envVars     ) to.envVars              = from.envVars             ;
+    if (sections&nut_manifest_section::filesystem  ) to.filesystemManifest   = from.filesystemManifest  ;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// Что изменилось при очередной проверке NutAssetsWatcherT::checkChanges
+template<typename StringType>
+struct NutAssetsChangesT
+{
+    std::uint32_t                   manifestSections = nut_manifest_section::none; // Перечитанные секции манифеста
+    NutProjectChangesT<StringType>  projectChanges; // Изменения проекта (IAssetsManager::reloadNutProjectState)
+    std::vector<StringType>         changedMounts    ; // Точки монтирования, содержимое которых изменилось (remountOnMediaChanges)
+
+    bool empty() const
+    {
+        return manifestSections==nut_manifest_section::none && projectChanges.empty() && changedMounts.empty();
+    }
+
+}; // struct NutAssetsChangesT
+
+typedef NutAssetsChangesT<std::string>     NutAssetsChangesA;
+typedef NutAssetsChangesT<std::wstring>    NutAssetsChangesW;
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// Следит за файлом манифеста, файлами проекта и каталогами точек монтирования и при изменениях перечитывает
+// только затронутое: изменившиеся секции манифеста, изменившиеся nut-файлы и файлы проектов
+// (IAssetsManager::reloadNutProjectState). Потоков не создаёт - checkChanges вызывается из цикла приложения,
+// колбэк вызывается из checkChanges. Следить можно только за файлами, лежащими в локальной ФС
+template<typename StringType>
+struct NutAssetsWatcherT
+{
+    typedef NutAssetsChangesT<StringType>                   Changes;
+    typedef std::function<void(const Changes &changes)>     Callback;
+
+protected:
+
+    enum class WatchedKind
+    {
+        manifest,
+        projectFile,
+        nutFile,
+        mountPoint
+    };
+
+    struct WatchedItem
+    {
+        WatchedKind     kind;
+        std::size_t     idx ; // Индекс в nuts/projectFiles/m_mountPoints
+    };
+
+    std::shared_ptr<IAssetsManager>                 m_pAssetsManager;
+    NativeFileWatcher                               m_fileWatcher   ;
+    Callback                                        m_callback      ;
+
+    bool                                            m_watchManifest = false;
+    NutManifestT<StringType>                        m_baseManifest  ; // Манифест до применения файла (умолчания)
+    NutManifestT<StringType>                        m_manifest      ;
+    nlohmann::json                                  m_manifestJson  ;
+    std::wstring                                    m_manifestNativeFileName;
+
+    bool                                            m_watchProject  = false;
+    NutProjectStateT<StringType>                    m_projectState  ;
+
+    std::vector<StringType>                         m_mountPointNames; // Точки монтирования менеджера, за которыми следим
+    std::vector< std::pair<StringType, std::wstring> >  m_mountPoints; // Имя точки монтирования, каталог
+
+    std::vector<WatchedItem>                        m_watchedItems  ; // Параллельно путям m_fileWatcher
+
+
+    static std::wstring toWide(const std::wstring &str) { return str; }
+    static std::wstring toWide(const std::string  &str) { return umba::fromUtf8(str); }
+
+    static bool readNativeJson(const std::wstring &nativeFileName, nlohmann::json &j)
+    {
+        std::ifstream in(std::filesystem::path(nativeFileName), std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (text.size()>=3 && (std::uint8_t)text[0]==0xEF && (std::uint8_t)text[1]==0xBB && (std::uint8_t)text[2]==0xBF)
+        {
+            text.erase(0, 3);
+        }
+
+        if (detectConfigTextFormat(nativeFileName, text)==ConfigTextFormat::json)
+        {
+            j = nlohmann::json::parse(text, nullptr, false /* allow_exceptions */);
+            if (!j.is_discarded())
+            {
+                return true;
+            }
+        }
+
+        try
+        {
+            j = marty_simplesquirrel::json_helpers::readGenericJsonFromUtfString(text, umba::toUtf8(nativeFileName));
+        }
+        catch(...)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    void rebuildWatchList()
+    {
+        std::vector<std::wstring> paths;
+        m_watchedItems.clear();
+
+        auto addItem = [&](WatchedKind kind, std::size_t idx, const std::wstring &nativeName)
+        {
+            paths.emplace_back(nativeName);
+            m_watchedItems.emplace_back(WatchedItem{kind, idx});
+        };
+
+        if (m_watchManifest && !m_manifestNativeFileName.empty())
+        {
+            addItem(WatchedKind::manifest, 0, m_manifestNativeFileName);
+        }
+
+        if (m_watchProject)
+        {
+            std::wstring nativeName;
+
+            for(std::size_t i=0; i!=m_projectState.project.projectFiles.size(); ++i)
+            {
+                if (m_pAssetsManager->getNativeFileName(m_projectState.project.projectFiles[i], nativeName))
+                {
+                    addItem(WatchedKind::projectFile, i, nativeName);
+                }
+            }
+
+            for(std::size_t i=0; i!=m_projectState.project.nuts.size(); ++i)
+            {
+                if (m_pAssetsManager->getNativeFileName(m_projectState.project.nuts[i], nativeName))
+                {
+                    addItem(WatchedKind::nutFile, i, nativeName);
+                }
+            }
+        }
+
+        for(std::size_t i=0; i!=m_mountPoints.size(); ++i)
+        {
+            addItem(WatchedKind::mountPoint, i, m_mountPoints[i].second);
+        }
+
+        m_fileWatcher.setPaths(paths);
+    }
+
+    void resolveMountPoints()
+    {
+        m_mountPoints.clear();
+
+        for(const auto &name : m_mountPointNames)
+        {
+            std::wstring nativeName;
+            if (m_pAssetsManager->getNativeFileName(umba::string_plus::make_string<StringType>("/")+name, nativeName))
+            {
+                m_mountPoints.emplace_back(name, nativeName);
+            }
+        }
+
+        if (m_watchManifest)
+        {
+            for(const auto &mpi : m_manifest.filesystemManifest.customMountPoints)
+            {
+                m_mountPoints.emplace_back(mpi.mountPointName, toWide(mpi.mountPointTargetPath));
+            }
+        }
+    }
+
+    bool isRemountOnMediaChanges() const
+    {
+        // Без манифеста - значение по умолчанию
+        return !m_watchManifest || m_manifest.filesystemManifest.remountOnMediaChanges;
+    }
+
+    void reloadManifest(Changes &changes)
+    {
+        nlohmann::json jNew;
+        if (!readNativeJson(m_manifestNativeFileName, jNew))
+        {
+            return; // Файл в процессе записи или испорчен - оставляем предыдущую версию
+        }
+
+        std::uint32_t sections = diffNutManifestJson(m_manifestJson, jNew);
+        if (sections==nut_manifest_section::none)
+        {
+            return;
+        }
+
+        // Файл манифеста маленький, разбираем его целиком, а заменяем только изменившиеся секции
+        NutManifestT<StringType> newManifest = m_baseManifest;
+        if (m_pAssetsManager->updateNutManifest(m_manifest.manifestFileName, newManifest)!=ErrorCode::ok)
+        {
+            return;
+        }
+
+        copyNutManifestSections(newManifest, m_manifest, sections);
+        m_manifestJson = std::move(jNew);
+
+        changes.manifestSections |= sections;
+    }
+
+public:
+
+    NutAssetsWatcherT( std::shared_ptr<IAssetsManager> pAssetsManager
+                     , Callback                        callback
+                     , bool                            useNotifications = true
+                     , unsigned                        pollIntervalMs   = 1000
+                     )
+    : m_pAssetsManager(pAssetsManager)
+    , m_fileWatcher(useNotifications, pollIntervalMs)
+    , m_callback(std::move(callback))
+    {}
+
+    NutAssetsWatcherT(const NutAssetsWatcherT &) = delete;
+    NutAssetsWatcherT& operator=(const NutAssetsWatcherT &) = delete;
+
+    // Читает манифест приложения (IAssetsManager::updateNutManifest поверх baseManifest) и начинает следить за ним.
+    // notSupported - манифест прочитан, но лежит не в локальной ФС, и следить за ним нельзя
+    ErrorCode watchManifest(const NutManifestT<StringType> &baseManifest)
+    {
+        NutManifestT<StringType> manifest = baseManifest;
+        ErrorCode err = m_pAssetsManager->updateNutManifest(manifest);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        m_baseManifest  = baseManifest;
+        m_manifest      = std::move(manifest);
+        m_watchManifest = true;
+        m_manifestJson  = nlohmann::json();
+        m_manifestNativeFileName.clear();
+
+        if ( !m_pAssetsManager->getNativeFileName(m_manifest.manifestFileName, m_manifestNativeFileName)
+          || !readNativeJson(m_manifestNativeFileName, m_manifestJson)
+           )
+        {
+            m_manifestNativeFileName.clear();
+            err = ErrorCode::notSupported;
+        }
+
+        rebuildWatchList();
+
+        return err;
+    }
+
+    // Загружает проект (IAssetsManager::readNutProjectState) и начинает следить за его файлами
+    ErrorCode watchProject()
+    {
+        ErrorCode err = m_pAssetsManager->readNutProjectState(m_projectState);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        m_watchProject = true;
+
+        rebuildWatchList();
+
+        return ErrorCode::ok;
+    }
+
+    // Начинает следить за каталогами точек монтирования менеджера (например, "assets") и за целевыми
+    // каталогами точек монтирования из манифеста. Изменения сообщаются, только если в манифесте
+    // разрешено filesystem/remountOnMediaChanges. С inotify замечаются изменения на любой глубине каталога,
+    // при опросе - только добавление/удаление/переименование его непосредственных элементов (см. NativeFileWatcher)
+    void watchMountPoints(const std::vector<StringType> &mountPointNames)
+    {
+        m_mountPointNames = mountPointNames;
+
+        resolveMountPoints();
+        rebuildWatchList();
+    }
+
+    const NutManifestT<StringType>& getManifest() const
+    {
+        return m_manifest;
+    }
+
+    const NutProjectT<StringType>& getProject() const
+    {
+        return m_projectState.project;
+    }
+
+    bool usesNotifications() const
+    {
+        return m_fileWatcher.usesNotifications();
+    }
+
+    // Проверяет изменения, перечитывает затронутое и вызывает колбэк. Возвращает true, если что-то изменилось
+    bool checkChanges()
+    {
+        std::vector<std::size_t> changedPaths;
+        if (!m_fileWatcher.checkChanges(changedPaths))
+        {
+            return false;
+        }
+
+        // Что-то поменялось на диске - закэшированным спискам каталогов и данным ассетов больше не доверяем,
+        // индексы строим заново
+        m_pAssetsManager->clearLookupCache();
+        m_pAssetsManager->clearAssetsCache();
+        m_pAssetsManager->rebuildMountIndexes();
+
+        bool manifestChanged = false;
+        bool projectChanged  = false;
+        std::vector<std::size_t> changedMounts;
+
+        for(auto pathIdx : changedPaths)
+        {
+            const WatchedItem &item = m_watchedItems[pathIdx];
+            switch(item.kind)
+            {
+                case WatchedKind::manifest   : manifestChanged = true; break;
+                case WatchedKind::projectFile: projectChanged  = true; break;
+                case WatchedKind::nutFile    : projectChanged  = true; break;
+                case WatchedKind::mountPoint : changedMounts.emplace_back(item.idx); break;
+            }
+        }
+
+        Changes changes;
+
+        if (manifestChanged)
+        {
+            reloadManifest(changes);
+        }
+
+        if (projectChanged)
+        {
+            // Перечитывается только изменившееся. Если перечитать не удалось (файл в процессе записи),
+            // остаётся прежний проект, а изменения будут подхвачены при следующей записи
+            m_pAssetsManager->reloadNutProjectState(m_projectState, changes.projectChanges);
+        }
+
+        if (isRemountOnMediaChanges())
+        {
+            for(auto mpIdx : changedMounts)
+            {
+                changes.changedMounts.emplace_back(m_mountPoints[mpIdx].first);
+            }
+        }
+
+        if ((changes.manifestSections&nut_manifest_section::filesystem)!=0)
+        {
+            // Могли измениться точки монтирования из манифеста
+            resolveMountPoints();
+        }
+
+        if ( changes.projectChanges.nutsListChanged || !changes.projectChanges.reparsedProjectFiles.empty()
+          || (changes.manifestSections&nut_manifest_section::filesystem)!=0
+           )
+        {
+            // Список наблюдаемых файлов мог измениться
+            rebuildWatchList();
+        }
+
+        if (changes.empty())
+        {
+            return false;
+        }
+
+        if (m_callback)
+        {
+            m_callback(changes);
+        }
+
+        return true;
+    }
+
+}; // struct NutAssetsWatcherT
+
+//----------------------------------------------------------------------------
+typedef NutAssetsWatcherT<std::string>     NutAssetsWatcherA;
+typedef NutAssetsWatcherT<std::wstring>    NutAssetsWatcherW;
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,130 @@
+/*! \file
+    \brief Coalescing of concurrent asynchronous requests for the same resource
+*/
+
+#pragma once
+
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//
+#include "worker_pool.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Асинхронные запросы с одинаковым ключом, пришедшие, пока первый из них ещё выполняется,
+// не порождают новой работы - они получают тот же future и/или их колбэки вызываются с тем же результатом.
+// После завершения запроса ключ забывается, следующий запрос выполняется заново (кэширование - не здесь)
+template<typename ResultType>
+struct AsyncRequestCoalescer
+{
+    typedef std::shared_future<ResultType>              Future;
+    typedef std::function<void(const ResultType&)>      Callback;
+    typedef std::function<ResultType()>                 Job;
+
+protected:
+
+    struct InFlight
+    {
+        std::promise<ResultType>    promise  ;
+        Future                      future   ;
+        std::vector<Callback>       callbacks;
+    };
+
+    std::mutex                                                  m_mutex   ;
+    std::unordered_map<std::wstring, std::shared_ptr<InFlight> > m_inFlight;
+
+
+    void complete(const std::wstring &key, const std::shared_ptr<InFlight> &pInFlight, ResultType result)
+    {
+        std::vector<Callback> callbacks;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inFlight.erase(key);
+            callbacks.swap(pInFlight->callbacks);
+        }
+
+        pInFlight->promise.set_value(std::move(result));
+
+        const ResultType &res = pInFlight->future.get();
+        for(const auto &cb : callbacks)
+        {
+            try
+            {
+                cb(res);
+            }
+            catch(...)
+            {
+                // Исключение из колбэка не должно мешать остальным
+            }
+        }
+    }
+
+
+public:
+
+    // Ставит job в очередь пула, если запрос с таким ключом ещё не выполняется.
+    // job не должна бросать исключений. callback может быть пустым
+    Future request(WorkerPool &pool, const std::wstring &key, Job job, Callback callback)
+    {
+        std::shared_ptr<InFlight> pInFlight;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_inFlight.find(key);
+            if (it!=m_inFlight.end())
+            {
+                if (callback)
+                {
+                    it->second->callbacks.emplace_back(std::move(callback));
+                }
+
+                return it->second->future;
+            }
+
+            pInFlight = std::make_shared<InFlight>();
+            pInFlight->future = pInFlight->promise.get_future().share();
+            if (callback)
+            {
+                pInFlight->callbacks.emplace_back(std::move(callback));
+            }
+
+            m_inFlight[key] = pInFlight;
+        }
+
+        pool.submit( [this, key, pInFlight, job]()
+                     {
+                         complete(key, pInFlight, job());
+                     }
+                   );
+
+        return pInFlight->future;
+    }
+
+    std::size_t getNumInFlight()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_inFlight.size();
+    }
+
+}; // struct AsyncRequestCoalescer
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,262 @@
+/*! \file
+    \brief Cold and warm timings of the main IAssetsManager read paths on a synthetic tree
+*/
+
+#include "bench_common.h"
+
+
+namespace marty_assets_bench {
+
+
+using marty_assets_manager::IAssetsManager;
+
+
+
+//----------------------------------------------------------------------------
+namespace {
+
+// Одна порция замера: возвращает количество выполненных операций, 0 - ошибка (результат неверный)
+typedef std::function<std::uint64_t(IAssetsManager&)>   BenchBody;
+
+struct AssetsBench
+{
+    const BenchOptions     &opts  ;
+    const SyntheticTree    &tree  ;
+    BenchReport            &report;
+    bool                    ok     = true;
+
+
+    void fail(const BenchResult &res)
+    {
+        std::fprintf(stderr, "assets: %s (%s) returned unexpected result\n", res.name.c_str(), res.mode.c_str());
+        ok = false;
+        report.failed = true;
+    }
+
+    // Холодный прогон: каждую итерацию - новый менеджер, кэши менеджера пусты.
+    // Кэш ОС после генерации дерева уже прогрет, замеряется работа самой библиотеки
+    void cold(const char *name, AssetsApi api, const BenchBody &body)
+    {
+        BenchResult &res = report.add("assets", name, "cold");
+        for(std::size_t i=0; i!=opts.iterations; ++i)
+        {
+            BenchEnvironment env = makeBenchEnvironment(tree, opts);
+
+            auto start = Clock::now();
+            std::uint64_t ops = body(*env.pAm);
+            res.totalNs += elapsedNs(start);
+
+            if (!ops)
+            {
+                fail(res);
+                return;
+            }
+
+            res.ops += ops;
+            addApiStats(res, *env.pAm, api);
+        }
+    }
+
+    // Тёплый прогон: один менеджер, первый проход не замеряется
+    void warm(const char *name, const char *mode, AssetsApi api, const BenchBody &body, const std::function<void(IAssetsManager&)> &setup = {})
+    {
+        BenchResult &res = report.add("assets", name, mode);
+
+        BenchEnvironment env = makeBenchEnvironment(tree, opts);
+        if (setup)
+        {
+            setup(*env.pAm);
+        }
+
+        if (!body(*env.pAm))
+        {
+            fail(res);
+            return;
+        }
+
+        resetApiStats(*env.pAm);
+
+        for(std::size_t i=0; i!=opts.iterations; ++i)
+        {
+            auto start = Clock::now();
+            std::uint64_t ops = body(*env.pAm);
+            res.totalNs += elapsedNs(start);
+
+            if (!ops)
+            {
+                fail(res);
+                return;
+            }
+
+            res.ops += ops;
+        }
+
+        addApiStats(res, *env.pAm, api);
+    }
+
+    void both(const char *name, AssetsApi api, const BenchBody &body)
+    {
+        cold(name, api, body);
+        warm(name, "warm", api, body);
+    }
+
+    // Как both, но тёплый прогон обязан обслуживаться из кэша - проверяем, что точки монтирования
+    // привязаны к каталогам (setNativeMountPoint), иначе у файлов нет отметок и кэш не работает
+    void bothCached(const char *name, AssetsApi api, const BenchBody &body)
+    {
+        cold(name, api, body);
+
+        const std::size_t idx = report.results.size();
+        warm(name, "warm", api, body);
+
+        if (idx<report.results.size())
+        {
+            const BenchResult &res = report.results[idx];
+            if (res.ops && (res.cacheMisses || res.cacheHits<res.ops))
+            {
+                std::fprintf(stderr, "assets: %s (%s) is not served from cache: %llu hits, %llu misses\n"
+                            , res.name.c_str(), res.mode.c_str()
+                            , (unsigned long long)res.cacheHits, (unsigned long long)res.cacheMisses
+                            );
+                ok = false;
+                report.failed = true;
+            }
+        }
+    }
+
+}; // struct AssetsBench
+
+} // namespace
+
+//----------------------------------------------------------------------------
+bool runAssetsBench(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report)
+{
+    AssetsBench bench{opts, tree, report};
+
+    const std::size_t numNuts = tree.nutNames.size();
+
+    auto readProject = [numNuts](IAssetsManager &am) -> std::uint64_t
+                       {
+                           marty_assets_manager::NutProjectW prj;
+                           if (am.readNutProjectComplete(prj)!=ErrorCode::ok || prj.nuts.size()!=numNuts || prj.nutsData.size()!=numNuts)
+                           {
+                               return 0;
+                           }
+                           return 1;
+                       };
+
+    bench.both("readNutProjectComplete", AssetsApi::readNutProjectComplete, readProject);
+
+    // То же с постоянным кэшем разобранного проекта (setProjectCacheDirectory)
+    {
+        std::filesystem::path cacheDir = tree.rootPath / "_project_cache";
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+
+        bench.warm( "readNutProjectComplete", "warm+prjcache", AssetsApi::readNutProjectComplete, readProject
+                  , [cacheDir](IAssetsManager &am)
+                    {
+                        am.setProjectCacheDirectory(cacheDir.wstring());
+                    }
+                  );
+    }
+
+    bench.both( "updateNutManifest", AssetsApi::updateNutManifest
+              , [](IAssetsManager &am) -> std::uint64_t
+                {
+                    marty_assets_manager::NutManifestW manifest;
+                    if (am.updateNutManifest(manifest)!=ErrorCode::ok || manifest.envVars.empty() || manifest.filesystemManifest.customMountPoints.empty())
+                    {
+                        return 0;
+                    }
+                    return 1;
+                }
+              );
+
+    bench.bothCached( "readAssetsDataFile", AssetsApi::readAssetsDataFile
+                    , [&tree, &opts](IAssetsManager &am) -> std::uint64_t
+                      {
+                          std::vector<std::uint8_t> data;
+                          for(const auto &name : tree.assetNames)
+                          {
+                              if (am.readAssetsDataFile(name, data)!=ErrorCode::ok || data.size()!=opts.assetSize)
+                              {
+                                  return 0;
+                              }
+                          }
+                          return tree.assetNames.size();
+                      }
+                    );
+
+    bench.bothCached( "readConfJson", AssetsApi::readConfJson
+                    , [&tree, &opts](IAssetsManager &am) -> std::uint64_t
+                      {
+                          for(const auto &name : tree.confNames)
+                          {
+                              nlohmann::json j;
+                              if (am.readConfJson(name, j)!=ErrorCode::ok || !j.is_object() || j.size()!=opts.confKeys)
+                              {
+                                  return 0;
+                              }
+                          }
+                          return tree.confNames.size();
+                      }
+                    );
+
+    // Поиск иконки: имя -> icons/<платформа>/<имя>[.ico] -> чтение
+    bench.both( "readIconData", AssetsApi::readIconData
+              , [&tree, &opts](IAssetsManager &am) -> std::uint64_t
+                {
+                    std::vector<std::uint8_t> data;
+                    if (am.readIconData(tree.appName, data)!=ErrorCode::ok || data.size()!=opts.assetSize)
+                    {
+                        return 0;
+                    }
+                    return 1;
+                }
+              );
+
+    bench.both( "readAppIconData", AssetsApi::readAppIconData
+              , [&opts](IAssetsManager &am) -> std::uint64_t
+                {
+                    std::vector<std::uint8_t> data;
+                    if (am.readAppIconData(data)!=ErrorCode::ok || data.size()!=opts.assetSize)
+                    {
+                        return 0;
+                    }
+                    return 1;
+                }
+              );
+
+    bench.both( "loadTranslations", AssetsApi::loadTranslations
+              , [](IAssetsManager &am) -> std::uint64_t
+                {
+                    return am.loadTranslations()==ErrorCode::ok ? 1u : 0u;
+                }
+              );
+
+    // Определение типа по имени не зависит от состояния менеджера - только тёплый прогон
+    bench.warm( "detectFileNutType", "warm", AssetsApi::count
+              , [&tree, numNuts](IAssetsManager &am) -> std::uint64_t
+                {
+                    std::size_t nutFiles = 0;
+                    for(const auto &name : tree.allNames)
+                    {
+                        if (am.detectFileNutType(name)==marty_assets_manager::NutType::nutFile)
+                        {
+                            ++nutFiles;
+                        }
+                    }
+                    return nutFiles==numNuts ? tree.allNames.size() : 0u;
+                }
+              );
+
+    return bench.ok;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_bench
+
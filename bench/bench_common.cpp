@@ -0,0 +1,361 @@
+/*! \file
+    \brief Synthetic tree generator, benchmark environment and results report
+*/
+
+#include "bench_common.h"
+
+
+namespace marty_assets_bench {
+
+
+
+//----------------------------------------------------------------------------
+namespace {
+
+// Детерминированное наполнение файлов - одинаковое от прогона к прогону
+struct Lcg
+{
+    std::uint32_t   state;
+
+    explicit Lcg(std::uint32_t seed) : state(seed) {}
+
+    std::uint32_t next()
+    {
+        state = state*1664525u + 1013904223u;
+        return state;
+    }
+
+}; // struct Lcg
+
+std::string makeNumber(std::size_t n, int width)
+{
+    std::string str = std::to_string(n);
+    if (str.size()<(std::size_t)width)
+    {
+        str.insert(0, (std::size_t)width-str.size(), '0');
+    }
+
+    return str;
+}
+
+std::wstring toWide(const std::string &str)
+{
+    return std::wstring(str.begin(), str.end()); // Только ASCII-имена
+}
+
+std::string makeBinaryData(std::size_t size, std::uint32_t seed)
+{
+    Lcg lcg(seed);
+    std::string data(size, '\0');
+    for(auto &ch : data)
+    {
+        ch = (char)(lcg.next()>>24);
+    }
+
+    return data;
+}
+
+std::string makeNutText(std::size_t nutIdx, std::size_t size)
+{
+    std::string text = "// nut " + std::to_string(nutIdx) + "\n";
+    for(std::size_t i=0; text.size()<size; ++i)
+    {
+        text.append("local v" + std::to_string(i) + " = " + std::to_string(nutIdx*31u+i) + ";\n");
+    }
+
+    return text;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+bool SyntheticTree::writeFile(const std::filesystem::path &relName, const std::string &data)
+{
+    std::filesystem::path fullName = rootPath / relName;
+
+    std::error_code ec;
+    std::filesystem::create_directories(fullName.parent_path(), ec);
+
+    std::ofstream ofs(fullName, std::ios::binary|std::ios::trunc);
+    if (!ofs)
+    {
+        return false;
+    }
+
+    ofs.write(data.data(), (std::streamsize)data.size());
+    totalBytes += data.size();
+
+    return (bool)ofs;
+}
+
+//----------------------------------------------------------------------------
+ErrorCode SyntheticTree::generate(const BenchOptions &opts)
+{
+    rootPath = opts.root.empty() ? std::filesystem::temp_directory_path() / "marty_assets_bench" : opts.root;
+
+    remove();
+
+    nutNames.clear();
+    assetNames.clear();
+    confNames.clear();
+    allNames.clear();
+    totalBytes = 0;
+
+    const std::string appNameA(appName.begin(), appName.end());
+
+    bool ok = true;
+
+    // nuts/: цепочка подключаемых файлов проекта глубиной includeDepth, скрипты раскладываются по уровням поровну.
+    // Уровень k лежит в nuts/inc1/.../inck, подключает уровень k+1 относительно своего каталога
+    {
+        const std::size_t numLevels = opts.includeDepth+1;
+
+        std::vector<nlohmann::json> levelFiles(numLevels, nlohmann::json::array());
+        std::vector<std::string>    levelDirs (numLevels);
+        for(std::size_t lvl=1; lvl<numLevels; ++lvl)
+        {
+            levelDirs[lvl] = levelDirs[lvl-1] + "inc" + std::to_string(lvl) + "/";
+        }
+
+        for(std::size_t i=0; i!=opts.numNuts; ++i)
+        {
+            std::size_t lvl     = i%numLevels;
+            std::string nutName = "nut_" + makeNumber(i, 5) + ".nut";
+            levelFiles[lvl].push_back(nutName);
+
+            std::string relName = levelDirs[lvl] + nutName;
+            ok = ok && writeFile(std::filesystem::path("nuts") / relName, makeNutText(i, opts.nutSize));
+            nutNames.emplace_back(toWide(relName));
+        }
+
+        for(std::size_t lvl=0; lvl!=numLevels; ++lvl)
+        {
+            if (lvl+1<numLevels)
+            {
+                levelFiles[lvl].push_back(nlohmann::json{ {"include", "inc" + std::to_string(lvl+1) + "/part.nuts.json"} });
+            }
+
+            std::string prjName = levelDirs[lvl] + (lvl ? std::string("part") : appNameA) + ".nuts.json";
+            ok = ok && writeFile(std::filesystem::path("nuts") / prjName, nlohmann::json{ {"files", levelFiles[lvl]} }.dump(1));
+            allNames.emplace_back(toWide(prjName));
+        }
+
+        allNames.insert(allNames.end(), nutNames.begin(), nutNames.end());
+    }
+
+    // manifests/: оба написания ключей, переменные окружения и точки монтирования - manifestVars штук
+    {
+        nlohmann::json jVars      = nlohmann::json::object();
+        nlohmann::json jClearVars = nlohmann::json::array();
+        nlohmann::json jMounts    = nlohmann::json::array();
+        for(std::size_t i=0; i!=opts.manifestVars; ++i)
+        {
+            jVars["BENCH_VAR_" + makeNumber(i, 5)] = "value of variable " + std::to_string(i);
+            if (i%10==9)
+            {
+                jClearVars.push_back("BENCH_VAR_" + makeNumber(i, 5));
+            }
+
+            jMounts.push_back(nlohmann::json{ {"name", "mp_" + makeNumber(i, 5)}, {"target", "/opt/benchapp/mp_" + makeNumber(i, 5)} });
+        }
+
+        nlohmann::json jManifest =
+        { {"app-group", "bench"}
+        , {"window", { {"title", "Benchmark app"}, {"icon", appNameA}, {"allow-maximize", true}, {"allowResize", true}
+                     , {"show-status-bar", false}, {"width", "800px"}, {"height", "600"}, {"min-width", "50%"}
+                     }
+          }
+        , {"startup", { {"centerWindow", true}, {"run-maximized", false} } }
+        , {"hotkeys", { {"allow-reload-script", true}, {"allowFullscreen", true} } }
+        , {"variables", jVars}
+        , {"clear-variables", jClearVars}
+        , {"filesystem", { {"mount-home", true}, {"homeMountPointName", "home"}, {"clear-existing-mount-points", true}
+                         , {"mountPoints", jMounts}
+                         }
+          }
+        };
+
+        std::string manifestName = appNameA + ".dotnut-manifest.json";
+        ok = ok && writeFile(std::filesystem::path("manifests") / manifestName, jManifest.dump(1));
+        allNames.emplace_back(toWide(manifestName));
+    }
+
+    // assets/: файлы по 64 в каталоге, плюс иконки приложения для Windows и Linux
+    {
+        for(std::size_t i=0; i!=opts.numAssets; ++i)
+        {
+            std::string relName = "data/d" + makeNumber(i/64u, 3) + "/asset_" + makeNumber(i, 5) + ".bin";
+            ok = ok && writeFile(std::filesystem::path("assets") / relName, makeBinaryData(opts.assetSize, (std::uint32_t)i));
+            assetNames.emplace_back(toWide(relName));
+        }
+
+        const std::vector<std::string> iconNames = { "icons/windows/" + appNameA + ".ico", "icons/linux/" + appNameA
+                                                   , "icons/windows/default_icon.ico"    , "icons/linux/default_icon"
+                                                   };
+        for(const auto &iconName : iconNames)
+        {
+            ok = ok && writeFile(std::filesystem::path("assets") / iconName, makeBinaryData(opts.assetSize, 0x1C0Eu));
+            allNames.emplace_back(toWide(iconName));
+        }
+
+        allNames.insert(allNames.end(), assetNames.begin(), assetNames.end());
+    }
+
+    // conf/: JSON-объекты по confKeys ключей
+    {
+        for(std::size_t i=0; i!=opts.numConfs; ++i)
+        {
+            nlohmann::json jConf = nlohmann::json::object();
+            for(std::size_t k=0; k!=opts.confKeys; ++k)
+            {
+                jConf["key_" + makeNumber(k, 5)] = { {"id", k}, {"name", "conf " + std::to_string(i) + " item " + std::to_string(k)}, {"enabled", (k%2)==0} };
+            }
+
+            std::string relName = "conf_" + makeNumber(i, 4) + ".json";
+            ok = ok && writeFile(std::filesystem::path("conf") / relName, jConf.dump(1));
+            confNames.emplace_back(toWide(relName));
+        }
+
+        allNames.insert(allNames.end(), confNames.begin(), confNames.end());
+    }
+
+    // translations/: переводы приложения и общие, по trEntries строк
+    {
+        nlohmann::json jMessages = nlohmann::json::object();
+        for(std::size_t i=0; i!=opts.trEntries; ++i)
+        {
+            jMessages["msg_" + makeNumber(i, 5)] = "Message number " + std::to_string(i);
+        }
+
+        nlohmann::json jTr = { {"en-US", { {"bench", jMessages} } } };
+
+        ok = ok && writeFile(std::filesystem::path("translations") / (appNameA + ".json"), jTr.dump(1));
+        ok = ok && writeFile(std::filesystem::path("translations") / "common.json", jTr.dump(1));
+        allNames.emplace_back(appName + L".json");
+        allNames.emplace_back(L"common.json");
+    }
+
+    return ok ? ErrorCode::ok : ErrorCode::genericError;
+}
+
+//----------------------------------------------------------------------------
+void SyntheticTree::remove()
+{
+    if (rootPath.empty())
+    {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(rootPath, ec);
+}
+
+//----------------------------------------------------------------------------
+BenchEnvironment makeBenchEnvironment(const SyntheticTree &tree, const BenchOptions &opts)
+{
+    BenchEnvironment env;
+
+    env.pFs = std::make_shared<marty_virtual_fs::FileSystemImpl>();
+
+    auto pVfs = std::static_pointer_cast<marty_virtual_fs::IVirtualFs>(env.pFs);
+    pVfs->clearMounts();
+    for(const auto &mpName : SyntheticTree::getMountPointNames())
+    {
+        pVfs->addMountPoint(mpName, tree.getMountTarget(mpName));
+    }
+
+    env.pAm = std::make_shared<marty_assets_manager::AssetsManager>(std::static_pointer_cast<marty_virtual_fs::IFileSystem>(env.pFs));
+    env.pAm->setProjectName(tree.appName);
+
+    for(const auto &mpName : SyntheticTree::getMountPointNames())
+    {
+        env.pAm->setNativeMountPoint(mpName, tree.getMountTarget(mpName));
+    }
+
+    if (opts.mountIndexes)
+    {
+        env.pAm->buildMountIndexes();
+    }
+
+    return env;
+}
+
+//----------------------------------------------------------------------------
+BenchResult& BenchReport::add(const std::string &suite, const std::string &name, const std::string &mode)
+{
+    results.emplace_back();
+    BenchResult &res = results.back();
+    res.suite = suite;
+    res.name  = name;
+    res.mode  = mode;
+    return res;
+}
+
+//----------------------------------------------------------------------------
+void BenchReport::printTable() const
+{
+    std::printf("%-8s %-28s %-20s %10s %14s %14s %8s %8s\n", "suite", "case", "mode", "ops", "ns/op", "bytes", "hits", "misses");
+
+    for(const auto &res : results)
+    {
+        std::printf( "%-8s %-28s %-20s %10llu %14.1f %14llu %8llu %8llu"
+                   , res.suite.c_str(), res.name.c_str(), res.mode.c_str()
+                   , (unsigned long long)res.ops, res.getNsPerOp(), (unsigned long long)res.bytes
+                   , (unsigned long long)res.cacheHits, (unsigned long long)res.cacheMisses
+                   );
+
+        if (!res.extra.empty())
+        {
+            std::printf(" %s", res.extra.dump().c_str());
+        }
+
+        std::printf("\n");
+    }
+}
+
+//----------------------------------------------------------------------------
+nlohmann::json BenchReport::toJson(const BenchOptions &opts) const
+{
+    nlohmann::json jResults = nlohmann::json::array();
+    for(const auto &res : results)
+    {
+        jResults.push_back( { {"suite"      , res.suite}
+                            , {"case"       , res.name}
+                            , {"mode"       , res.mode}
+                            , {"ops"        , res.ops}
+                            , {"totalNs"    , res.totalNs}
+                            , {"nsPerOp"    , res.getNsPerOp()}
+                            , {"bytes"      , res.bytes}
+                            , {"cacheHits"  , res.cacheHits}
+                            , {"cacheMisses", res.cacheMisses}
+                            , {"extra"      , res.extra}
+                            }
+                          );
+    }
+
+    nlohmann::json jOptions =
+    { {"iterations"  , opts.iterations}
+    , {"mountIndexes", opts.mountIndexes}
+    , {"nuts"        , opts.numNuts}
+    , {"nutSize"     , opts.nutSize}
+    , {"includeDepth", opts.includeDepth}
+    , {"manifestVars", opts.manifestVars}
+    , {"assets"      , opts.numAssets}
+    , {"assetSize"   , opts.assetSize}
+    , {"confs"       , opts.numConfs}
+    , {"confKeys"    , opts.confKeys}
+    , {"trEntries"   , opts.trEntries}
+    , {"threads"     , opts.threads}
+    , {"stressMs"    , opts.stressMs}
+    , {"names"       , opts.names}
+    };
+
+    return nlohmann::json{ {"options", jOptions}, {"failed", failed}, {"results", jResults} };
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_bench
+
@@ -0,0 +1,190 @@
+/*! \file
+    \brief Common part of marty_assets_manager benchmarks: options, synthetic trees, timing and results
+*/
+
+#pragma once
+
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+//
+#include "nlohmann/json.hpp"
+//
+#include "marty_virtual_fs/filesystem_impl.h"
+#include "marty_virtual_fs/i_virtual_fs.h"
+
+//
+#include "assets_manager.h"
+
+
+namespace marty_assets_bench {
+
+
+using marty_assets_manager::ErrorCode;
+using marty_assets_manager::AssetsApi;
+
+typedef std::chrono::steady_clock   Clock;
+
+
+
+//----------------------------------------------------------------------------
+// Параметры запуска, задаются в командной строке как --name=value (см. bench_main.cpp)
+struct BenchOptions
+{
+    std::filesystem::path    root           ; // Куда генерировать дерево, пусто - во временный каталог
+    bool                     keepTree       = false; // Не удалять дерево после прогона
+    bool                     mountIndexes   = false; // Строить индексы точек монтирования (buildMountIndexes) для каждого менеджера
+
+    std::size_t              iterations     = 5;
+
+    std::size_t              numNuts        = 200;
+    std::size_t              nutSize        = 4096;
+    std::size_t              includeDepth   = 3; // Глубина цепочки подключаемых файлов проекта
+    std::size_t              manifestVars   = 100; // Переменных окружения и точек монтирования в манифесте
+    std::size_t              numAssets      = 500;
+    std::size_t              assetSize      = 16384;
+    std::size_t              numConfs       = 50;
+    std::size_t              confKeys       = 100;
+    std::size_t              trEntries      = 500;
+
+    std::size_t              threads        = 4; // Потоков-читателей в stress
+    std::size_t              stressMs       = 2000; // Длительность stress
+    std::size_t              names          = 1000000; // Синтетических имён в nuttype
+
+}; // struct BenchOptions
+
+//----------------------------------------------------------------------------
+// Синтетическое дерево приложения: nuts/, manifests/, assets/, conf/, translations/ - как после configureNutAssetsFilesystem
+struct SyntheticTree
+{
+    std::filesystem::path        rootPath   ;
+    std::wstring                 appName    = L"benchapp";
+
+    std::vector<std::wstring>    nutNames   ; // Относительно /nuts
+    std::vector<std::wstring>    assetNames ; // Относительно /assets
+    std::vector<std::wstring>    confNames  ; // Относительно /conf
+    std::vector<std::wstring>    allNames   ; // Имена всех созданных файлов - для detectFileNutType
+
+    std::uint64_t                totalBytes = 0;
+
+
+    static const std::vector<std::wstring>& getMountPointNames()
+    {
+        static const std::vector<std::wstring> names = { L"conf", L"nuts", L"assets", L"translations", L"manifests" };
+        return names;
+    }
+
+    std::wstring getMountTarget(const std::wstring &mountPointName) const
+    {
+        return (rootPath / mountPointName).wstring();
+    }
+
+    // Создаёт дерево заново, содержимое файлов детерминировано
+    ErrorCode generate(const BenchOptions &opts);
+
+    void remove();
+
+protected:
+
+    bool writeFile(const std::filesystem::path &relName, const std::string &data);
+
+}; // struct SyntheticTree
+
+//----------------------------------------------------------------------------
+// Менеджер ассетов над синтетическим деревом - VFS и привязка точек монтирования к каталогам,
+// как у configureNutAssetsFilesystem/configureNutAssetsNativeMountPoints, но без IAppPaths
+struct BenchEnvironment
+{
+    std::shared_ptr<marty_virtual_fs::FileSystemImpl>         pFs;
+    std::shared_ptr<marty_assets_manager::IAssetsManager>     pAm;
+
+}; // struct BenchEnvironment
+
+BenchEnvironment makeBenchEnvironment(const SyntheticTree &tree, const BenchOptions &opts);
+
+//----------------------------------------------------------------------------
+struct BenchResult
+{
+    std::string      suite     ;
+    std::string      name      ;
+    std::string      mode      ; // cold/warm или вариант реализации
+    std::uint64_t    ops       = 0; // Сколько операций замерено
+    std::uint64_t    totalNs   = 0;
+    std::uint64_t    bytes     = 0; // Прочитано из хранилища (по ApiStats)
+    std::uint64_t    cacheHits = 0;
+    std::uint64_t    cacheMisses = 0;
+    nlohmann::json   extra     = nlohmann::json::object(); // Значения, специфичные для набора
+
+    double getNsPerOp() const
+    {
+        return ops ? (double)totalNs/(double)ops : 0.0;
+    }
+
+}; // struct BenchResult
+
+//----------------------------------------------------------------------------
+// Результаты всех наборов: таблица в stdout и JSON для сравнения прогонов
+struct BenchReport
+{
+    std::vector<BenchResult>    results;
+    bool                        failed  = false; // Набор обнаружил неверный результат - код возврата ненулевой
+
+    BenchResult& add(const std::string &suite, const std::string &name, const std::string &mode);
+
+    void printTable() const;
+
+    nlohmann::json toJson(const BenchOptions &opts) const;
+
+}; // struct BenchReport
+
+//----------------------------------------------------------------------------
+inline
+std::uint64_t elapsedNs(Clock::time_point start)
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now()-start).count();
+    return ns>0 ? (std::uint64_t)ns : 0u;
+}
+
+// Статистика вызова (байты, попадания и промахи кэшей) переносится в результат.
+// Статистику ведёт AssetsManager (IAssetsManagerDiagnostics), другие реализации в бенчмарке не используются
+inline
+void addApiStats(BenchResult &res, const marty_assets_manager::IAssetsManager &am, AssetsApi api)
+{
+    auto stats = marty_assets_manager::getAssetsManagerDiagnostics(&am)->getApiStats(api);
+    res.bytes       += stats.bytes;
+    res.cacheHits   += stats.cacheHits;
+    res.cacheMisses += stats.cacheMisses;
+}
+
+inline
+void resetApiStats(marty_assets_manager::IAssetsManager &am)
+{
+    marty_assets_manager::getAssetsManagerDiagnostics(&am)->resetApiStats();
+}
+
+//----------------------------------------------------------------------------
+// Наборы замеров, каждый в своём .cpp. Возвращают false, если что-то пошло не так
+typedef std::function<bool(const BenchOptions&, const SyntheticTree&, BenchReport&)>  BenchSuiteFn;
+
+bool runAssetsBench(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report);
+bool runConfigStress(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report);
+bool runNutAllocBench(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report);
+bool runNutTypeBench(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report);
+bool runManifestBench(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report);
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_bench
+
@@ -0,0 +1,222 @@
+/*! \file
+    \brief Concurrent readers against reconfiguration of the same AssetsManager (RCU config snapshots)
+*/
+
+#include "bench_common.h"
+
+#include <atomic>
+#include <thread>
+
+
+namespace marty_assets_bench {
+
+
+using marty_assets_manager::IAssetsManager;
+
+
+
+//----------------------------------------------------------------------------
+namespace {
+
+bool copyDirectory(const std::filesystem::path &from, const std::filesystem::path &to)
+{
+    std::error_code ec;
+    std::filesystem::remove_all(to, ec);
+    std::filesystem::copy(from, to, std::filesystem::copy_options::recursive, ec);
+    return !ec;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+// threads потоков читают readAssetsDataFile/readConfJson и сверяют результат с эталоном, прочитанным до старта.
+// Один поток в это время перенастраивает менеджер: setSerializeFileSystemAccess, переключение точек монтирования
+// между каталогом, его копией и упакованным архивом, сброс привязок, индексы, бюджет и сброс кэшей.
+// Содержимое во всех вариантах одно и то же, так что любое расхождение или ошибка чтения - ошибка.
+// Набор рассчитан и на запуск под ThreadSanitizer
+bool runConfigStress(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report)
+{
+    BenchResult &res = report.add("stress", "readers+reconfig", std::to_string(opts.threads) + " threads");
+
+    auto fail = [&](const char *what)
+                {
+                    std::fprintf(stderr, "stress: %s\n", what);
+                    report.failed = true;
+                    return false;
+                };
+
+    if (tree.assetNames.empty() || tree.confNames.empty())
+    {
+        return fail("tree has no assets or confs");
+    }
+
+    // Альтернативные источники тех же данных
+    const std::wstring assetsDir     = tree.getMountTarget(L"assets");
+    const std::wstring confDir       = tree.getMountTarget(L"conf");
+    const std::wstring assetsMirror  = (tree.rootPath / "_stress_assets").wstring();
+    const std::wstring confMirror    = (tree.rootPath / "_stress_conf"  ).wstring();
+    const std::wstring assetsArchive = (tree.rootPath / "_stress_assets.assetpack").wstring();
+
+    if ( !copyDirectory(assetsDir, assetsMirror) || !copyDirectory(confDir, confMirror)
+      || marty_assets_manager::buildPackedArchiveFromDirectory(assetsDir, assetsArchive, marty_assets_manager::packed_archive::codecNone)!=ErrorCode::ok
+       )
+    {
+        return fail("failed to prepare mirror directories and archive");
+    }
+
+    BenchEnvironment env = makeBenchEnvironment(tree, opts);
+    IAssetsManager &am = *env.pAm;
+
+    std::vector< std::vector<std::uint8_t> > expectedAssets(tree.assetNames.size());
+    for(std::size_t i=0; i!=tree.assetNames.size(); ++i)
+    {
+        if (am.readAssetsDataFile(tree.assetNames[i], expectedAssets[i])!=ErrorCode::ok)
+        {
+            return fail("failed to read reference assets");
+        }
+    }
+
+    std::vector<nlohmann::json> expectedConfs(tree.confNames.size());
+    for(std::size_t i=0; i!=tree.confNames.size(); ++i)
+    {
+        if (am.readConfJson(tree.confNames[i], expectedConfs[i])!=ErrorCode::ok)
+        {
+            return fail("failed to read reference confs");
+        }
+    }
+
+    std::atomic<bool>           stop      {false};
+    std::atomic<std::uint64_t>  readOps   {0};
+    std::atomic<std::uint64_t>  errors    {0};
+    std::atomic<std::uint64_t>  mismatches{0};
+    std::atomic<std::uint64_t>  writerOps {0};
+
+    auto reader = [&](std::size_t threadIdx)
+                  {
+                      std::uint32_t rnd = 0x9E3779B9u*(std::uint32_t)(threadIdx+1);
+                      std::uint64_t ops = 0;
+
+                      std::vector<std::uint8_t> data;
+                      while(!stop.load(std::memory_order_relaxed))
+                      {
+                          rnd = rnd*1664525u + 1013904223u;
+
+                          if ((rnd>>28)<12) // 3/4 - ассеты
+                          {
+                              std::size_t idx = (rnd>>8)%tree.assetNames.size();
+                              if (am.readAssetsDataFile(tree.assetNames[idx], data)!=ErrorCode::ok)
+                              {
+                                  errors.fetch_add(1, std::memory_order_relaxed);
+                              }
+                              else if (data!=expectedAssets[idx])
+                              {
+                                  mismatches.fetch_add(1, std::memory_order_relaxed);
+                              }
+                          }
+                          else
+                          {
+                              std::size_t idx = (rnd>>8)%tree.confNames.size();
+                              nlohmann::json j;
+                              if (am.readConfJson(tree.confNames[idx], j)!=ErrorCode::ok)
+                              {
+                                  errors.fetch_add(1, std::memory_order_relaxed);
+                              }
+                              else if (j!=expectedConfs[idx])
+                              {
+                                  mismatches.fetch_add(1, std::memory_order_relaxed);
+                              }
+                          }
+
+                          ++ops;
+                      }
+
+                      readOps.fetch_add(ops, std::memory_order_relaxed);
+                  };
+
+    auto writer = [&]()
+                  {
+                      std::uint64_t step = 0;
+                      while(!stop.load(std::memory_order_relaxed))
+                      {
+                          switch(step%8)
+                          {
+                              case 0: am.setSerializeFileSystemAccess(!am.getSerializeFileSystemAccess()); break;
+                              case 1: am.setNativeMountPoint(L"assets", (step/8)%2 ? assetsDir : assetsMirror);
+                                      am.setNativeMountPoint(L"conf"  , (step/8)%2 ? confDir   : confMirror  );
+                                      break;
+                              case 2: am.mountPackedArchive(L"assets", assetsArchive); break;
+                              case 3: am.unmountPackedArchives(); break;
+                              case 4: am.setAssetsCacheBudget((step/8)%2 ? 0u : (std::size_t)16u*1024u*1024u);
+                                      am.clearConfJsonCache();
+                                      break;
+                              case 5: am.buildMountIndexes(); break;
+                              case 6: am.dropMountIndexes(); am.clearLookupCache(); break;
+                              case 7: am.clearNativeMountPoints(); // Пока привязок нет, чтение идёт через VFS
+                                      for(const auto &mpName : SyntheticTree::getMountPointNames())
+                                      {
+                                          am.setNativeMountPoint(mpName, tree.getMountTarget(mpName));
+                                      }
+                                      am.setProjectName(tree.appName);
+                                      break;
+                          }
+
+                          ++step;
+                          std::this_thread::yield();
+                      }
+
+                      writerOps.store(step, std::memory_order_relaxed);
+                  };
+
+    const std::size_t numThreads = opts.threads ? opts.threads : 1u;
+
+    auto start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for(std::size_t i=0; i!=numThreads; ++i)
+    {
+        threads.emplace_back(reader, i);
+    }
+    threads.emplace_back(writer);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(opts.stressMs));
+    stop.store(true, std::memory_order_relaxed);
+
+    for(auto &t : threads)
+    {
+        t.join();
+    }
+
+    res.totalNs = elapsedNs(start)*numThreads; // ns/op - время одного чтения в одном потоке
+    res.ops     = readOps.load();
+    addApiStats(res, am, AssetsApi::readAssetsDataFile);
+    addApiStats(res, am, AssetsApi::readConfJson);
+
+    res.extra["threads"   ] = numThreads;
+    res.extra["writerOps" ] = writerOps.load();
+    res.extra["errors"    ] = errors.load();
+    res.extra["mismatches"] = mismatches.load();
+
+    std::error_code ec;
+    std::filesystem::remove_all(assetsMirror, ec);
+    std::filesystem::remove_all(confMirror, ec);
+    std::filesystem::remove(assetsArchive, ec);
+
+    if (errors.load() || mismatches.load())
+    {
+        return fail("read errors or mismatching data under reconfiguration");
+    }
+
+    if (!res.ops || !writerOps.load())
+    {
+        return fail("readers or writer made no progress");
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_bench
+
@@ -0,0 +1,231 @@
+/*! \file
+    \brief marty_assets_manager benchmark runner
+
+    marty_assets_bench [--suite=name[,name...]] [--root=dir] [--keep] [--mount-indexes] [--json=file]
+                       [--iterations=N] [--nuts=N] [--nut-size=N] [--include-depth=N] [--manifest-vars=N]
+                       [--assets=N] [--asset-size=N] [--confs=N] [--conf-keys=N] [--tr-entries=N]
+                       [--threads=N] [--stress-ms=N] [--names=N]
+*/
+
+#include "bench_common.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+
+using namespace marty_assets_bench;
+
+
+
+//----------------------------------------------------------------------------
+static
+const std::vector< std::pair<std::string, BenchSuiteFn> >& getBenchSuites()
+{
+    static const std::vector< std::pair<std::string, BenchSuiteFn> > suites =
+    { { "assets"  , runAssetsBench   }
+    , { "stress"  , runConfigStress  }
+    , { "nutalloc", runNutAllocBench }
+    , { "nuttype" , runNutTypeBench  }
+    , { "manifest", runManifestBench }
+    };
+
+    return suites;
+}
+
+//----------------------------------------------------------------------------
+static
+const std::vector< std::pair<std::string, std::size_t BenchOptions::*> >& getSizeOptions()
+{
+    static const std::vector< std::pair<std::string, std::size_t BenchOptions::*> > options =
+    { { "iterations"   , &BenchOptions::iterations   }
+    , { "nuts"         , &BenchOptions::numNuts      }
+    , { "nut-size"     , &BenchOptions::nutSize      }
+    , { "include-depth", &BenchOptions::includeDepth }
+    , { "manifest-vars", &BenchOptions::manifestVars }
+    , { "assets"       , &BenchOptions::numAssets    }
+    , { "asset-size"   , &BenchOptions::assetSize    }
+    , { "confs"        , &BenchOptions::numConfs     }
+    , { "conf-keys"    , &BenchOptions::confKeys     }
+    , { "tr-entries"   , &BenchOptions::trEntries    }
+    , { "threads"      , &BenchOptions::threads      }
+    , { "stress-ms"    , &BenchOptions::stressMs     }
+    , { "names"        , &BenchOptions::names        }
+    };
+
+    return options;
+}
+
+//----------------------------------------------------------------------------
+static
+void printUsage()
+{
+    std::printf("Usage: marty_assets_bench [--suite=name[,name...]] [--root=dir] [--keep] [--mount-indexes] [--json=file]\n");
+    std::printf("                          [--name=N ...]\n");
+    std::printf("Suites:");
+    for(const auto &s : getBenchSuites())
+    {
+        std::printf(" %s", s.first.c_str());
+    }
+    std::printf("\nSizes (--name=N):");
+    for(const auto &o : getSizeOptions())
+    {
+        std::printf(" %s", o.first.c_str());
+    }
+    std::printf("\n");
+}
+
+//----------------------------------------------------------------------------
+static
+bool parseArgs(int argc, char *argv[], BenchOptions &opts, std::vector<std::string> &suites, std::string &jsonFile)
+{
+    for(int i=1; i<argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--")!=0)
+        {
+            return false;
+        }
+
+        std::string name  = arg.substr(2);
+        std::string value;
+        auto eqPos = name.find('=');
+        if (eqPos!=name.npos)
+        {
+            value = name.substr(eqPos+1);
+            name.erase(eqPos);
+        }
+
+        if (name=="keep")
+        {
+            opts.keepTree = true;
+        }
+        else if (name=="mount-indexes")
+        {
+            opts.mountIndexes = true;
+        }
+        else if (name=="root")
+        {
+            opts.root = value;
+        }
+        else if (name=="json")
+        {
+            jsonFile = value;
+        }
+        else if (name=="suite")
+        {
+            for(std::size_t pos=0; pos<=value.size(); )
+            {
+                auto commaPos = value.find(',', pos);
+                if (commaPos==value.npos)
+                {
+                    commaPos = value.size();
+                }
+                if (commaPos!=pos)
+                {
+                    suites.emplace_back(value.substr(pos, commaPos-pos));
+                }
+                pos = commaPos+1;
+            }
+        }
+        else
+        {
+            bool found = false;
+            for(const auto &o : getSizeOptions())
+            {
+                if (o.first==name && !value.empty())
+                {
+                    opts.*o.second = (std::size_t)std::strtoull(value.c_str(), 0, 10);
+                    found = true;
+                }
+            }
+
+            if (!found)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    BenchOptions              opts;
+    std::vector<std::string>  suites;
+    std::string               jsonFile;
+
+    if (!parseArgs(argc, argv, opts, suites, jsonFile))
+    {
+        printUsage();
+        return 2;
+    }
+
+    if (suites.empty())
+    {
+        for(const auto &s : getBenchSuites())
+        {
+            suites.emplace_back(s.first);
+        }
+    }
+
+    SyntheticTree tree;
+    if (tree.generate(opts)!=ErrorCode::ok)
+    {
+        std::fprintf(stderr, "Failed to generate synthetic tree in '%s'\n", tree.rootPath.string().c_str());
+        tree.remove();
+        return 1;
+    }
+
+    std::printf( "Tree: %s, %zu nuts, %zu assets, %zu confs, %llu bytes\n\n"
+               , tree.rootPath.string().c_str(), tree.nutNames.size(), tree.assetNames.size(), tree.confNames.size()
+               , (unsigned long long)tree.totalBytes
+               );
+
+    BenchReport report;
+
+    for(const auto &suiteName : suites)
+    {
+        bool found = false;
+        for(const auto &s : getBenchSuites())
+        {
+            if (s.first==suiteName)
+            {
+                found = true;
+                if (!s.second(opts, tree, report))
+                {
+                    report.failed = true;
+                }
+            }
+        }
+
+        if (!found)
+        {
+            std::fprintf(stderr, "Unknown suite '%s'\n", suiteName.c_str());
+            report.failed = true;
+        }
+    }
+
+    report.printTable();
+
+    if (!jsonFile.empty())
+    {
+        std::ofstream ofs(jsonFile, std::ios::trunc);
+        ofs << report.toJson(opts).dump(2) << "\n";
+        if (!ofs)
+        {
+            std::fprintf(stderr, "Failed to write '%s'\n", jsonFile.c_str());
+            report.failed = true;
+        }
+    }
+
+    if (!opts.keepTree)
+    {
+        tree.remove();
+    }
+
+    return report.failed ? 1 : 0;
+}
+
@@ -0,0 +1,537 @@
+/*! \file
+    \brief Manifest parsing: the former findJsonAnyChild chains with subtree copies vs the field tables (json_schema.h)
+*/
+
+#include "bench_common.h"
+
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace marty_assets_bench {
+
+
+using marty_assets_manager::NutManifestW;
+using marty_assets_manager::NutManifestSizeUnits;
+using marty_assets_manager::WindowSize;
+
+
+
+//----------------------------------------------------------------------------
+namespace {
+
+// Доступ к таблицам полей манифеста - они у AssetsManager защищённые
+struct ManifestSchemaAccess : public marty_assets_manager::AssetsManager
+{
+    using marty_assets_manager::AssetsManager::AssetsManager;
+    using marty_assets_manager::AssetsManager::getNutManifestSchema;
+
+}; // struct ManifestSchemaAccess
+
+// findJsonAnyChild в том виде, в каком его использовал прежний разбор: до двух поисков на ключ
+nlohmann::json::iterator legacyFindAnyChild(nlohmann::json &j, const char *n1, const char *n2 = 0)
+{
+    auto iter = j.find(n1);
+    if (iter==j.end() && n2)
+    {
+        iter = j.find(n2);
+    }
+    return iter;
+}
+
+//----------------------------------------------------------------------------
+// Прежний AssetsManager::updateNutManifestImpl после разбора текста, для wchar_t. Порядок поисков, копии поддеревьев
+// (auto jWindow = jiter.value() и т.п.) и проверки сохранены; decodeText/filenameFromText - через IFileSystem
+void legacyApplyManifest(const marty_virtual_fs::IFileSystem &fs, nlohmann::json &jManifest, NutManifestW &manifest)
+{
+    auto jiter = legacyFindAnyChild(jManifest, "appGroup", "app-group");
+    if (jiter!=jManifest.end())
+    {
+        manifest.appGroup = fs.decodeText(jiter->get<std::string>());
+    }
+
+    jiter = legacyFindAnyChild(jManifest, "graphicsMode", "graphics-mode");
+    if (jiter!=jManifest.end())
+    {
+        auto newVal = marty_assets_manager::enum_deserialize_NutManifestGraphicsMode(jiter->get<std::string>(), marty_assets_manager::NutManifestGraphicsMode::invalid);
+        if (newVal!=marty_assets_manager::NutManifestGraphicsMode::invalid)
+        {
+            manifest.manifestGraphicsMode = newVal;
+        }
+    }
+
+    jiter = legacyFindAnyChild(jManifest, "window");
+    if (jiter!=jManifest.end())
+    {
+        if (!jiter->is_object())
+        {
+            throw std::runtime_error("'window' node is not an object");
+        }
+
+        auto jWindow = jiter.value();
+
+        auto textField = [&](const char *n1, std::wstring &val)
+                         {
+                             auto it = legacyFindAnyChild(jWindow, n1);
+                             if (it!=jWindow.end())
+                             {
+                                 val = fs.decodeText(it->get<std::string>());
+                             }
+                         };
+
+        auto boolField = [&](const char *n1, const char *n2, bool &val)
+                         {
+                             auto it = legacyFindAnyChild(jWindow, n1, n2);
+                             if (it!=jWindow.end())
+                             {
+                                 val = it->get<bool>();
+                             }
+                         };
+
+        textField("title", manifest.window.title);
+        textField("icon" , manifest.window.iconName);
+        boolField("allowMaximize" , "allow-maximize"  , manifest.window.allowMaximize );
+        boolField("allowMinimize" , "allow-minimize"  , manifest.window.allowMinimize );
+        boolField("allowResize"   , "allow-resize"    , manifest.window.allowResize   );
+        boolField("showTitle"     , "show-title"      , manifest.window.showTitle     );
+        boolField("showSysMenu"   , "show-sys-menu"   , manifest.window.showSysMenu   );
+        boolField("showStatusBar" , "show-status-bar" , manifest.window.showStatusBar );
+        boolField("showClientEdge", "show-client-edge", manifest.window.showClientEdge);
+
+        static
+        const std::unordered_map<std::string, NutManifestSizeUnits> unitsMap =
+        { {"unknown", NutManifestSizeUnits::unknown }
+        , {"px", NutManifestSizeUnits::px }
+        , {"pixel", NutManifestSizeUnits::px }
+        , {"pixels", NutManifestSizeUnits::px }
+        , {"dbu", NutManifestSizeUnits::dbu }
+        , {"DialogBaseUnit", NutManifestSizeUnits::dbu }
+        , {"DialogBaseUnits", NutManifestSizeUnits::dbu }
+        , {"du", NutManifestSizeUnits::du }
+        , {"dtu", NutManifestSizeUnits::du }
+        , {"dialogTemplateUnit", NutManifestSizeUnits::du }
+        , {"dialogTemplateUnits", NutManifestSizeUnits::du }
+        , {"percent", NutManifestSizeUnits::percent }
+        , {"percents", NutManifestSizeUnits::percent }
+        , {"%", NutManifestSizeUnits::percent }
+        };
+
+        auto sizeField = [&](const char *n1, const char *n2, WindowSize::ValueWithUnits &val)
+                         {
+                             auto it = legacyFindAnyChild(jWindow, n1, n2);
+                             if (it!=jWindow.end())
+                             {
+                                 val = WindowSize::ValueWithUnits::fromString(it->get<std::string>(), unitsMap, NutManifestSizeUnits::px, true);
+                             }
+                         };
+
+        sizeField("width"    , 0           , manifest.window.size.xSize   );
+        sizeField("height"   , 0           , manifest.window.size.ySize   );
+        sizeField("minWidth" , "min-width" , manifest.window.sizeMin.xSize);
+        sizeField("minHeight", "min-height", manifest.window.sizeMin.ySize);
+    }
+
+    jiter = legacyFindAnyChild(jManifest, "startup");
+    if (jiter!=jManifest.end())
+    {
+        if (!jiter->is_object())
+        {
+            throw std::runtime_error("'startup' node is not an object");
+        }
+
+        auto jStartup = jiter.value();
+        for(const auto &f : { std::make_pair(std::make_pair("runFullscreen", "run-fullscreen"), &manifest.startupManifest.runFullscreen)
+                            , std::make_pair(std::make_pair("runMaximized" , "run-maximized" ), &manifest.startupManifest.runMaximized )
+                            , std::make_pair(std::make_pair("centerWindow" , "center-window" ), &manifest.startupManifest.centerWindow )
+                            }
+           )
+        {
+            auto it = legacyFindAnyChild(jStartup, f.first.first, f.first.second);
+            if (it!=jStartup.end())
+            {
+                *f.second = it->get<bool>();
+            }
+        }
+    }
+
+    jiter = legacyFindAnyChild(jManifest, "hotkeys");
+    if (jiter!=jManifest.end())
+    {
+        if (!jiter->is_object())
+        {
+            throw std::runtime_error("'hotkeys' node is not an object");
+        }
+
+        auto jHotkeys = jiter.value();
+        for(const auto &f : { std::make_pair(std::make_pair("allowReloadScript", "allow-reload-script"), &manifest.hotkeysManifest.allowReloadScript)
+                            , std::make_pair(std::make_pair("allowFullscreen"  , "allow-fullscreen"   ), &manifest.hotkeysManifest.allowFullscreen  )
+                            }
+           )
+        {
+            auto it = legacyFindAnyChild(jHotkeys, f.first.first, f.first.second);
+            if (it!=jHotkeys.end())
+            {
+                *f.second = it->get<bool>();
+            }
+        }
+    }
+
+    jiter = legacyFindAnyChild(jManifest, "importEnvironmentVariables", "import-environment-variables");
+    if (jiter!=jManifest.end())
+    {
+        if (jiter->is_boolean())
+        {
+            std::vector<std::pair<std::string,std::string> > lst;
+            umba::env::getEnvVarsList(lst);
+            for(const auto &p: lst)
+            {
+                manifest.envVars[fs.decodeText(p.first)] = fs.decodeText(p.second);
+            }
+        }
+        else if (jiter->is_array())
+        {
+            auto jImportVariables = jiter.value();
+            for(nlohmann::json::iterator it=jImportVariables.begin(); it!=jImportVariables.end(); ++it)
+            {
+                auto varName = fs.decodeText(it->get<std::string>());
+                std::string val;
+                if (umba::env::getVar(fs.encodeText(varName), val))
+                {
+                    manifest.envVars[varName] = fs.decodeText(val);
+                }
+            }
+        }
+        else
+        {
+            throw std::runtime_error("'clearVariables' node is not an array nor boolean");
+        }
+    }
+
+    jiter = legacyFindAnyChild(jManifest, "clearVariables", "clear-variables");
+    if (jiter!=jManifest.end())
+    {
+        if (jiter->is_boolean())
+        {
+            manifest.envVars.clear();
+        }
+        else if (jiter->is_array())
+        {
+            auto jClearVariables = jiter.value();
+            for(nlohmann::json::iterator it=jClearVariables.begin(); it!=jClearVariables.end(); ++it)
+            {
+                manifest.envVars.erase(fs.decodeText(it->get<std::string>()));
+            }
+        }
+        else
+        {
+            throw std::runtime_error("'clearVariables' node is not an array nor boolean");
+        }
+    }
+
+    jiter = jManifest.find("variables");
+    if (jiter!=jManifest.end())
+    {
+        if (!jiter->is_object())
+        {
+            throw std::runtime_error("'variables' node is not an object");
+        }
+
+        auto jVariables = jiter.value();
+        for(auto &el : jVariables.items())
+        {
+            std::string strKey = el.key();
+            std::string strVal = el.value();
+            manifest.envVars[fs.decodeText(strKey)] = fs.decodeText(strVal);
+        }
+    }
+
+    jiter = legacyFindAnyChild(jManifest, "filesystem");
+    if (jiter!=jManifest.end())
+    {
+        if (!jiter->is_object())
+        {
+            throw std::runtime_error("'filesystem' node is not an object");
+        }
+
+        auto jFilesystem = jiter.value();
+        auto &fsm = manifest.filesystemManifest;
+
+        for(const auto &f : { std::make_pair(std::make_pair("mountLocalFilesystem" , "mount-local-filesystem"  ), &fsm.mountLocalFilesystem )
+                            , std::make_pair(std::make_pair("remountOnMediaChanges", "remount-on-media-changes"), &fsm.remountOnMediaChanges)
+                            , std::make_pair(std::make_pair("mountHome"            , "mount-home"              ), &fsm.mountHome            )
+                            , std::make_pair(std::make_pair("mountTemp"            , "mount-temp"              ), &fsm.mountTemp            )
+                            , std::make_pair(std::make_pair("mountLogs"            , "mount-logs"              ), &fsm.mountLogs            )
+                            }
+           )
+        {
+            auto it = legacyFindAnyChild(jFilesystem, f.first.first, f.first.second);
+            if (it!=jFilesystem.end())
+            {
+                *f.second = it->get<bool>();
+            }
+        }
+
+        for(const auto &f : { std::make_pair(std::make_pair("homeMountPointName", "home-mount-point-name"), &fsm.homeMountPointName)
+                            , std::make_pair(std::make_pair("homeMountTarget"   , "home-mount-target"    ), &fsm.homeMountTarget   )
+                            , std::make_pair(std::make_pair("tempMountPointName", "temp-mount-point-name"), &fsm.tempMountPointName)
+                            , std::make_pair(std::make_pair("tempMountTarget"   , "temp-mount-target"    ), &fsm.tempMountTarget   )
+                            , std::make_pair(std::make_pair("logsMountPointName", "logs-mount-point-name"), &fsm.logsMountPointName)
+                            , std::make_pair(std::make_pair("logsMountTarget"   , "logs-mount-target"    ), &fsm.logsMountTarget   )
+                            }
+           )
+        {
+            auto it = legacyFindAnyChild(jFilesystem, f.first.first, f.first.second);
+            if (it!=jFilesystem.end())
+            {
+                *f.second = fs.decodeText(it->get<std::string>());
+            }
+        }
+
+        jiter = legacyFindAnyChild(jFilesystem, "clearExistingMountPoints", "clear-existing-mount-points");
+        if (jiter!=jFilesystem.end() && jiter->get<bool>())
+        {
+            fsm.customMountPoints.clear();
+        }
+
+        jiter = legacyFindAnyChild(jFilesystem, "mountPoints", "mount-points");
+        if (jiter!=jFilesystem.end())
+        {
+            if (!jiter->is_array())
+            {
+                throw std::runtime_error("'filesystem/mountPoints' node is not an array");
+            }
+
+            auto jMountPoints = jiter.value();
+            for(nlohmann::json::iterator jMp=jMountPoints.begin(); jMp!=jMountPoints.end(); ++jMp)
+            {
+                marty_assets_manager::NutFilesystemManifestMountPointInfoT<std::wstring> mpi;
+
+                auto it = jMp->find("name");
+                if (it==jMp->end())
+                {
+                    throw std::runtime_error("'filesystem/mountPoints': mount point must contain 'name' string");
+                }
+                mpi.mountPointName = fs.decodeText(it->get<std::string>());
+
+                it = jMp->find("target");
+                if (it==jMp->end())
+                {
+                    throw std::runtime_error("'filesystem/mountPoints': mount point must contain 'target' string");
+                }
+                mpi.mountPointTargetPath = fs.decodeText(it->get<std::string>());
+
+                fsm.customMountPoints.emplace_back(mpi);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool isSameManifest(const NutManifestW &m1, const NutManifestW &m2)
+{
+    const auto &w1 = m1.window;
+    const auto &w2 = m2.window;
+    const auto &f1 = m1.filesystemManifest;
+    const auto &f2 = m2.filesystemManifest;
+
+    if (f1.customMountPoints.size()!=f2.customMountPoints.size())
+    {
+        return false;
+    }
+
+    for(std::size_t i=0; i!=f1.customMountPoints.size(); ++i)
+    {
+        if ( f1.customMountPoints[i].mountPointName      !=f2.customMountPoints[i].mountPointName
+          || f1.customMountPoints[i].mountPointTargetPath!=f2.customMountPoints[i].mountPointTargetPath
+           )
+        {
+            return false;
+        }
+    }
+
+    return m1.appGroup==m2.appGroup && m1.manifestGraphicsMode==m2.manifestGraphicsMode && m1.envVars==m2.envVars
+        && w1.title==w2.title && w1.iconName==w2.iconName && w1.allowMaximize==w2.allowMaximize && w1.allowMinimize==w2.allowMinimize
+        && w1.allowResize==w2.allowResize && w1.showTitle==w2.showTitle && w1.showSysMenu==w2.showSysMenu
+        && w1.showStatusBar==w2.showStatusBar && w1.showClientEdge==w2.showClientEdge
+        && m1.startupManifest.runFullscreen==m2.startupManifest.runFullscreen && m1.startupManifest.runMaximized==m2.startupManifest.runMaximized
+        && m1.startupManifest.centerWindow==m2.startupManifest.centerWindow
+        && m1.hotkeysManifest.allowReloadScript==m2.hotkeysManifest.allowReloadScript
+        && m1.hotkeysManifest.allowFullscreen==m2.hotkeysManifest.allowFullscreen
+        && f1.mountLocalFilesystem==f2.mountLocalFilesystem && f1.remountOnMediaChanges==f2.remountOnMediaChanges
+        && f1.mountHome==f2.mountHome && f1.homeMountPointName==f2.homeMountPointName && f1.homeMountTarget==f2.homeMountTarget
+        && f1.mountTemp==f2.mountTemp && f1.tempMountPointName==f2.tempMountPointName && f1.tempMountTarget==f2.tempMountTarget
+        && f1.mountLogs==f2.mountLogs && f1.logsMountPointName==f2.logsMountPointName && f1.logsMountTarget==f2.logsMountTarget;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+// Манифест из синтетического дерева и он же, увеличенный в 10 и 100 раз (переменные и точки монтирования).
+// Замеряется разбор уже прочитанного JSON (обход) и полный updateNutManifest с чтением файла; прежний вариант
+// полного разбора - чтение через IFileSystem, nlohmann::json::parse и прежний обход.
+// Результаты обоих разборов сверяются
+bool runManifestBench(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report)
+{
+    const std::filesystem::path manifestsDir = tree.rootPath / "manifests";
+
+    nlohmann::json jBase;
+    {
+        std::ifstream ifs(manifestsDir / (std::filesystem::path(tree.appName).string() + ".dotnut-manifest.json"), std::ios::binary);
+        jBase = nlohmann::json::parse(ifs, nullptr, false);
+    }
+
+    if (!jBase.is_object())
+    {
+        std::fprintf(stderr, "manifest: failed to read synthetic manifest\n");
+        report.failed = true;
+        return false;
+    }
+
+    // Масштабирование: переменные и точки монтирования повторяются с новыми именами. Файлы пишутся
+    // до создания менеджера, чтобы замеры не зависели от того, что он успел закэшировать о каталогах
+    const std::vector<std::size_t> scales = { 1u, 10u, 100u };
+    std::vector<nlohmann::json>    scaledManifests;
+
+    for(std::size_t scale : scales)
+    {
+        nlohmann::json jManifest = jBase;
+        nlohmann::json &jVars    = jManifest["variables"];
+        nlohmann::json &jMounts  = jManifest["filesystem"]["mountPoints"];
+        const nlohmann::json baseVars   = jVars;
+        const nlohmann::json baseMounts = jMounts;
+        for(std::size_t s=1; s<scale; ++s)
+        {
+            for(auto it=baseVars.begin(); it!=baseVars.end(); ++it)
+            {
+                jVars[it.key() + "_" + std::to_string(s)] = it.value();
+            }
+            for(const auto &jMp : baseMounts)
+            {
+                jMounts.push_back({ {"name", jMp.at("name").get<std::string>() + "_" + std::to_string(s)}, {"target", jMp.at("target")} });
+            }
+        }
+
+        const std::string text = jManifest.dump(1);
+        std::ofstream ofs(manifestsDir / ("bench_" + std::to_string(scale) + ".dotnut-manifest.json"), std::ios::binary|std::ios::trunc);
+        ofs.write(text.data(), (std::streamsize)text.size());
+
+        scaledManifests.emplace_back(std::move(jManifest));
+    }
+
+    BenchEnvironment env = makeBenchEnvironment(tree, opts);
+    ManifestSchemaAccess schemaCtx(std::static_pointer_cast<marty_virtual_fs::IFileSystem>(env.pFs));
+
+    bool ok = true;
+
+    for(std::size_t scaleIdx=0; scaleIdx!=scales.size(); ++scaleIdx)
+    {
+        const std::size_t     scale     = scales[scaleIdx];
+        const nlohmann::json &jManifest = scaledManifests[scaleIdx];
+        const std::string     text      = jManifest.dump(1);
+        const std::wstring    fileName  = L"/manifests/bench_" + std::to_wstring(scale) + L".dotnut-manifest.json";
+
+        const std::string caseName = "manifest x" + std::to_string(scale);
+
+        NutManifestW legacyResult;
+        NutManifestW tableResult;
+
+        // Только обход разобранного документа
+        {
+            // Ссылки берутся после обоих add - вектор результатов может переразместиться
+            report.add("manifest", caseName + " walk", "legacy chain");
+            report.add("manifest", caseName + " walk", "field table");
+            BenchResult &resLegacy = report.results[report.results.size()-2];
+            BenchResult &resTable  = report.results[report.results.size()-1];
+
+            for(std::size_t i=0; i!=opts.iterations; ++i)
+            {
+                nlohmann::json jLegacy = jManifest; // Прежний обход требовал неконстантный документ
+                NutManifestW m1;
+                auto start = Clock::now();
+                legacyApplyManifest(*env.pFs, jLegacy, m1);
+                resLegacy.totalNs += elapsedNs(start);
+                ++resLegacy.ops;
+
+                NutManifestW m2;
+                start = Clock::now();
+                ManifestSchemaAccess::getNutManifestSchema<std::wstring>().apply(schemaCtx, jManifest, m2);
+                resTable.totalNs += elapsedNs(start);
+                ++resTable.ops;
+
+                legacyResult = std::move(m1);
+                tableResult  = std::move(m2);
+            }
+
+            resLegacy.extra["bytes"] = text.size();
+            resTable .extra["bytes"] = text.size();
+        }
+
+        if (!isSameManifest(legacyResult, tableResult))
+        {
+            std::fprintf(stderr, "manifest: field table result differs from the legacy parser (%s)\n", caseName.c_str());
+            ok = false;
+        }
+
+        // Полный разбор файла
+        {
+            // Ссылки берутся после обоих add - вектор результатов может переразместиться
+            report.add("manifest", caseName + " file", "legacy chain");
+            report.add("manifest", caseName + " file", "updateNutManifest");
+            BenchResult &resLegacy = report.results[report.results.size()-2];
+            BenchResult &resTable  = report.results[report.results.size()-1];
+
+            for(std::size_t i=0; i!=opts.iterations; ++i)
+            {
+                NutManifestW m1;
+                auto start = Clock::now();
+                std::string fileText;
+                if (env.pFs->readTextFile(fileName, fileText)!=ErrorCode::ok)
+                {
+                    ok = false;
+                    break;
+                }
+                nlohmann::json jLegacy = nlohmann::json::parse(fileText);
+                legacyApplyManifest(*env.pFs, jLegacy, m1);
+                resLegacy.totalNs += elapsedNs(start);
+                ++resLegacy.ops;
+
+                NutManifestW m2;
+                start = Clock::now();
+                ErrorCode err = env.pAm->updateNutManifest(fileName, m2);
+                resTable.totalNs += elapsedNs(start);
+                ++resTable.ops;
+
+                if (err!=ErrorCode::ok || !isSameManifest(m1, m2))
+                {
+                    std::fprintf(stderr, "manifest: updateNutManifest result differs from the legacy parser (%s)\n", caseName.c_str());
+                    ok = false;
+                    break;
+                }
+            }
+
+            addApiStats(resTable, *env.pAm, AssetsApi::updateNutManifest);
+            resetApiStats(*env.pAm);
+        }
+
+    }
+
+    for(std::size_t scale : scales)
+    {
+        std::error_code ec;
+        std::filesystem::remove(manifestsDir / ("bench_" + std::to_string(scale) + ".dotnut-manifest.json"), ec);
+    }
+
+    if (!ok)
+    {
+        report.failed = true;
+    }
+
+    return ok;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_bench
+
@@ -0,0 +1,183 @@
+/*! \file
+    \brief Allocation count of filling NutProjectT::nutsData: copying loop vs moving loop vs readNutProjectFiles
+
+    Здесь же - замена глобальных operator new/delete, считающая выделения памяти во всей программе
+*/
+
+#include "bench_common.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+//----------------------------------------------------------------------------
+namespace {
+
+std::atomic<std::uint64_t>  allocCount{0};
+std::atomic<std::uint64_t>  allocBytes{0};
+
+void* countedAlloc(std::size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+
+    void *p = std::malloc(size ? size : 1u);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+} // namespace
+
+// Массивные и nothrow-версии по стандарту идут через эти
+void* operator new(std::size_t size)
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+
+namespace marty_assets_bench {
+
+
+
+//----------------------------------------------------------------------------
+namespace {
+
+struct AllocSnapshot
+{
+    std::uint64_t   count = allocCount.load(std::memory_order_relaxed);
+    std::uint64_t   bytes = allocBytes.load(std::memory_order_relaxed);
+
+}; // struct AllocSnapshot
+
+// Прежний цикл загрузки текстов скриптов: имя копируется, текст копируется в проект, без reserve
+ErrorCode readNutFilesCopying(const marty_virtual_fs::IFileSystem &fs, marty_assets_manager::NutProjectW &prj)
+{
+    for(auto nutFile : prj.nuts)
+    {
+        std::wstring fileText;
+        ErrorCode err = fs.readTextFile(nutFile, fileText);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        prj.nutsData.emplace_back(fileText);
+    }
+
+    return ErrorCode::ok;
+}
+
+// Тот же цикл в нынешнем виде (см. AssetsManager::readNutProjectFilesImpl) поверх того же IFileSystem -
+// разница с readNutFilesCopying - только копирование/перемещение
+ErrorCode readNutFilesMoving(const marty_virtual_fs::IFileSystem &fs, marty_assets_manager::NutProjectW &prj)
+{
+    prj.nutsData.reserve(prj.nutsData.size()+prj.nuts.size());
+
+    for(const auto &nutFile : prj.nuts)
+    {
+        std::wstring fileText;
+        ErrorCode err = fs.readTextFile(nutFile, fileText);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        prj.nutsData.emplace_back(std::move(fileText));
+    }
+
+    return ErrorCode::ok;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+// Проект разрешается один раз, дальше замеряется только заполнение nutsData. Третий вариант - сам
+// readNutProjectFiles: к перемещению добавляются проверки наличия файлов и учёт статистики
+bool runNutAllocBench(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report)
+{
+    BenchEnvironment env = makeBenchEnvironment(tree, opts);
+
+    marty_assets_manager::NutProjectW prjTemplate;
+    if (env.pAm->readNutProjectComplete(prjTemplate)!=ErrorCode::ok || prjTemplate.nuts.size()!=tree.nutNames.size())
+    {
+        std::fprintf(stderr, "nutalloc: failed to read project\n");
+        report.failed = true;
+        return false;
+    }
+
+    const std::vector<std::wstring> expectedData = prjTemplate.nutsData;
+    prjTemplate.nutsData.clear();
+    prjTemplate.nutsData.shrink_to_fit();
+
+    typedef std::function<ErrorCode(marty_assets_manager::NutProjectW&)>  LoadFn;
+
+    const marty_virtual_fs::IFileSystem &fs = *env.pFs;
+    const marty_assets_manager::IAssetsManager &am = *env.pAm;
+
+    const std::vector< std::pair<const char*, LoadFn> > variants =
+    { { "copying loop"       , [&fs](marty_assets_manager::NutProjectW &prj) { return readNutFilesCopying(fs, prj); } }
+    , { "moving loop"        , [&fs](marty_assets_manager::NutProjectW &prj) { return readNutFilesMoving(fs, prj); } }
+    , { "readNutProjectFiles", [&am](marty_assets_manager::NutProjectW &prj) { return am.readNutProjectFiles(prj); } }
+    };
+
+    bool ok = true;
+
+    for(const auto &variant : variants)
+    {
+        BenchResult &res = report.add("nutalloc", "fill nutsData", variant.first);
+
+        std::uint64_t allocs = 0;
+        std::uint64_t bytes  = 0;
+
+        for(std::size_t i=0; i!=opts.iterations; ++i)
+        {
+            marty_assets_manager::NutProjectW prj = prjTemplate;
+
+            AllocSnapshot before;
+            auto start = Clock::now();
+            ErrorCode err = variant.second(prj);
+            res.totalNs += elapsedNs(start);
+            AllocSnapshot after;
+
+            if (err!=ErrorCode::ok || prj.nutsData!=expectedData)
+            {
+                std::fprintf(stderr, "nutalloc: %s returned unexpected result\n", variant.first);
+                report.failed = true;
+                ok = false;
+                break;
+            }
+
+            res.ops += prj.nuts.size();
+            allocs  += after.count-before.count;
+            bytes   += after.bytes-before.bytes;
+        }
+
+        res.extra["allocations"   ] = allocs;
+        res.extra["allocatedBytes"] = bytes;
+        res.extra["allocsPerNut"  ] = res.ops ? (double)allocs/(double)res.ops : 0.0;
+    }
+
+    return ok;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_bench
+
@@ -0,0 +1,226 @@
+/*! \file
+    \brief detectFileNutType: the former toupper_copy + ends_with chain vs the reversed-suffix trie, on synthetic names
+*/
+
+#include "bench_common.h"
+
+#include <string_view>
+
+
+namespace marty_assets_bench {
+
+
+using marty_assets_manager::NutType;
+
+
+
+//----------------------------------------------------------------------------
+namespace {
+
+// Прежняя реализация AssetsManager::detectFileNutTypeImpl (toupper_copy и цепочка ends_with) - без изменений, для сравнения
+template<typename StringType>
+NutType legacyDetectFileNutType(const StringType &fname)
+{
+    StringType fnameUpper = umba::string_plus::toupper_copy(fname);
+
+
+    static const StringType nutExt           = umba::string_plus::make_string<StringType>(".NUT") ; // single file suffix
+
+    if (umba::string_plus::ends_with(fnameUpper, nutExt))
+    {
+        return NutType::nutFile;
+    }
+
+
+    static const StringType nutsJsnProjExt1  = umba::string_plus::make_string<StringType>(".NUTSJSNPROJ"); // project suffix
+    static const StringType nutsJsnProjExt2  = umba::string_plus::make_string<StringType>(".NUTJSNPROJ"); // project suffix
+    static const StringType nutsJsonExt      = umba::string_plus::make_string<StringType>(".NUTS.JSON"); // project suffix (double ext)
+
+    static const StringType nutsYmlProjExt1  = umba::string_plus::make_string<StringType>(".NUTSYMLPROJ"); // project suffix
+    static const StringType nutsYmlProjExt2  = umba::string_plus::make_string<StringType>(".NUTYMLPROJ"); // project suffix
+    static const StringType nutsYamlExt      = umba::string_plus::make_string<StringType>(".NUTS.YAML"); // project suffix (double ext)
+
+    if ( umba::string_plus::ends_with(fnameUpper, nutsJsnProjExt1)
+      || umba::string_plus::ends_with(fnameUpper, nutsJsnProjExt2)
+      || umba::string_plus::ends_with(fnameUpper, nutsJsonExt)
+      || umba::string_plus::ends_with(fnameUpper, nutsYmlProjExt1)
+      || umba::string_plus::ends_with(fnameUpper, nutsYmlProjExt2)
+      || umba::string_plus::ends_with(fnameUpper, nutsYamlExt)
+       )
+    {
+        return NutType::dotNutProject;
+    }
+
+
+    static const StringType appSelectorExtJ  = umba::string_plus::make_string<StringType>("DOTNUT.APP-SELECTOR.MANIFEST.JSON");
+    static const StringType appSelectorExtY  = umba::string_plus::make_string<StringType>("DOTNUT.APP-SELECTOR.MANIFEST.YAML");
+
+    if ( umba::string_plus::ends_with(fnameUpper, appSelectorExtJ)
+      || umba::string_plus::ends_with(fnameUpper, appSelectorExtY)
+       )
+    {
+        return NutType::dotNutAppSelector;
+    }
+
+
+    static const StringType manifestExt1     = umba::string_plus::make_string<StringType>(".DOTNUT-MANIFEST.JSON");
+    static const StringType manifestExt2     = umba::string_plus::make_string<StringType>(".MANIFEST.JSON");
+    static const StringType manifestExt3     = umba::string_plus::make_string<StringType>(".DOTNUT-MANIFEST.YAML");
+    static const StringType manifestExt4     = umba::string_plus::make_string<StringType>(".MANIFEST.YAML");
+
+    if ( umba::string_plus::ends_with(fnameUpper, manifestExt1)
+      || umba::string_plus::ends_with(fnameUpper, manifestExt2)
+      || umba::string_plus::ends_with(fnameUpper, manifestExt3)
+      || umba::string_plus::ends_with(fnameUpper, manifestExt4)
+       )
+    {
+        return NutType::dotNutManifect;
+    }
+
+    static const StringType jsonExt          = umba::string_plus::make_string<StringType>(".JSON"); // project suffix
+    static const StringType yamlExt          = umba::string_plus::make_string<StringType>(".YAML"); // project suffix
+
+    if ( umba::string_plus::ends_with(fnameUpper, jsonExt)
+      || umba::string_plus::ends_with(fnameUpper, yamlExt)
+       )
+    {
+        return NutType::dotNutProject;
+    }
+
+    return NutType::unknownNutType;
+
+}
+
+// Имена с суффиксами всех видов в разном регистре, вперемешку с посторонними; регистр имени тоже разный
+template<typename StringType>
+std::vector<StringType> makeSyntheticNames(std::size_t count)
+{
+    static const char* const dirs[] = { "", "scripts/", "a/b/c/", "Very/Long/Directory/Name/For/Assets/", "nuts\\inc1\\" };
+
+    static const char* const suffixes[] =
+    { ".nut", ".NUT", ".Nut", ".nuts.json", ".NutsJsnProj", ".nutjsnproj", ".nuts.yaml", ".NUTSYMLPROJ", ".nutymlproj"
+    , ".dotnut-manifest.json", ".Manifest.Yaml", ".manifest.json", ".DOTNUT-MANIFEST.YAML"
+    , ".json", ".YAML", ".png", ".txt", ".ico", ".bin", "", ".nu", ".jso", ".nutx", "_nut", ".json.bak"
+    };
+
+    const std::size_t numDirs     = sizeof(dirs)/sizeof(dirs[0]);
+    const std::size_t numSuffixes = sizeof(suffixes)/sizeof(suffixes[0]);
+
+    std::vector<StringType> names;
+    names.reserve(count);
+
+    std::uint32_t rnd = 12345u;
+    for(std::size_t i=0; i!=count; ++i)
+    {
+        rnd = rnd*1664525u + 1013904223u;
+
+        std::string name = dirs[(rnd>>4)%numDirs];
+        if (i%997==0)
+        {
+            name.append("dotnut.app-selector.manifest.");
+            name.append((rnd>>8)%2 ? "json" : "YAML");
+        }
+        else
+        {
+            std::size_t baseLen = 3 + (rnd>>12)%18;
+            for(std::size_t k=0; k!=baseLen; ++k)
+            {
+                char ch = (char)('a' + (rnd>>(k%24))%26);
+                name.append(1, (rnd>>20)%3==0 ? (char)(ch-'a'+'A') : ch);
+            }
+            name.append(suffixes[(rnd>>16)%numSuffixes]);
+        }
+
+        names.emplace_back(name.begin(), name.end());
+    }
+
+    return names;
+}
+
+template<typename StringType>
+bool runNutTypeVariants(const BenchOptions &opts, const marty_assets_manager::IAssetsManager &am, const char *charName, BenchReport &report)
+{
+    typedef std::basic_string_view<typename StringType::value_type>  ViewType;
+
+    const std::vector<StringType> names = makeSyntheticNames<StringType>(opts.names);
+
+    std::vector<ViewType> views(names.begin(), names.end());
+
+    std::vector<NutType> expected(names.size());
+    std::vector<NutType> types   (names.size());
+
+    auto measure = [&](const char *mode, const std::function<void()> &body) -> BenchResult&
+                   {
+                       BenchResult &res = report.add("nuttype", std::string("detectFileNutType ") + charName, mode);
+                       for(std::size_t i=0; i!=opts.iterations; ++i)
+                       {
+                           auto start = Clock::now();
+                           body();
+                           res.totalNs += elapsedNs(start);
+                           res.ops     += names.size();
+                       }
+                       return res;
+                   };
+
+    measure( "legacy chain"
+           , [&]()
+             {
+                 for(std::size_t i=0; i!=names.size(); ++i)
+                 {
+                     expected[i] = legacyDetectFileNutType(names[i]);
+                 }
+             }
+           );
+
+    measure( "suffix trie"
+           , [&]()
+             {
+                 for(std::size_t i=0; i!=names.size(); ++i)
+                 {
+                     types[i] = am.detectFileNutType(names[i]);
+                 }
+             }
+           );
+
+    bool ok = types==expected;
+
+    std::fill(types.begin(), types.end(), NutType::invalid);
+
+    measure( "suffix trie batch"
+           , [&]()
+             {
+                 am.detectFileNutTypes(views.data(), views.size(), types.data());
+             }
+           );
+
+    ok = ok && types==expected;
+
+    if (!ok)
+    {
+        std::fprintf(stderr, "nuttype: results of the trie differ from the legacy chain (%s)\n", charName);
+        report.failed = true;
+    }
+
+    return ok;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+// Результаты нового определения сверяются с прежним для каждого имени
+bool runNutTypeBench(const BenchOptions &opts, const SyntheticTree &tree, BenchReport &report)
+{
+    BenchEnvironment env = makeBenchEnvironment(tree, opts);
+
+    bool okA = runNutTypeVariants<std::string >(opts, *env.pAm, "char"   , report);
+    bool okW = runNutTypeVariants<std::wstring>(opts, *env.pAm, "wchar_t", report);
+
+    return okA && okW;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_bench
+
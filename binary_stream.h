@@ -0,0 +1,354 @@
+/*! \file
+    \brief Simple binary serialization helpers for assets manager cache files
+*/
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+//
+#include "types.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Все числа пишутся в little endian независимо от платформы.
+// Символы строк пишутся по 1 байту для char и по 4 байта для широких символов.
+struct BinaryWriter
+{
+    std::vector<std::uint8_t>   data;
+
+    void writeU8(std::uint8_t v)
+    {
+        data.push_back(v);
+    }
+
+    void writeU32(std::uint32_t v)
+    {
+        for(unsigned i=0; i!=4; ++i)
+        {
+            data.push_back((std::uint8_t)(v>>(8*i)));
+        }
+    }
+
+    void writeU64(std::uint64_t v)
+    {
+        for(unsigned i=0; i!=8; ++i)
+        {
+            data.push_back((std::uint8_t)(v>>(8*i)));
+        }
+    }
+
+    void writeI64(std::int64_t v)
+    {
+        writeU64((std::uint64_t)v);
+    }
+
+    void writeBytes(const void *p, std::size_t size)
+    {
+        const std::uint8_t *pb = (const std::uint8_t*)p;
+        data.insert(data.end(), pb, pb+size);
+    }
+
+    template<typename StringType>
+    void writeString(const StringType &str)
+    {
+        writeU32((std::uint32_t)str.size());
+
+        if constexpr (sizeof(typename StringType::value_type)>1)
+        {
+            for(auto ch : str)
+            {
+                writeU32((std::uint32_t)ch);
+            }
+        }
+        else
+        {
+            writeBytes(str.data(), str.size());
+        }
+    }
+
+    void writeStamp(const FileStamp &stamp)
+    {
+        writeU8(stamp.exists ? 1u : 0u);
+        writeU64(stamp.size);
+        writeI64(stamp.mtime);
+    }
+
+}; // struct BinaryWriter
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// При любой ошибке (выход за границы данных) reader переходит в состояние !ok() и дальше ничего не читает
+struct BinaryReader
+{
+
+protected:
+
+    const std::uint8_t   *m_p   = 0;
+    const std::uint8_t   *m_end = 0;
+    bool                  m_ok  = true;
+
+    bool require(std::size_t size)
+    {
+        if (!m_ok || (std::size_t)(m_end-m_p)<size)
+        {
+            m_ok = false;
+        }
+
+        return m_ok;
+    }
+
+public:
+
+    BinaryReader(const std::uint8_t *p, std::size_t size)
+    : m_p(p), m_end(p+size)
+    {}
+
+    bool ok() const { return m_ok; }
+
+    std::size_t getRemainingSize() const
+    {
+        return (std::size_t)(m_end-m_p);
+    }
+
+    std::uint8_t readU8()
+    {
+        if (!require(1))
+        {
+            return 0;
+        }
+
+        return *m_p++;
+    }
+
+    std::uint32_t readU32()
+    {
+        if (!require(4))
+        {
+            return 0;
+        }
+
+        std::uint32_t v = 0;
+        for(unsigned i=0; i!=4; ++i)
+        {
+            v |= ((std::uint32_t)*m_p++)<<(8*i);
+        }
+
+        return v;
+    }
+
+    std::uint64_t readU64()
+    {
+        if (!require(8))
+        {
+            return 0;
+        }
+
+        std::uint64_t v = 0;
+        for(unsigned i=0; i!=8; ++i)
+        {
+            v |= ((std::uint64_t)*m_p++)<<(8*i);
+        }
+
+        return v;
+    }
+
+    std::int64_t readI64()
+    {
+        return (std::int64_t)readU64();
+    }
+
+    const std::uint8_t* readBytes(std::size_t size)
+    {
+        if (!require(size))
+        {
+            return 0;
+        }
+
+        const std::uint8_t *p = m_p;
+        m_p += size;
+        return p;
+    }
+
+    template<typename StringType>
+    StringType readString()
+    {
+        StringType str;
+
+        std::size_t len = readU32();
+
+        if constexpr (sizeof(typename StringType::value_type)>1)
+        {
+            if (!require(len*4))
+            {
+                return str;
+            }
+
+            str.reserve(len);
+            for(std::size_t i=0; i!=len; ++i)
+            {
+                str.push_back((typename StringType::value_type)readU32());
+            }
+        }
+        else
+        {
+            const std::uint8_t *p = readBytes(len);
+            if (p)
+            {
+                str.assign((const char*)p, len);
+            }
+        }
+
+        return str;
+    }
+
+    FileStamp readStamp()
+    {
+        FileStamp stamp;
+        stamp.exists = readU8()!=0;
+        stamp.size   = readU64();
+        stamp.mtime  = readI64();
+        return stamp;
+    }
+
+}; // struct BinaryReader
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+inline
+ErrorCode readNativeBinaryFile(const std::wstring &nativeFileName, std::vector<std::uint8_t> &data)
+{
+    std::ifstream ifs(std::filesystem::path(nativeFileName), std::ios::in | std::ios::binary);
+    if (!ifs)
+    {
+        return ErrorCode::notFound;
+    }
+
+    ifs.seekg(0, std::ios::end);
+    std::streamoff size = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+
+    if (size<0)
+    {
+        return ErrorCode::genericError;
+    }
+
+    data.resize((std::size_t)size);
+    if (size && !ifs.read((char*)data.data(), size))
+    {
+        return ErrorCode::genericError;
+    }
+
+    return ErrorCode::ok;
+}
+
+//----------------------------------------------------------------------------
+// Имя временного файла рядом с path, уникальное для процесса и вызова: <имя>.<соль процесса>-<номер>.tmp.
+// Соль - случайное число, выбирается один раз на процесс, номер - атомарный счётчик вызовов
+inline
+std::filesystem::path makeUniqueTempFilePath(const std::filesystem::path &path)
+{
+    static const std::uint64_t processSalt = []()
+                                             {
+                                                 std::uint64_t salt = (std::uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+                                                 try
+                                                 {
+                                                     std::random_device rd;
+                                                     salt ^= ((std::uint64_t)rd()<<32) ^ (std::uint64_t)rd();
+                                                 }
+                                                 catch(...)
+                                                 {
+                                                     // Без random_device остаётся время запуска
+                                                 }
+                                                 return salt;
+                                             }();
+
+    static std::atomic<std::uint64_t> counter{0};
+
+    auto appendHex = [](std::wstring &str, std::uint64_t v)
+                     {
+                         for(int shift=60; shift>=0; shift-=4)
+                         {
+                             str.push_back(L"0123456789abcdef"[(v>>shift)&0xF]);
+                         }
+                     };
+
+    std::wstring suffix = L".";
+    appendHex(suffix, processSalt);
+    suffix.push_back(L'-');
+    appendHex(suffix, counter.fetch_add(1, std::memory_order_relaxed));
+    suffix.append(L".tmp");
+
+    std::filesystem::path tmpPath = path;
+    tmpPath += suffix;
+    return tmpPath;
+}
+
+//----------------------------------------------------------------------------
+// Пишем во временный файл и переименовываем, чтобы читатель никогда не увидел недописанный файл.
+// Временное имя уникально - одновременные записи одного файла из разных потоков и процессов не пишут
+// в один временный файл; при любой ошибке временный файл удаляется
+inline
+ErrorCode writeNativeBinaryFile(const std::wstring &nativeFileName, const std::vector<std::uint8_t> &data)
+{
+    std::filesystem::path path(nativeFileName);
+    std::filesystem::path tmpPath = makeUniqueTempFilePath(path);
+
+    std::error_code ec;
+
+    {
+        std::ofstream ofs(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!ofs)
+        {
+            return ErrorCode::accessDenied;
+        }
+
+        bool ok = data.empty() || ofs.write((const char*)data.data(), (std::streamsize)data.size());
+
+        ofs.close(); // Ошибка сброса буфера на диск - тоже ошибка записи
+        if (!ok || ofs.fail())
+        {
+            std::filesystem::remove(tmpPath, ec);
+            return ErrorCode::genericError;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec)
+    {
+        // Под Windows заменить файл нельзя, пока он открыт или отображён в память
+        const bool busy = ec==std::errc::permission_denied || ec==std::errc::device_or_resource_busy;
+        std::error_code removeEc;
+        std::filesystem::remove(tmpPath, removeEc);
+        return busy ? ErrorCode::accessDenied : ErrorCode::genericError;
+    }
+
+    return ErrorCode::ok;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,116 @@
+/*! \file
+    \brief Pool of reusable data buffers
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Пул буферов для временных данных (например, для распаковки). Выданный буфер возвращается в пул,
+// когда освобождается последняя ссылка на него, поэтому его можно отдавать наружу как holder у DataView.
+// Пул должен создаваться через std::make_shared
+struct DataBufferPool : public std::enable_shared_from_this<DataBufferPool>
+{
+
+protected:
+
+    typedef std::vector<std::uint8_t>   Buffer;
+
+    std::mutex                              m_mutex            ;
+    std::vector< std::unique_ptr<Buffer> >  m_freeBuffers      ;
+    std::size_t                             m_maxFreeBuffers   = 8;
+    std::size_t                             m_maxBufferCapacity= 4u*1024u*1024u; // Большие буфера не держим
+
+
+    void release(Buffer *pBuf)
+    {
+        std::unique_ptr<Buffer> buf(pBuf);
+
+        if (buf->capacity()>m_maxBufferCapacity)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_freeBuffers.size()<m_maxFreeBuffers)
+        {
+            m_freeBuffers.emplace_back(std::move(buf));
+        }
+    }
+
+
+public:
+
+    DataBufferPool() = default;
+
+    DataBufferPool(std::size_t maxFreeBuffers, std::size_t maxBufferCapacity)
+    : m_maxFreeBuffers(maxFreeBuffers), m_maxBufferCapacity(maxBufferCapacity)
+    {}
+
+    DataBufferPool(const DataBufferPool &) = delete;
+    DataBufferPool& operator=(const DataBufferPool &) = delete;
+
+    // Буфер размера size, содержимое не определено
+    std::shared_ptr<Buffer> acquire(std::size_t size)
+    {
+        std::unique_ptr<Buffer> buf;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_freeBuffers.empty())
+            {
+                buf = std::move(m_freeBuffers.back());
+                m_freeBuffers.pop_back();
+            }
+        }
+
+        if (!buf)
+        {
+            buf.reset(new Buffer());
+        }
+
+        buf->resize(size);
+
+        // Пул может умереть раньше буфера - тогда буфер просто удаляется
+        std::weak_ptr<DataBufferPool> wpPool = weak_from_this();
+
+        return std::shared_ptr<Buffer>( buf.release()
+                                      , [wpPool](Buffer *pBuf)
+                                        {
+                                            if (auto pPool = wpPool.lock())
+                                            {
+                                                pPool->release(pBuf);
+                                            }
+                                            else
+                                            {
+                                                delete pBuf;
+                                            }
+                                        }
+                                      );
+    }
+
+    std::size_t getNumFreeBuffers()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_freeBuffers.size();
+    }
+
+}; // struct DataBufferPool
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,117 @@
+/*! \file
+    \brief Case-insensitive hashing and comparison of file names without making uppercase copies
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+//
+#include "hash_utils.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Приведение символа к верхнему регистру. ASCII - сразу, остальные широкие символы - через towupper.
+// Однобайтные строки - это UTF-8, и для char регистр меняется ТОЛЬКО у ASCII: 'a'-'z' -> 'A'-'Z', все
+// байты >=0x80 остаются как есть. Имена с не-ASCII буквами в разном регистре ("файл" и "ФАЙЛ") в UTF-8
+// строках считаются разными. std::toupper здесь сознательно не используется - он зависит от текущей
+// локали и в однобайтных локалях портит байты многобайтных последовательностей UTF-8, а результат
+// hashStringCaseFoldFnv1a64 сохраняется в файлы архивов и от локали зависеть не должен.
+// Для полного сравнения без учёта регистра имена нужно держать в std::wstring
+inline
+char caseFoldChar(char ch)
+{
+    return (ch>='a' && ch<='z') ? (char)(ch-'a'+'A') : ch;
+}
+
+inline
+wchar_t caseFoldChar(wchar_t ch)
+{
+    if (ch<0x80)
+    {
+        return (ch>=L'a' && ch<=L'z') ? (wchar_t)(ch-L'a'+L'A') : ch;
+    }
+
+    return (wchar_t)std::towupper((std::wint_t)ch);
+}
+
+//----------------------------------------------------------------------------
+// Хэш (FNV-1a по символам в верхнем регистре) и сравнение без учёта регистра.
+// Подходят для любых строк и string_view - копия в верхнем регистре не создаётся
+struct CaseFoldHash
+{
+    template<typename StringType>
+    std::size_t operator()(const StringType &str) const
+    {
+        std::uint64_t hash = fnv1a64OffsetBasis;
+        for(auto ch : str)
+        {
+            hash ^= (std::uint64_t)caseFoldChar(ch);
+            hash *= fnv1a64Prime;
+        }
+
+        return (std::size_t)hash;
+    }
+
+}; // struct CaseFoldHash
+
+struct CaseFoldEqual
+{
+    template<typename StringType>
+    bool operator()(const StringType &str1, const StringType &str2) const
+    {
+        if (str1.size()!=str2.size())
+        {
+            return false;
+        }
+
+        for(std::size_t i=0; i!=str1.size(); ++i)
+        {
+            if (caseFoldChar(str1[i])!=caseFoldChar(str2[i]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+}; // struct CaseFoldEqual
+
+//----------------------------------------------------------------------------
+// 64-битный FNV-1a по байтам UTF-8 строки, приведённой к верхнему регистру - для хэшей, которые сохраняются
+// в файлы (CaseFoldHash возвращает size_t, и его значение зависит от платформы)
+inline
+std::uint64_t hashStringCaseFoldFnv1a64(const std::string &str)
+{
+    std::uint64_t hash = fnv1a64OffsetBasis;
+    for(char ch : str)
+    {
+        hash ^= (std::uint8_t)caseFoldChar(ch);
+        hash *= fnv1a64Prime;
+    }
+
+    return hash;
+}
+
+//----------------------------------------------------------------------------
+// Множество имён без учёта регистра. Хранит string_view - строки должны жить дольше множества
+template<typename StringType>
+using CaseFoldNameSet = std::unordered_set< std::basic_string_view<typename StringType::value_type>, CaseFoldHash, CaseFoldEqual >;
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,127 @@
+/*! \file
+    \brief Cache of parsed config JSON documents
+*/
+
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+//
+#include "types.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Кэш разобранных конфигов (/conf/...).
+// Ключ - нормализованное полное имя файла в VFS, вместе с документом хранится отметка файла, с которой он был прочитан.
+// Документ выдаётся только при совпадении отметки, иначе считается, что файл изменился.
+// Документы неизменяемые и разделяемые - выданный наружу документ остаётся валидным и после сброса кэша.
+// Конфигов немного и они маленькие, поэтому размер не ограничивается
+struct ConfJsonCache
+{
+
+protected:
+
+    struct Entry
+    {
+        FileStamp     stamp;
+        SharedJson    json ;
+    };
+
+    mutable std::mutex                          m_mutex  ;
+    std::unordered_map<std::wstring, Entry>     m_entries;
+
+    std::atomic<std::uint64_t>                  m_hits   {0};
+    std::atomic<std::uint64_t>                  m_misses {0};
+
+
+public:
+
+    ConfJsonCache() {}
+
+    ConfJsonCache(const ConfJsonCache &) = delete;
+    ConfJsonCache& operator=(const ConfJsonCache &) = delete;
+
+
+    bool find(const std::wstring &key, const FileStamp &stamp, SharedJson &json)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_entries.find(key);
+            if (it!=m_entries.end() && it->second.stamp==stamp)
+            {
+                json = it->second.json;
+                m_hits.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Чтение мимо кэша (например, для файла не удалось получить отметку)
+    void addMiss()
+    {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void insert(const std::wstring &key, const FileStamp &stamp, SharedJson json)
+    {
+        if (!json)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[key] = Entry{stamp, std::move(json)};
+    }
+
+    void erase(const std::wstring &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.erase(key);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+    }
+
+    ConfJsonCacheStats getStats() const
+    {
+        ConfJsonCacheStats stats;
+        stats.hits   = m_hits.load(std::memory_order_relaxed);
+        stats.misses = m_misses.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.numEntries = m_entries.size();
+
+        return stats;
+    }
+
+    void resetStats()
+    {
+        m_hits.store(0, std::memory_order_relaxed);
+        m_misses.store(0, std::memory_order_relaxed);
+    }
+
+}; // struct ConfJsonCache
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
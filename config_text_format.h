@@ -0,0 +1,108 @@
+/*! \file
+    \brief Detecting config text format (JSON or YAML) by file name and content
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <string>
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+enum class ConfigTextFormat
+{
+    json,   // Можно разбирать только как JSON
+    yaml    // YAML или непонятно что - нужен универсальный разбор
+
+}; // enum class ConfigTextFormat
+
+//----------------------------------------------------------------------------
+// Текст начинается (после пробельных символов и BOM) с '{' или '[' - это JSON, а не YAML
+inline
+bool isJsonLikeText(const char *pText, std::size_t textLen)
+{
+    std::size_t pos = 0;
+
+    if (textLen>=3 && (unsigned char)pText[0]==0xEF && (unsigned char)pText[1]==0xBB && (unsigned char)pText[2]==0xBF)
+    {
+        pos = 3;
+    }
+
+    for(; pos!=textLen; ++pos)
+    {
+        char ch = pText[pos];
+        if (ch==' ' || ch=='\t' || ch=='\r' || ch=='\n')
+        {
+            continue;
+        }
+
+        return ch=='{' || ch=='[';
+    }
+
+    return false;
+}
+
+inline
+bool isJsonLikeText(const std::string &text)
+{
+    return isJsonLikeText(text.data(), text.size());
+}
+
+//----------------------------------------------------------------------------
+// Имя файла заканчивается на ext (ext - в нижнем регистре, ASCII), регистр в имени не важен
+template<typename StringType>
+bool isConfigFileExt(const StringType &fileName, const char *ext)
+{
+    std::size_t extLen = std::char_traits<char>::length(ext);
+    if (fileName.size()<extLen)
+    {
+        return false;
+    }
+
+    std::size_t pos = fileName.size()-extLen;
+    for(std::size_t i=0; i!=extLen; ++i)
+    {
+        auto ch = fileName[pos+i];
+        if (ch>='A' && ch<='Z')
+        {
+            ch = (decltype(ch))(ch-'A'+'a');
+        }
+
+        if (ch!=(decltype(ch))ext[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// По расширению: .json/.jsn - JSON, .yaml/.yml - YAML. Иначе - по первому значащему символу текста
+template<typename StringType>
+ConfigTextFormat detectConfigTextFormat(const StringType &fileName, const std::string &text)
+{
+    if (isConfigFileExt(fileName, ".json") || isConfigFileExt(fileName, ".jsn"))
+    {
+        return ConfigTextFormat::json;
+    }
+
+    if (isConfigFileExt(fileName, ".yaml") || isConfigFileExt(fileName, ".yml"))
+    {
+        return ConfigTextFormat::yaml;
+    }
+
+    return isJsonLikeText(text) ? ConfigTextFormat::json : ConfigTextFormat::yaml;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -13,6 +13,61 @@
 #endif
 
 //----------------------------------------------------------------------------
+#ifndef MARTY_ASSMAN_ASSETS_CACHE_DEFAULT_BUDGET
+
+    //! Размер кэша ассетов по умолчанию, в байтах. 0 - кэш отключен
+    #define MARTY_ASSMAN_ASSETS_CACHE_DEFAULT_BUDGET   (32u*1024u*1024u)
+
+#endif
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_ASSMAN_ASYNC_IO_DEFAULT_THREADS
+
+    //! Количество потоков ввода-вывода для асинхронных запросов по умолчанию
+    #define MARTY_ASSMAN_ASYNC_IO_DEFAULT_THREADS      2u
+
+#endif
+
+//----------------------------------------------------------------------------
+#ifndef MARTY_ASSMAN_DIR_MTIME_GRANULARITY_MS
+
+    //! Худшая точность времени модификации каталогов в ФС, в миллисекундах (FAT - 2 секунды).
+    //! Список файлов каталога (dir_listing_cache.h) говорит "файла нет", только если прочитан позже
+    //! времени модификации каталога хотя бы на эту величину
+    #define MARTY_ASSMAN_DIR_MTIME_GRANULARITY_MS      2000u
+
+#endif
+
+//----------------------------------------------------------------------------
+// Встроенные замеры времени (profiler.h). Без MARTY_ASSMAN_PROFILING замеры не компилируются вовсе,
+// с ним - пишутся, только когда включены во время работы (getProfiler().setEnabled(true))
+
+// #define MARTY_ASSMAN_PROFILING
+
+#ifndef MARTY_ASSMAN_PROFILING_MAX_EVENTS
+
+    //! Максимальное количество событий в журнале замеров, лишние отбрасываются
+    #define MARTY_ASSMAN_PROFILING_MAX_EVENTS          65536u
+
+#endif
+
+//----------------------------------------------------------------------------
+// Поддержка сжатых записей в упакованных архивах (packed_archive.h). Включается макросами
+// MARTY_ASSMAN_PACKED_ARCHIVE_LZ4 и/или MARTY_ASSMAN_PACKED_ARCHIVE_ZSTD, при этом нужны
+// заголовки и библиотеки lz4/zstd. Без них сжатые записи при чтении возвращают ErrorCode::notSupported
+
+// #define MARTY_ASSMAN_PACKED_ARCHIVE_LZ4
+// #define MARTY_ASSMAN_PACKED_ARCHIVE_ZSTD
+
+#ifndef MARTY_ASSMAN_PACKED_ARCHIVE_MAX_ENTRY_SIZE
+
+    //! Максимальный размер сжатой записи архива после распаковки, в байтах. Размер берётся из оглавления
+    //! архива, и без ограничения испорченный архив мог бы заставить выделить сколько угодно памяти
+    #define MARTY_ASSMAN_PACKED_ARCHIVE_MAX_ENTRY_SIZE (1024u*1024u*1024u)
+
+#endif
+
+//----------------------------------------------------------------------------
 
 
 
@@ -0,0 +1,179 @@
+/*! \file
+    \brief Cached local directory listings for fast negative file lookups
+*/
+
+#pragma once
+
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+//
+#include "defs.h"
+#include "types.h"
+#include "file_stamp.h"
+#include "case_fold.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Кэш списков файлов каталогов локальной ФС - для быстрого ответа "такого файла нет".
+// Каталог читается целиком один раз, дальше все проверки файлов в нём идут по списку. При каждой проверке
+// сверяется отметка самого каталога (время модификации каталога меняется при добавлении/удалении/переименовании
+// файлов в нём) - одно обращение к ФС вместо попытки открыть файл, и при изменении каталог перечитывается.
+// Время модификации хранится с точностью ФС, и изменение в тот же такт, что и чтение списка, его не меняет.
+// Поэтому "файла нет" по списку отвечается, только если список начали читать позже времени модификации каталога
+// хотя бы на MARTY_ASSMAN_DIR_MTIME_GRANULARITY_MS. Более свежий список не доказывает отсутствия файла - проверка
+// уходит в VFS, а каталог перечитывается при следующей проверке.
+// Сбросить кэш можно через invalidate/clear (например, по событию от наблюдателя за ФС).
+// Отвечает только на вопрос "файла точно нет" - наличие файла в списке ещё не значит, что его можно прочитать
+struct NativeDirListingCache
+{
+
+protected:
+
+    #if defined(WIN32) || defined(_WIN32)
+    typedef std::unordered_set<std::wstring, CaseFoldHash, CaseFoldEqual>   NameSet;
+    #else
+    typedef std::unordered_set<std::wstring>                                NameSet;
+    #endif
+
+    struct DirEntry
+    {
+        FileStamp    stamp; // Отметка каталога на момент чтения списка
+        NameSet      names;
+        bool         complete = false; // Список прочитан позже изменения каталога на такт времени ФС и больше - отсутствию в нём можно верить
+    };
+
+    mutable std::mutex                              m_mutex;
+    std::unordered_map<std::wstring, DirEntry>      m_dirs ;
+
+
+    static FileStamp getDirStamp(const std::wstring &dirName)
+    {
+        FileStamp stamp = getNativeFileStamp(dirName);
+        stamp.size = 0; // Для каталогов размер не имеет смысла
+        return stamp;
+    }
+
+    // Текущее время в единицах FileStamp::mtime
+    static std::int64_t getFileClockNow()
+    {
+        return (std::int64_t)std::filesystem::file_time_type::clock::now().time_since_epoch().count();
+    }
+
+    static std::int64_t getMtimeGranularity()
+    {
+        return (std::int64_t)std::chrono::duration_cast<std::filesystem::file_time_type::duration>(std::chrono::milliseconds(MARTY_ASSMAN_DIR_MTIME_GRANULARITY_MS)).count();
+    }
+
+    static void readDirNames(const std::wstring &dirName, NameSet &names)
+    {
+        std::error_code ec;
+        for(std::filesystem::directory_iterator it(std::filesystem::path(dirName), ec), end; !ec && it!=end; it.increment(ec))
+        {
+            names.insert(it->path().filename().wstring());
+        }
+    }
+
+
+public:
+
+    NativeDirListingCache() {}
+
+    NativeDirListingCache(const NativeDirListingCache &) = delete;
+    NativeDirListingCache& operator=(const NativeDirListingCache &) = delete;
+
+
+    // false - файла точно нет (нет в списке его каталога, или нет самого каталога)
+    bool mayExist(const std::wstring &nativeFileName)
+    {
+        std::filesystem::path path(nativeFileName);
+        std::wstring dirName  = path.parent_path().wstring();
+        std::wstring fileName = path.filename().wstring();
+
+        if (dirName.empty() || fileName.empty())
+        {
+            return true; // Не можем судить
+        }
+
+        // ФС трогаем без блокировки - одновременные проверки одного каталога в худшем случае прочитают его дважды
+        FileStamp stamp = getDirStamp(dirName);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_dirs.find(dirName);
+            if (it!=m_dirs.end() && it->second.stamp==stamp && it->second.complete)
+            {
+                return it->second.names.find(fileName)!=it->second.names.end();
+            }
+        }
+
+        DirEntry entry;
+        entry.stamp = stamp;
+        if (stamp.exists)
+        {
+            // Время берём до чтения: всё, чего нет в списке, изменено не раньше этого момента
+            entry.complete = getFileClockNow()-stamp.mtime >= getMtimeGranularity();
+            readDirNames(dirName, entry.names);
+        }
+        else
+        {
+            entry.complete = true; // Появление каталога изменит его отметку
+        }
+
+        bool res = !entry.complete || entry.names.find(fileName)!=entry.names.end();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dirs[dirName] = std::move(entry);
+
+        return res;
+    }
+
+    // Файл замечен другим путём (например, при получении его отметки). Если его нет в закэшированном списке
+    // (появился после чтения каталога, а время модификации каталога не успело измениться), добавляем
+    void noteExisting(const std::wstring &nativeFileName)
+    {
+        std::filesystem::path path(nativeFileName);
+        std::wstring dirName = path.parent_path().wstring();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_dirs.find(dirName);
+        if (it!=m_dirs.end())
+        {
+            it->second.names.insert(path.filename().wstring());
+        }
+    }
+
+    void invalidate(const std::wstring &nativeDirName)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dirs.erase(nativeDirName);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dirs.clear();
+    }
+
+}; // struct NativeDirListingCache
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
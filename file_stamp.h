@@ -0,0 +1,61 @@
+/*! \file
+    \brief File stamps (existence, size, modification time) for local filesystem files
+*/
+
+#pragma once
+
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+//
+#include "types.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+inline
+FileStamp getNativeFileStamp(const std::wstring &nativeFileName)
+{
+    FileStamp stamp;
+
+    std::error_code ec;
+    std::filesystem::path path(nativeFileName);
+
+    auto st = std::filesystem::status(path, ec);
+    if (ec || !std::filesystem::exists(st))
+    {
+        return stamp;
+    }
+
+    stamp.exists = true;
+
+    if (std::filesystem::is_regular_file(st))
+    {
+        auto sz = std::filesystem::file_size(path, ec);
+        if (!ec)
+        {
+            stamp.size = (std::uint64_t)sz;
+        }
+    }
+
+    auto mt = std::filesystem::last_write_time(path, ec);
+    if (!ec)
+    {
+        stamp.mtime = (std::int64_t)mt.time_since_epoch().count();
+    }
+
+    return stamp;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,401 @@
+/*! \file
+    \brief Watching local filesystem files and directories for changes
+*/
+
+#pragma once
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//
+#include "types.h"
+#include "file_stamp.h"
+
+//
+#include "umba/string_plus.h"
+
+#if defined(__linux__)
+
+    #include <cerrno>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+
+#endif
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Наблюдение за файлами и каталогами локальной ФС.
+// Потоков не создаёт - изменения забираются вызовом checkChanges (например, из цикла обработки сообщений приложения).
+// На Linux используется inotify: файлы перепроверяются только при наличии событий в их каталогах.
+// На остальных платформах, а также если inotify недоступен, раз в pollIntervalMs сравниваются отметки файлов.
+// Для каталога изменением считается любое событие с его содержимым на любой глубине (inotify - наблюдение
+// ставится на каждый подкаталог, в том числе созданный или перенесённый в дерево позже),
+// или изменение времени модификации самого каталога (опрос - ловит только добавление/удаление/переименование
+// его непосредственных элементов, изменения в подкаталогах при опросе не видны)
+struct NativeFileWatcher
+{
+
+protected:
+
+    struct WatchedPath
+    {
+        std::wstring    path ;
+        std::string     name ; // Имя файла в UTF-8 - для сопоставления с событиями inotify
+        bool            isDir = false;
+        FileStamp       stamp;
+    };
+
+    std::vector<WatchedPath>                m_paths          ;
+    std::chrono::milliseconds               m_pollInterval   ;
+    std::chrono::steady_clock::time_point   m_lastPollTime   ;
+
+    #if defined(__linux__)
+
+    struct WatchInfo
+    {
+        std::filesystem::path       dir     ; // Наблюдаемый каталог
+        std::vector<std::size_t>    pathIdxs; // Индексы путей, к которым относятся его события
+    };
+
+    int                                     m_inotifyFd = -1;
+    std::unordered_map<int, WatchInfo>      m_watches   ; // Дескриптор наблюдения -> каталог и индексы путей
+
+    #endif
+
+
+    #if defined(__linux__)
+
+    void closeNotifications()
+    {
+        if (m_inotifyFd>=0)
+        {
+            ::close(m_inotifyFd);
+        }
+
+        m_inotifyFd = -1;
+        m_watches.clear();
+    }
+
+    // Ставит наблюдение за каталогом и относит его события к путям pathIdxs.
+    // Возвращает 0 или код ошибки inotify_add_watch (errno)
+    int addWatch(const std::filesystem::path &dir, const std::vector<std::size_t> &pathIdxs)
+    {
+        const std::uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MODIFY | IN_DELETE_SELF | IN_MOVE_SELF;
+
+        int wd = ::inotify_add_watch(m_inotifyFd, umba::toUtf8(dir.wstring()).c_str(), mask);
+        if (wd<0)
+        {
+            return errno;
+        }
+
+        // Для уже наблюдаемого каталога (вложенные точки монтирования, перенос внутри дерева) дескриптор тот же
+        WatchInfo &wi = m_watches[wd];
+        wi.dir = dir;
+        for(auto idx : pathIdxs)
+        {
+            if (std::find(wi.pathIdxs.begin(), wi.pathIdxs.end(), idx)==wi.pathIdxs.end())
+            {
+                wi.pathIdxs.emplace_back(idx);
+            }
+        }
+
+        return 0;
+    }
+
+    // Ставит наблюдения за всеми подкаталогами dir на любой глубине. Исчезнувшие по ходу обхода подкаталоги
+    // пропускаются, false - наблюдение поставить не удалось (например, исчерпан лимит max_user_watches)
+    bool addSubdirWatches(const std::filesystem::path &dir, const std::vector<std::size_t> &pathIdxs)
+    {
+        std::error_code ec;
+        std::filesystem::recursive_directory_iterator it(dir, std::filesystem::directory_options::skip_permission_denied, ec);
+        for(; !ec && it!=std::filesystem::recursive_directory_iterator(); it.increment(ec))
+        {
+            // Ссылки на каталоги обход не раскрывает - не наблюдаем и за ними
+            std::error_code ecEntry;
+            if (it->is_symlink(ecEntry) || !it->is_directory(ecEntry))
+            {
+                continue;
+            }
+
+            int err = addWatch(it->path(), pathIdxs);
+            if (err!=0 && err!=ENOENT && err!=ENOTDIR)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Ставит наблюдения за всеми путями: за каталогом - вместе с подкаталогами, за файлом - за его каталогом.
+    // Если что-то не получилось, уведомления выключаются и используется опрос
+    void startNotifications()
+    {
+        // Старые наблюдения снимаем вместе с дескриптором
+        closeNotifications();
+        m_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotifyFd<0)
+        {
+            return;
+        }
+
+        for(std::size_t i=0; i!=m_paths.size(); ++i)
+        {
+            // Для файла наблюдаем за его каталогом - так ловятся и атомарные замены через rename
+            std::filesystem::path watchPath = m_paths[i].isDir ? std::filesystem::path(m_paths[i].path)
+                                                               : std::filesystem::path(m_paths[i].path).parent_path();
+
+            const std::vector<std::size_t> pathIdxs = { i };
+
+            if (addWatch(watchPath, pathIdxs)!=0 || (m_paths[i].isDir && !addSubdirWatches(watchPath, pathIdxs)))
+            {
+                // Каталога нет, нет доступа или кончился лимит - не можем обещать уведомления, переходим на опрос
+                closeNotifications();
+                return;
+            }
+        }
+    }
+
+    // Читает все накопившиеся события, возвращает индексы путей, которые надо перепроверить
+    void readNotifications(std::vector<bool> &affected)
+    {
+        alignas(inotify_event) char buf[4096];
+
+        // Новые подкаталоги и пути, к которым они относятся. Наблюдения за ними ставятся после разбора событий
+        std::vector< std::pair<std::filesystem::path, std::vector<std::size_t> > > newDirs;
+        bool overflow = false;
+
+        for(;;)
+        {
+            ssize_t len = ::read(m_inotifyFd, buf, sizeof(buf));
+            if (len<=0)
+            {
+                break; // EAGAIN - событий больше нет
+            }
+
+            for(const char *p=buf; p<buf+len; )
+            {
+                const inotify_event *pEvent = (const inotify_event*)p;
+                p += sizeof(inotify_event)+pEvent->len;
+
+                if (pEvent->mask&IN_Q_OVERFLOW)
+                {
+                    // События потеряны - перепроверяем всё
+                    overflow = true;
+                    continue;
+                }
+
+                if (pEvent->mask&IN_IGNORED)
+                {
+                    // Каталог удалён (или ФС размонтирована) - наблюдение снято ядром. Каталог, перенесённый
+                    // за пределы дерева, остаётся под наблюдением - его события дают лишь лишнюю перепроверку
+                    m_watches.erase(pEvent->wd);
+                    continue;
+                }
+
+                auto it = m_watches.find(pEvent->wd);
+                if (it==m_watches.end())
+                {
+                    continue;
+                }
+
+                std::string eventName = pEvent->len ? std::string(pEvent->name) : std::string();
+
+                std::vector<std::size_t> dirIdxs;
+
+                for(auto idx : it->second.pathIdxs)
+                {
+                    if (m_paths[idx].isDir || eventName.empty() || eventName==m_paths[idx].name)
+                    {
+                        affected[idx] = true;
+                    }
+
+                    if (m_paths[idx].isDir)
+                    {
+                        dirIdxs.emplace_back(idx);
+                    }
+                }
+
+                if ((pEvent->mask&IN_ISDIR) && (pEvent->mask&(IN_CREATE|IN_MOVED_TO)) && !eventName.empty() && !dirIdxs.empty())
+                {
+                    newDirs.emplace_back(it->second.dir/std::filesystem::u8path(eventName), std::move(dirIdxs));
+                }
+            }
+        }
+
+        if (overflow)
+        {
+            // Могли потеряться и создания подкаталогов - ставим наблюдения заново
+            affected.assign(affected.size(), true);
+            startNotifications();
+            return;
+        }
+
+        for(const auto &nd : newDirs)
+        {
+            // Внутри нового каталога до установки наблюдения уже могли появиться подкаталоги
+            int err = addWatch(nd.first, nd.second);
+            if ((err!=0 && err!=ENOENT && err!=ENOTDIR) || (err==0 && !addSubdirWatches(nd.first, nd.second)))
+            {
+                closeNotifications();
+                affected.assign(affected.size(), true);
+                return;
+            }
+        }
+    }
+
+    #endif
+
+
+    FileStamp makeStamp(const WatchedPath &wp) const
+    {
+        FileStamp stamp = getNativeFileStamp(wp.path);
+        if (wp.isDir)
+        {
+            stamp.size = 0; // Для каталогов размер не имеет смысла
+        }
+
+        return stamp;
+    }
+
+
+public:
+
+    explicit NativeFileWatcher(bool useNotifications = true, unsigned pollIntervalMs = 1000)
+    : m_pollInterval(pollIntervalMs)
+    , m_lastPollTime(std::chrono::steady_clock::now())
+    {
+        #if defined(__linux__)
+
+            if (useNotifications)
+            {
+                m_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            }
+
+        #else
+
+            MARTY_ASSMAN_ARG_USED(useNotifications);
+
+        #endif
+    }
+
+    NativeFileWatcher(const NativeFileWatcher &) = delete;
+    NativeFileWatcher& operator=(const NativeFileWatcher &) = delete;
+
+    ~NativeFileWatcher()
+    {
+        #if defined(__linux__)
+            closeNotifications();
+        #endif
+    }
+
+    bool usesNotifications() const
+    {
+        #if defined(__linux__)
+            return m_inotifyFd>=0;
+        #else
+            return false;
+        #endif
+    }
+
+    // Задаёт новый список наблюдаемых путей. Индексы в checkChanges - индексы в этом списке.
+    // Текущее состояние путей запоминается, изменения отсчитываются от него
+    void setPaths(const std::vector<std::wstring> &paths)
+    {
+        m_paths.clear();
+        m_paths.reserve(paths.size());
+
+        for(const auto &p : paths)
+        {
+            WatchedPath wp;
+            wp.path  = p;
+            wp.name  = umba::toUtf8(std::filesystem::path(p).filename().wstring());
+            wp.isDir = std::filesystem::is_directory(std::filesystem::path(p));
+            wp.stamp = makeStamp(wp);
+            m_paths.emplace_back(std::move(wp));
+        }
+
+        #if defined(__linux__)
+
+            if (m_inotifyFd>=0)
+            {
+                startNotifications();
+            }
+
+        #endif
+    }
+
+    std::size_t getNumPaths() const
+    {
+        return m_paths.size();
+    }
+
+    const std::wstring& getPath(std::size_t idx) const
+    {
+        return m_paths[idx].path;
+    }
+
+    // Возвращает true и индексы изменившихся путей, если что-то изменилось с прошлого вызова
+    bool checkChanges(std::vector<std::size_t> &changed)
+    {
+        changed.clear();
+
+        std::vector<bool> affected(m_paths.size(), false);
+
+        #if defined(__linux__)
+        if (m_inotifyFd>=0)
+        {
+            readNotifications(affected);
+        }
+        else
+        #endif
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now-m_lastPollTime<m_pollInterval)
+            {
+                return false;
+            }
+
+            m_lastPollTime = now;
+            affected.assign(affected.size(), true);
+        }
+
+        for(std::size_t i=0; i!=m_paths.size(); ++i)
+        {
+            if (!affected[i])
+            {
+                continue;
+            }
+
+            FileStamp stamp = makeStamp(m_paths[i]);
+            if (stamp!=m_paths[i].stamp || (m_paths[i].isDir && usesNotifications()))
+            {
+                // С уведомлениями событие в каталоге уже означает изменение его содержимого
+                m_paths[i].stamp = stamp;
+                changed.emplace_back(i);
+            }
+        }
+
+        return !changed.empty();
+    }
+
+}; // struct NativeFileWatcher
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,48 @@
+/*! \file
+    \brief Non-cryptographic hash helpers
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// FNV-1a, 64 бита. Для ключей кэшей и проверки изменений, не для защиты от подделки
+const std::uint64_t fnv1a64OffsetBasis = 0xcbf29ce484222325ull;
+const std::uint64_t fnv1a64Prime       = 0x00000100000001b3ull;
+
+//----------------------------------------------------------------------------
+inline
+std::uint64_t hashFnv1a64(const void *pData, std::size_t size, std::uint64_t hash=fnv1a64OffsetBasis)
+{
+    const std::uint8_t *p = (const std::uint8_t*)pData;
+    for(std::size_t i=0; i!=size; ++i)
+    {
+        hash ^= p[i];
+        hash *= fnv1a64Prime;
+    }
+
+    return hash;
+}
+
+//----------------------------------------------------------------------------
+template<typename StringType> inline
+std::uint64_t hashStringFnv1a64(const StringType &str)
+{
+    return hashFnv1a64(str.data(), str.size()*sizeof(typename StringType::value_type));
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
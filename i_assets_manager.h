@@ -5,7 +5,9 @@
 #pragma once
 
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
 
 //
@@ -33,12 +35,44 @@ struct IAssetsManager
     virtual NutType detectFileNutType(const std::string  &fname) const = 0;
     virtual NutType detectFileNutType(const std::wstring &fname) const = 0;
 
+    // Пакетное определение типа: pTypes[i] - тип для pNames[i], массивы размером count. Без выделения памяти
+    virtual void detectFileNutTypes(const std::string_view  *pNames, std::size_t count, NutType *pTypes) const = 0;
+    virtual void detectFileNutTypes(const std::wstring_view *pNames, std::size_t count, NutType *pTypes) const = 0;
+
     virtual ErrorCode setProjectName(const std::string  &projectName) = 0;
     virtual ErrorCode setProjectName(const std::wstring &projectName) = 0;
 
     virtual ErrorCode getProjectName(std::string  &projectName) const = 0;
     virtual ErrorCode getProjectName(std::wstring &projectName) const = 0;
 
+    // Привязка точки монтирования VFS к каталогу (или файлу) локальной файловой системы.
+    // Нужна для отображения файлов в память; файлы с точек монтирования без привязки читаются через VFS
+    virtual ErrorCode setNativeMountPoint(const std::string  &mountPointName, const std::string  &nativePath) = 0;
+    virtual ErrorCode setNativeMountPoint(const std::wstring &mountPointName, const std::wstring &nativePath) = 0;
+    virtual void      clearNativeMountPoints() = 0;
+
+    // Индекс содержимого локальной точки монтирования (см. mount_index.h) - снимок каталога, по которому проверки
+    // наличия файлов идут без обращения к ФС. Строится явно, обычно при старте (buildMountIndexes - для всех точек
+    // монтирования с известным каталогом). После изменений на диске индексы надо перестроить (rebuildMountIndexes,
+    // это делает NutAssetsWatcherT). Индекс, разошедшийся с замеченной менеджером отметкой файла, до перестроения не используется.
+    // Сам индекс доступен через IAssetsManagerDiagnostics::getMountIndex
+    virtual ErrorCode buildMountIndex(const std::string  &mountPointName) = 0;
+    virtual ErrorCode buildMountIndex(const std::wstring &mountPointName) = 0;
+    virtual ErrorCode buildMountIndexes() = 0;
+    virtual void      rebuildMountIndexes() = 0;
+    virtual void      dropMountIndexes() = 0;
+
+    // Подмена точки монтирования VFS упакованным архивом (см. packed_archive.h). Архив открывается один раз
+    // и отображается в память, файлы ищутся по хэш-индексу без обращений к ФС. Архив только для чтения
+    virtual ErrorCode mountPackedArchive(const std::string  &mountPointName, const std::string  &nativeArchiveFileName) = 0;
+    virtual ErrorCode mountPackedArchive(const std::wstring &mountPointName, const std::wstring &nativeArchiveFileName) = 0;
+    virtual void      unmountPackedArchives() = 0;
+
+    // Имя в локальной ФС для файла или каталога VFS. false, если точка монтирования не привязана к каталогу
+    // локальной ФС или подменена упакованным архивом
+    virtual bool getNativeFileName(const std::string  &fileName, std::wstring &nativeFileName) const = 0;
+    virtual bool getNativeFileName(const std::wstring &fileName, std::wstring &nativeFileName) const = 0;
+
     // Чтение проекта (из одного nut-файла или из файла проекта)
     virtual ErrorCode readNutProject(const std::string  &fileName, NutProjectA &prj) const = 0;
     virtual ErrorCode readNutProject(const std::wstring &fileName, NutProjectW &prj) const = 0;
@@ -51,6 +85,39 @@ struct IAssetsManager
     virtual ErrorCode readNutProjectComplete(NutProjectA &prj) const = 0;
     virtual ErrorCode readNutProjectComplete(NutProjectW &prj) const = 0;
 
+    // Загрузка проекта (как readNutProjectComplete) вместе с отметками всех файлов, от которых он зависит.
+    // reloadNutProjectState перечитывает только изменившиеся файлы проектов и nut-файлы и сообщает, что именно изменилось.
+    // У изменившихся nut-файлов байткод сбрасывается. При ошибке state не меняется
+    virtual ErrorCode readNutProjectState(NutProjectStateA &state) const = 0;
+    virtual ErrorCode readNutProjectState(NutProjectStateW &state) const = 0;
+    virtual ErrorCode reloadNutProjectState(NutProjectStateA &state, NutProjectChangesA &changes) const = 0;
+    virtual ErrorCode reloadNutProjectState(NutProjectStateW &state, NutProjectChangesW &changes) const = 0;
+
+    // Бандл байткода проекта (<файл проекта>.nutbc) хранит скомпилированные nut-файлы.
+    // readNutProjectComplete сам заполняет prj.nutsBytecode для nut-файлов, исходники которых не менялись.
+    // Запись бандла (prj.nutsBytecode параллелен prj.nuts и prj.nutsData) возможна только на локальный диск.
+    // Бандл читается в память, а не отображается, так что его можно перезаписывать, пока жив прочитанный проект;
+    // accessDenied - файл бандла занят кем-то ещё
+    virtual ErrorCode readNutProjectBytecode(NutProjectA &prj) const = 0;
+    virtual ErrorCode readNutProjectBytecode(NutProjectW &prj) const = 0;
+    virtual ErrorCode writeNutProjectBytecode(const NutProjectA &prj) const = 0;
+    virtual ErrorCode writeNutProjectBytecode(const NutProjectW &prj) const = 0;
+
+    // Каталог локальной ФС для кэша разобранных проектов (readNutProjectComplete). Пустая строка отключает кэш.
+    // Кэш используется, только если все файлы проекта лежат на точках монтирования, привязанных к локальной ФС
+    virtual ErrorCode setProjectCacheDirectory(const std::string  &nativePath) = 0;
+    virtual ErrorCode setProjectCacheDirectory(const std::wstring &nativePath) = 0;
+
+    // Количество потоков для параллельной загрузки. 0 - всё читается в вызывающем потоке (по умолчанию).
+    // Параллельная загрузка требует потокобезопасного чтения из IFileSystem
+    virtual void        setLoaderThreadsCount(std::size_t numThreads) = 0;
+    virtual std::size_t getLoaderThreadsCount() const = 0;
+
+    // Все методы менеджера можно вызывать из нескольких потоков одновременно, в том числе во время перенастройки.
+    // Если реализация IFileSystem не допускает параллельных обращений, их можно сериализовать (по умолчанию выключено)
+    virtual void        setSerializeFileSystemAccess(bool serialize) = 0;
+    virtual bool        getSerializeFileSystemAccess() const = 0;
+
     virtual ErrorCode readAppSelectorManifest(NutAppSelectorManifestA &appSel) const = 0;
     virtual ErrorCode readAppSelectorManifest(NutAppSelectorManifestW &appSel) const = 0;
 
@@ -110,14 +177,76 @@ struct IAssetsManager
     virtual ErrorCode readConfJson(const std::string  &fName, nlohmann::json &j) const = 0;
     virtual ErrorCode readConfJson(const std::wstring &fName, nlohmann::json &j) const = 0;
 
+    // Разобранный конфиг из кэша - файл перечитывается и разбирается заново, только если изменилась его отметка.
+    // Документ неизменяемый и разделяется всеми, кто его запросил. readConfJson работает через тот же кэш.
+    // Кэшируются только файлы с известным менеджеру расположением (setNativeMountPoint/mountPackedArchive)
+    virtual ErrorCode readConfJsonShared(const std::string  &fName, SharedJson &j) const = 0;
+    virtual ErrorCode readConfJsonShared(const std::wstring &fName, SharedJson &j) const = 0;
+
+    // Управление кэшем разобранных конфигов. Статистика кэша - IAssetsManagerDiagnostics::getConfJsonCacheStats
+    virtual void               invalidateConfJson(const std::string  &fName) = 0;
+    virtual void               invalidateConfJson(const std::wstring &fName) = 0;
+    virtual void               clearConfJsonCache() = 0;
+
+    // Сброс кэша списков локальных каталогов, по которому отсекаются обращения к отсутствующим файлам.
+    // Списки сами сверяются с временем модификации каталогов при каждой проверке, с учётом грубой точности
+    // времени в ФС (MARTY_ASSMAN_DIR_MTIME_GRANULARITY_MS). Сброс нужен только там, где время модификации
+    // каталога ненадёжно (например, сетевая ФС с расходящимися часами)
+    virtual void               clearLookupCache() = 0;
+
     virtual ErrorCode readAssetsDataFile(const std::string  &fName, std::vector<std::uint8_t> &fData) const = 0;
     virtual ErrorCode readAssetsDataFile(const std::wstring &fName, std::vector<std::uint8_t> &fData) const = 0;
 
+    // Чтение файла ассетов в разделяемый неизменяемый буфер. Повторные чтения обслуживаются из кэша ассетов,
+    // пока не изменилась отметка файла (размер/время изменения). Как и у readConfJsonShared, кэшируются только
+    // файлы с известным менеджеру расположением (setNativeMountPoint/mountPackedArchive), файлы, доступные только
+    // через VFS, отметки не имеют и всегда читаются заново
+    virtual ErrorCode readAssetsDataFileShared(const std::string  &fName, SharedDataBuffer &fData) const = 0;
+    virtual ErrorCode readAssetsDataFileShared(const std::wstring &fName, SharedDataBuffer &fData) const = 0;
+
+    // Управление кэшем ассетов. Нулевой бюджет отключает кэширование
+    virtual void        setAssetsCacheBudget(std::size_t budgetBytes) = 0;
+    virtual std::size_t getAssetsCacheBudget() const = 0;
+    virtual void        clearAssetsCache() = 0;
+
     virtual ErrorCode readIconData(const std::string  &iconName, std::vector<std::uint8_t> &iconData) const = 0;
     virtual ErrorCode readIconData(const std::wstring &iconName, std::vector<std::uint8_t> &iconData) const = 0;
 
     virtual ErrorCode readAppIconData(std::vector<std::uint8_t> &iconData) const = 0;
 
+    // Чтение без копирования. Файлы с локального диска отображаются в память,
+    // остальные читаются в буфер. Данные валидны, пока жив DataView::holder
+    virtual ErrorCode readConfDataFileView(const std::string  &fName, DataView &view) const = 0;
+    virtual ErrorCode readConfDataFileView(const std::wstring &fName, DataView &view) const = 0;
+
+    virtual ErrorCode readAssetsDataFileView(const std::string  &fName, DataView &view) const = 0;
+    virtual ErrorCode readAssetsDataFileView(const std::wstring &fName, DataView &view) const = 0;
+
+    virtual ErrorCode readIconDataView(const std::string  &iconName, DataView &view) const = 0;
+    virtual ErrorCode readIconDataView(const std::wstring &iconName, DataView &view) const = 0;
+
+    // Асинхронное чтение в потоках ввода-вывода менеджера. Одновременные запросы одного и того же файла
+    // объединяются в одно чтение. Результат - через future и/или колбэк, колбэк вызывается в потоке ввода-вывода.
+    // Требует потокобезопасного чтения из IFileSystem. Разрушать менеджер из колбэка нельзя
+    virtual AsyncDataFuture readAssetsDataFileAsync(const std::string  &fName) const = 0;
+    virtual AsyncDataFuture readAssetsDataFileAsync(const std::wstring &fName) const = 0;
+    virtual AsyncDataFuture readAssetsDataFileAsync(const std::string  &fName, AsyncDataCallback callback) const = 0;
+    virtual AsyncDataFuture readAssetsDataFileAsync(const std::wstring &fName, AsyncDataCallback callback) const = 0;
+
+    virtual AsyncDataFuture readIconDataAsync(const std::string  &iconName) const = 0;
+    virtual AsyncDataFuture readIconDataAsync(const std::wstring &iconName) const = 0;
+    virtual AsyncDataFuture readIconDataAsync(const std::string  &iconName, AsyncDataCallback callback) const = 0;
+    virtual AsyncDataFuture readIconDataAsync(const std::wstring &iconName, AsyncDataCallback callback) const = 0;
+
+    virtual AsyncJsonFuture readConfJsonAsync(const std::string  &fName) const = 0;
+    virtual AsyncJsonFuture readConfJsonAsync(const std::wstring &fName) const = 0;
+    virtual AsyncJsonFuture readConfJsonAsync(const std::string  &fName, AsyncJsonCallback callback) const = 0;
+    virtual AsyncJsonFuture readConfJsonAsync(const std::wstring &fName, AsyncJsonCallback callback) const = 0;
+
+    // Количество потоков ввода-вывода для асинхронных запросов (не меньше 1)
+    virtual void        setAsyncIoThreadsCount(std::size_t numThreads) = 0;
+    virtual std::size_t getAsyncIoThreadsCount() const = 0;
+
 
     virtual ErrorCode loadTranslations() const = 0;
     virtual ErrorCode loadUserTranslationsFromJson(const std::string  &trJson) const = 0;
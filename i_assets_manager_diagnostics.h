@@ -0,0 +1,66 @@
+/*! \file
+    \brief Optional diagnostics interface of the assets manager: call statistics, cache statistics and mount indexes
+*/
+
+#pragma once
+
+
+#include <memory>
+#include <string>
+
+//
+#include "types.h"
+#include "mount_index.h"
+#include "api_stats.h"
+
+//
+#include "i_assets_manager.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Диагностика менеджера ассетов - для бенчмарков, тестов и отладки, прикладному коду не нужна.
+// Вынесена из IAssetsManager, чтобы тот не зависел от внутренних типов (MountIndex, ApiStats).
+// Реализация может её не поддерживать - см. getAssetsManagerDiagnostics
+struct IAssetsManagerDiagnostics
+{
+    virtual ~IAssetsManagerDiagnostics() {}
+
+    // Построенный индекс точки монтирования (см. IAssetsManager::buildMountIndex), 0 - индекса нет
+    virtual std::shared_ptr<const MountIndex> getMountIndex(const std::string  &mountPointName) const = 0;
+    virtual std::shared_ptr<const MountIndex> getMountIndex(const std::wstring &mountPointName) const = 0;
+
+    // Статистика кэша разобранных конфигов (readConfJsonShared/readConfJson)
+    virtual ConfJsonCacheStats getConfJsonCacheStats() const = 0;
+    virtual void               resetConfJsonCacheStats() = 0;
+
+    // Статистика вызовов (см. api_stats.h): количество, прочитанные из хранилища байты, попадания и промахи кэшей,
+    // ошибки по кодам и гистограмма времени выполнения. Ведётся всегда, счётчики - relaxed-атомики
+    virtual ApiStats           getApiStats(AssetsApi api) const = 0;
+    virtual void               resetApiStats() = 0;
+
+}; // struct IAssetsManagerDiagnostics
+
+//----------------------------------------------------------------------------
+// Диагностика менеджера, если реализация её поддерживает, иначе 0
+inline
+IAssetsManagerDiagnostics* getAssetsManagerDiagnostics(IAssetsManager *pAssetsManager)
+{
+    return dynamic_cast<IAssetsManagerDiagnostics*>(pAssetsManager);
+}
+
+inline
+const IAssetsManagerDiagnostics* getAssetsManagerDiagnostics(const IAssetsManager *pAssetsManager)
+{
+    return dynamic_cast<const IAssetsManagerDiagnostics*>(pAssetsManager);
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,112 @@
+/*! \file
+    \brief Declarative tables for reading structures from JSON objects
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//
+#include "nlohmann/json.hpp"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Поле схемы: основное имя ключа, альтернативное написание (например, "allowResize" и "allow-resize", может быть 0)
+// и обработчик значения. ContextType - то, что нужно обработчикам для преобразования значений (например, менеджер ассетов)
+template<typename ContextType, typename ObjectType>
+struct JsonFieldT
+{
+    typedef std::function<void(const ContextType &ctx, const nlohmann::json &j, ObjectType &obj)>  Handler;
+
+    const char      *name    = 0;
+    const char      *altName = 0;
+    Handler          handler ;
+
+}; // struct JsonFieldT
+
+//----------------------------------------------------------------------------
+// Схема объекта JSON. Объект проходится один раз: для каждого ключа за один поиск в хэш-таблице находится поле,
+// затем обработчики вызываются в порядке полей схемы, а не в порядке ключей в файле - так значения, зависящие
+// друг от друга (например, очистка списка и его пополнение), обрабатываются предсказуемо.
+// Если в объекте есть оба написания ключа, используется основное. Неизвестные ключи пропускаются
+template<typename ContextType, typename ObjectType>
+struct JsonSchemaT
+{
+    typedef JsonFieldT<ContextType, ObjectType>     Field;
+
+protected:
+
+    std::vector<Field>                                              m_fields;
+    std::unordered_map<std::string, std::pair<std::size_t, bool> >  m_keys  ; // Ключ -> индекс поля, альтернативное написание
+
+
+public:
+
+    JsonSchemaT(std::initializer_list<Field> fields)
+    : m_fields(fields)
+    {
+        for(std::size_t i=0; i!=m_fields.size(); ++i)
+        {
+            m_keys[m_fields[i].name] = std::make_pair(i, false);
+            if (m_fields[i].altName)
+            {
+                m_keys[m_fields[i].altName] = std::make_pair(i, true);
+            }
+        }
+    }
+
+    std::size_t getNumFields() const
+    {
+        return m_fields.size();
+    }
+
+    // j должен быть объектом. Исключения из обработчиков (в том числе nlohmann::json::type_error) пробрасываются
+    void apply(const ContextType &ctx, const nlohmann::json &j, ObjectType &obj) const
+    {
+        // Найденные значения по полям; второе - найдено альтернативное написание
+        std::vector< std::pair<const nlohmann::json*, bool> > values(m_fields.size(), std::pair<const nlohmann::json*, bool>(0, false));
+
+        for(auto it=j.begin(); it!=j.end(); ++it)
+        {
+            auto keyIt = m_keys.find(it.key());
+            if (keyIt==m_keys.end())
+            {
+                continue;
+            }
+
+            auto &val = values[keyIt->second.first];
+            if (!val.first || (val.second && !keyIt->second.second))
+            {
+                val.first  = &it.value();
+                val.second = keyIt->second.second;
+            }
+        }
+
+        for(std::size_t i=0; i!=m_fields.size(); ++i)
+        {
+            if (values[i].first)
+            {
+                m_fields[i].handler(ctx, *values[i].first, obj);
+            }
+        }
+    }
+
+}; // struct JsonSchemaT
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,245 @@
+/*! \file
+    \brief Read-only memory mapped files
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+//
+#include "types.h"
+
+//
+#include "umba/string_plus.h"
+
+#if defined(WIN32) || defined(_WIN32)
+
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+
+#else
+
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+
+#endif
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Отображённый в память (только для чтения) файл. Отображение живёт, пока жив объект
+struct MappedFile
+{
+
+protected:
+
+    const std::uint8_t   *m_pData = 0;
+    std::size_t           m_size  = 0;
+
+    #if defined(WIN32) || defined(_WIN32)
+    HANDLE                m_hMapping = 0;
+    #endif
+
+
+    void unmap()
+    {
+        #if defined(WIN32) || defined(_WIN32)
+
+            if (m_pData)
+            {
+                UnmapViewOfFile((LPCVOID)m_pData);
+            }
+
+            if (m_hMapping)
+            {
+                CloseHandle(m_hMapping);
+            }
+
+            m_hMapping = 0;
+
+        #else
+
+            if (m_pData)
+            {
+                munmap((void*)m_pData, m_size);
+            }
+
+        #endif
+
+        m_pData = 0;
+        m_size  = 0;
+    }
+
+
+public:
+
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    ~MappedFile()
+    {
+        unmap();
+    }
+
+    const std::uint8_t* data() const { return m_pData; }
+    std::size_t         size() const { return m_size ; }
+
+
+    ErrorCode open(const std::wstring &nativeFileName)
+    {
+        unmap();
+
+        #if defined(WIN32) || defined(_WIN32)
+
+            HANDLE hFile = CreateFileW( nativeFileName.c_str(), GENERIC_READ, FILE_SHARE_READ
+                                      , 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0
+                                      );
+            if (hFile==INVALID_HANDLE_VALUE)
+            {
+                DWORD lastErr = GetLastError();
+                if (lastErr==ERROR_FILE_NOT_FOUND || lastErr==ERROR_PATH_NOT_FOUND)
+                {
+                    return ErrorCode::notFound;
+                }
+                if (lastErr==ERROR_ACCESS_DENIED)
+                {
+                    return ErrorCode::accessDenied;
+                }
+                return ErrorCode::genericError;
+            }
+
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(hFile, &fileSize))
+            {
+                CloseHandle(hFile);
+                return ErrorCode::genericError;
+            }
+
+            if (fileSize.QuadPart==0)
+            {
+                // Пустой файл отобразить нельзя, но это не ошибка
+                CloseHandle(hFile);
+                return ErrorCode::ok;
+            }
+
+            m_hMapping = CreateFileMappingW(hFile, 0, PAGE_READONLY, 0, 0, 0);
+            CloseHandle(hFile); // Отображение держит файл само
+
+            if (!m_hMapping)
+            {
+                return ErrorCode::genericError;
+            }
+
+            m_pData = (const std::uint8_t*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (!m_pData)
+            {
+                unmap();
+                return ErrorCode::genericError;
+            }
+
+            m_size = (std::size_t)fileSize.QuadPart;
+
+        #else
+
+            int fd = ::open(umba::toUtf8(nativeFileName).c_str(), O_RDONLY);
+            if (fd<0)
+            {
+                if (errno==ENOENT || errno==ENOTDIR)
+                {
+                    return ErrorCode::notFound;
+                }
+                if (errno==EACCES)
+                {
+                    return ErrorCode::accessDenied;
+                }
+                return ErrorCode::genericError;
+            }
+
+            struct stat st;
+            if (::fstat(fd, &st)!=0 || !S_ISREG(st.st_mode))
+            {
+                ::close(fd);
+                return ErrorCode::genericError;
+            }
+
+            if (st.st_size==0)
+            {
+                // Пустой файл отобразить нельзя, но это не ошибка
+                ::close(fd);
+                return ErrorCode::ok;
+            }
+
+            void *p = ::mmap(0, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd); // Отображение держит файл само
+
+            if (p==MAP_FAILED)
+            {
+                return ErrorCode::genericError;
+            }
+
+            m_pData = (const std::uint8_t*)p;
+            m_size  = (std::size_t)st.st_size;
+
+        #endif
+
+        return ErrorCode::ok;
+    }
+
+}; // struct MappedFile
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+inline
+ErrorCode mapFileDataView(const std::wstring &nativeFileName, DataView &view)
+{
+    auto pMapped = std::make_shared<MappedFile>();
+    ErrorCode err = pMapped->open(nativeFileName);
+    if (err!=ErrorCode::ok)
+    {
+        return err;
+    }
+
+    view.data   = pMapped->data();
+    view.size   = pMapped->size();
+    view.holder = pMapped;
+
+    return ErrorCode::ok;
+}
+
+//----------------------------------------------------------------------------
+inline
+DataView makeDataView(const SharedDataBuffer &buf)
+{
+    DataView view;
+    if (buf)
+    {
+        view.data   = buf->data();
+        view.size   = buf->size();
+        view.holder = buf;
+    }
+
+    return view;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,329 @@
+/*! \file
+    \brief In-memory index of files under a local mount point directory
+*/
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+//
+#include "types.h"
+#include "case_fold.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+struct MountIndexEntry
+{
+    std::wstring    key  ; // Путь относительно точки монтирования, разделитель '/', в верхнем регистре (caseFoldChar)
+    std::wstring    name ; // Тот же путь в исходном регистре
+    std::uint64_t   size  = 0;
+    std::int64_t    mtime = 0; // В тех же единицах, что и FileStamp::mtime
+    bool            isDir = false;
+
+}; // struct MountIndexEntry
+
+//----------------------------------------------------------------------------
+// Снимок содержимого каталога точки монтирования - плоский массив, отсортированный по пути в верхнем регистре.
+// Строится один раз (при старте или по изменению), после этого проверки наличия файлов и поиск файлов
+// по расширению идут по массиву, без обращения к ФС. Снимок неизменяемый - для обновления строится новый.
+// Поиск без учёта регистра на Windows и с учётом регистра на остальных платформах - как в самой ФС.
+// Если замечено, что снимок разошёлся с диском, он помечается устаревшим (markStale) и до перестроения не используется
+struct MountIndex
+{
+
+protected:
+
+    std::wstring                     m_nativeRoot;
+    std::vector<MountIndexEntry>     m_entries   ;
+    mutable std::atomic<bool>        m_stale     {false};
+
+
+    // Символ запроса в том виде, в котором он хранится в ключе
+    static wchar_t keyChar(wchar_t ch)
+    {
+        return ch==L'\\' ? L'/' : caseFoldChar(ch);
+    }
+
+    static wchar_t nameChar(wchar_t ch)
+    {
+        return ch==L'\\' ? L'/' : ch;
+    }
+
+    // Сравнение ключа с началом запроса длиной queryLen (запрос приводится к виду ключа на лету)
+    static int compareKey(const std::wstring &key, const wchar_t *pQuery, std::size_t queryLen)
+    {
+        std::size_t n = std::min(key.size(), queryLen);
+        for(std::size_t i=0; i!=n; ++i)
+        {
+            wchar_t qch = keyChar(pQuery[i]);
+            if (key[i]!=qch)
+            {
+                return key[i]<qch ? -1 : 1;
+            }
+        }
+
+        if (key.size()==queryLen)
+        {
+            return 0;
+        }
+
+        return key.size()<queryLen ? -1 : 1;
+    }
+
+    static bool isSameName(const std::wstring &name, const wchar_t *pQuery, std::size_t queryLen)
+    {
+        if (name.size()!=queryLen)
+        {
+            return false;
+        }
+
+        for(std::size_t i=0; i!=queryLen; ++i)
+        {
+            if (name[i]!=nameChar(pQuery[i]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Первый элемент, ключ которого не меньше запроса
+    std::vector<MountIndexEntry>::const_iterator lowerBound(const wchar_t *pQuery, std::size_t queryLen) const
+    {
+        return std::lower_bound( m_entries.begin(), m_entries.end(), 0
+                               , [&](const MountIndexEntry &e, int)
+                                 {
+                                     return compareKey(e.key, pQuery, queryLen)<0;
+                                 }
+                               );
+    }
+
+    static void skipLeadingSeparators(const std::wstring &path, const wchar_t *&pPath, std::size_t &len)
+    {
+        pPath = path.data();
+        len   = path.size();
+        while(len && (*pPath==L'/' || *pPath==L'\\'))
+        {
+            ++pPath;
+            --len;
+        }
+    }
+
+
+public:
+
+    // Ошибки отдельных элементов (нет доступа и т.п.) пропускаются, ошибкой считается только отсутствие самого каталога
+    ErrorCode build(const std::wstring &nativeRoot)
+    {
+        m_nativeRoot = nativeRoot;
+        m_entries.clear();
+
+        std::error_code ec;
+        std::filesystem::path rootPath(nativeRoot);
+        if (!std::filesystem::is_directory(rootPath, ec))
+        {
+            return ErrorCode::notDirectory;
+        }
+
+        const auto options = std::filesystem::directory_options::skip_permission_denied;
+        for(std::filesystem::recursive_directory_iterator it(rootPath, options, ec), end; !ec && it!=end; it.increment(ec))
+        {
+            const std::filesystem::directory_entry &de = *it;
+
+            MountIndexEntry entry;
+            entry.name = de.path().lexically_relative(rootPath).generic_wstring();
+            entry.key.reserve(entry.name.size());
+            for(auto ch : entry.name)
+            {
+                entry.key.push_back(keyChar(ch));
+            }
+
+            std::error_code ecItem;
+            entry.isDir = de.is_directory(ecItem);
+            if (!entry.isDir)
+            {
+                auto sz = de.file_size(ecItem);
+                if (!ecItem)
+                {
+                    entry.size = (std::uint64_t)sz;
+                }
+            }
+
+            auto mt = de.last_write_time(ecItem);
+            if (!ecItem)
+            {
+                entry.mtime = (std::int64_t)mt.time_since_epoch().count();
+            }
+
+            m_entries.emplace_back(std::move(entry));
+        }
+
+        std::sort( m_entries.begin(), m_entries.end()
+                 , [](const MountIndexEntry &e1, const MountIndexEntry &e2)
+                   {
+                       return e1.key!=e2.key ? e1.key<e2.key : e1.name<e2.name;
+                   }
+                 );
+
+        return ErrorCode::ok;
+    }
+
+    bool isStale() const
+    {
+        return m_stale.load(std::memory_order_relaxed);
+    }
+
+    void markStale() const
+    {
+        m_stale.store(true, std::memory_order_relaxed);
+    }
+
+    const std::wstring& getNativeRoot() const
+    {
+        return m_nativeRoot;
+    }
+
+    const std::vector<MountIndexEntry>& getEntries() const
+    {
+        return m_entries;
+    }
+
+    // relPath - путь относительно точки монтирования, разделители - '/' или '\\'. 0 - такого нет
+    const MountIndexEntry* find(const std::wstring &relPath) const
+    {
+        const wchar_t *pPath   = 0;
+        std::size_t    pathLen = 0;
+        skipLeadingSeparators(relPath, pPath, pathLen);
+
+        for(auto it=lowerBound(pPath, pathLen); it!=m_entries.end() && compareKey(it->key, pPath, pathLen)==0; ++it)
+        {
+            #if defined(WIN32) || defined(_WIN32)
+            return &*it;
+            #else
+            if (isSameName(it->name, pPath, pathLen))
+            {
+                return &*it;
+            }
+            #endif
+        }
+
+        return 0;
+    }
+
+    // Снимок знает файл relPath именно в таком состоянии (наличие, размер, время модификации)
+    bool matchesStamp(const std::wstring &relPath, const FileStamp &stamp) const
+    {
+        const MountIndexEntry *pEntry = find(relPath);
+        if (!stamp.exists)
+        {
+            return pEntry==0;
+        }
+
+        return pEntry && pEntry->size==stamp.size && pEntry->mtime==stamp.mtime;
+    }
+
+    // Файлы каталога relDir (пустой - корень точки монтирования) с расширением ext (например, ".nut", пустое - любые),
+    // recursive - вместе с подкаталогами. Каталог ищется как в find - без учёта регистра только на Windows.
+    // Расширение - фильтр по типу файла и сравнивается без учёта регистра на всех платформах
+    void findFiles( const std::wstring                   &relDir
+                  , const std::wstring                   &ext
+                  , bool                                  recursive
+                  , std::vector<const MountIndexEntry*>  &found
+                  ) const
+    {
+        const wchar_t *pDir   = 0;
+        std::size_t    dirLen = 0;
+        skipLeadingSeparators(relDir, pDir, dirLen);
+        while(dirLen && (pDir[dirLen-1]==L'/' || pDir[dirLen-1]==L'\\'))
+        {
+            --dirLen;
+        }
+
+        std::wstring prefix; // Ключ каталога с завершающим '/'
+        prefix.reserve(dirLen+1);
+        for(std::size_t i=0; i!=dirLen; ++i)
+        {
+            prefix.push_back(keyChar(pDir[i]));
+        }
+
+        if (!prefix.empty())
+        {
+            prefix.push_back(L'/');
+        }
+
+        #if !defined(WIN32) && !defined(_WIN32)
+        std::wstring namePrefix; // Каталог в исходном регистре - ключи совпадают и у каталогов, отличающихся только регистром
+        namePrefix.reserve(prefix.size());
+        for(std::size_t i=0; i!=dirLen; ++i)
+        {
+            namePrefix.push_back(nameChar(pDir[i]));
+        }
+
+        if (!namePrefix.empty())
+        {
+            namePrefix.push_back(L'/');
+        }
+        #endif
+
+        std::wstring extKey;
+        extKey.reserve(ext.size());
+        for(auto ch : ext)
+        {
+            extKey.push_back(keyChar(ch));
+        }
+
+        for(auto it=lowerBound(prefix.data(), prefix.size()); it!=m_entries.end(); ++it)
+        {
+            const std::wstring &key = it->key;
+            if (key.compare(0, prefix.size(), prefix)!=0)
+            {
+                break; // Ключи с этим префиксом идут подряд
+            }
+
+            if (it->isDir)
+            {
+                continue;
+            }
+
+            #if !defined(WIN32) && !defined(_WIN32)
+            if (it->name.compare(0, namePrefix.size(), namePrefix)!=0)
+            {
+                continue;
+            }
+            #endif
+
+            if (!recursive && key.find(L'/', prefix.size())!=key.npos)
+            {
+                continue;
+            }
+
+            if (key.size()<extKey.size() || key.compare(key.size()-extKey.size(), extKey.size(), extKey)!=0)
+            {
+                continue;
+            }
+
+            found.emplace_back(&*it);
+        }
+    }
+
+}; // struct MountIndex
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
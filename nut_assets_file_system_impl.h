@@ -17,7 +17,15 @@
 #include "umba/filesys.h"
 
 //
+#include "i_assets_manager.h"
+#include "packed_archive.h"
+#include "profiler.h"
+
+//
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace marty_assets {
 
@@ -33,6 +41,8 @@ namespace marty_assets {
 inline
 void configureNutAssetsFilesystem(marty_virtual_fs::IAppPaths *pAppPaths, marty_virtual_fs::IVirtualFs *pVirtualFs)
 {
+    MARTY_ASSMAN_PROFILE_SCOPE(profileScope, "configureNutAssetsFilesystem");
+
     pVirtualFs->clearMounts();
 
     std::wstring appRootPath;
@@ -74,6 +84,101 @@ void configureNutAssetsFilesystem(marty_virtual_fs::IAppPaths *pAppPaths, marty_
 
 }
 
+//----------------------------------------------------------------------------
+// Сообщаем менеджеру ассетов, какие каталоги локальной ФС стоят за точками монтирования,
+// созданными configureNutAssetsFilesystem
+inline
+void configureNutAssetsNativeMountPoints(marty_virtual_fs::IAppPaths *pAppPaths, marty_assets_manager::IAssetsManager *pAssetsManager)
+{
+    pAssetsManager->clearNativeMountPoints();
+
+    std::wstring appRootPath;
+
+    if (!pAppPaths->getAppRootPath(appRootPath))
+    {
+        return; // Без корня ничего не привязываем, всё будет читаться через VFS
+    }
+
+    static const std::vector<std::wstring> mountPointNames = { L"conf", L"nuts", L"assets", L"translations", L"manifests" };
+
+    for(const auto &mpName : mountPointNames)
+    {
+        pAssetsManager->setNativeMountPoint(mpName, umba::filename::appendPath(appRootPath, mpName));
+    }
+
+    std::wstring appSelectorManifestFileName = umba::string_plus::make_string<std::wstring>("dotnut.app-selector.manifest.json");
+    std::wstring appSelectorManifestFullName = umba::filename::appendPath(appRootPath, appSelectorManifestFileName);
+    if (umba::filesys::isFileReadable(appSelectorManifestFullName))
+    {
+        pAssetsManager->setNativeMountPoint(appSelectorManifestFileName, appSelectorManifestFullName);
+    }
+
+}
+
+//----------------------------------------------------------------------------
+// Упакованные архивы лежат в корне приложения рядом с каталогами: conf.assetpack, nuts.assetpack и т.д.
+// Если архив есть, точка монтирования читается из него, а не из каталога
+inline
+void configureNutAssetsPackedArchives(marty_virtual_fs::IAppPaths *pAppPaths, marty_assets_manager::IAssetsManager *pAssetsManager)
+{
+    pAssetsManager->unmountPackedArchives();
+
+    std::wstring appRootPath;
+
+    if (!pAppPaths->getAppRootPath(appRootPath))
+    {
+        return;
+    }
+
+    static const std::vector<std::wstring> mountPointNames = { L"conf", L"nuts", L"assets", L"translations", L"manifests" };
+
+    for(const auto &mpName : mountPointNames)
+    {
+        std::wstring archiveFullName = umba::filename::appendPath(appRootPath, mpName + L".assetpack");
+        if (umba::filesys::isFileReadable(archiveFullName))
+        {
+            pAssetsManager->mountPackedArchive(mpName, archiveFullName);
+            // Битый архив просто не подключается, будем читать из каталога
+        }
+    }
+
+}
+
+//----------------------------------------------------------------------------
+// Упаковка каталогов приложения в архивы для configureNutAssetsPackedArchives. Вызывается при сборке дистрибутива.
+// codec - см. marty_assets_manager::packed_archive::codec*
+inline
+marty_assets_manager::ErrorCode buildNutAssetsPackedArchives( marty_virtual_fs::IAppPaths *pAppPaths
+                                                            , std::uint32_t codec = marty_assets_manager::packed_archive::codecNone
+                                                            )
+{
+    std::wstring appRootPath;
+
+    if (!pAppPaths->getAppRootPath(appRootPath))
+    {
+        return marty_assets_manager::ErrorCode::notFound;
+    }
+
+    static const std::vector<std::wstring> mountPointNames = { L"conf", L"nuts", L"assets", L"translations", L"manifests" };
+
+    for(const auto &mpName : mountPointNames)
+    {
+        std::wstring dirFullName = umba::filename::appendPath(appRootPath, mpName);
+        if (!umba::filesys::isPathDirectory(dirFullName))
+        {
+            continue;
+        }
+
+        auto err = marty_assets_manager::buildPackedArchiveFromDirectory(dirFullName, dirFullName + L".assetpack", codec);
+        if (err!=marty_assets_manager::ErrorCode::ok)
+        {
+            return err;
+        }
+    }
+
+    return marty_assets_manager::ErrorCode::ok;
+}
+
 //----------------------------------------------------------------------------
 inline
 std::shared_ptr<marty_virtual_fs::IFileSystem> makeNutAssetsFilesystemSharedPtr()
@@ -0,0 +1,208 @@
+/*! \file
+    \brief Bundle of precompiled nut scripts bytecode
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+#include "types.h"
+#include "binary_stream.h"
+#include "hash_utils.h"
+
+//
+#include "umba/string_plus.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Бандл хранит байткод nut-файлов проекта в порядке проекта.
+// Каждая запись привязана к имени nut-файла и хэшу/размеру его исходника,
+// байткод выдаётся, только если исходник с тех пор не менялся.
+//
+// Формат (все числа - little endian, строки - UTF-8). Не зависит ни от платформы, ни от того, в узких
+// или широких строках загружен проект - бандл, записанный для NutProjectW, читается и для NutProjectA:
+//   u32 signature, u32 version, u32 numEntries
+//   Записи: u32 nameSize, имя nut-файла (nameSize байт), u64 sourceHash, u64 sourceSize, u64 bytecodeSize, байткод
+//   sourceHash - FNV-1a по байтам исходника в UTF-8, sourceSize - размер исходника в UTF-8
+namespace nut_bytecode_bundle {
+
+const std::uint32_t signature = 0x3143424Eu; // "NBC1"
+const std::uint32_t version   = 2u;
+
+} // namespace nut_bytecode_bundle
+
+//----------------------------------------------------------------------------
+struct NutBytecodeBundleEntry
+{
+    std::uint64_t   sourceHash = 0; // См. getNutSourceDigest
+    std::uint64_t   sourceSize = 0; // В байтах UTF-8
+    DataView        bytecode  ;     // Ссылается на данные бандла
+
+}; // struct NutBytecodeBundleEntry
+
+//----------------------------------------------------------------------------
+struct NutSourceDigest
+{
+    std::uint64_t   hash = 0;
+    std::uint64_t   size = 0;
+
+}; // struct NutSourceDigest
+
+// Хэш и размер исходника в UTF-8 - одинаковые для узкой и широкой строки с тем же текстом
+template<typename StringType> inline
+NutSourceDigest getNutSourceDigest(const StringType &nutSource)
+{
+    NutSourceDigest digest;
+
+    if constexpr (sizeof(typename StringType::value_type)>1)
+    {
+        const std::string utf8 = umba::toUtf8(nutSource);
+        digest.hash = hashFnv1a64(utf8.data(), utf8.size());
+        digest.size = (std::uint64_t)utf8.size();
+    }
+    else
+    {
+        digest.hash = hashFnv1a64(nutSource.data(), nutSource.size());
+        digest.size = (std::uint64_t)nutSource.size();
+    }
+
+    return digest;
+}
+
+template<typename StringType> inline
+std::string nutBundleNameToUtf8(const StringType &name)
+{
+    if constexpr (sizeof(typename StringType::value_type)>1)
+    {
+        return umba::toUtf8(name);
+    }
+    else
+    {
+        return name;
+    }
+}
+
+template<typename StringType> inline
+StringType nutBundleNameFromUtf8(const std::string &name)
+{
+    if constexpr (sizeof(typename StringType::value_type)>1)
+    {
+        return umba::fromUtf8(name);
+    }
+    else
+    {
+        return name;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Записываются только nut-файлы, для которых есть байткод
+template<typename StringType> inline
+bool serializeNutBytecodeBundle(const NutProjectT<StringType> &prj, std::vector<std::uint8_t> &data)
+{
+    const std::size_t numNuts = prj.nuts.size();
+    if (prj.nutsData.size()!=numNuts || prj.nutsBytecode.size()!=numNuts)
+    {
+        return false;
+    }
+
+    std::uint32_t numEntries = 0;
+    for(const auto &bc : prj.nutsBytecode)
+    {
+        if (!bc.empty())
+        {
+            ++numEntries;
+        }
+    }
+
+    BinaryWriter w;
+
+    w.writeU32(nut_bytecode_bundle::signature);
+    w.writeU32(nut_bytecode_bundle::version);
+    w.writeU32(numEntries);
+
+    for(std::size_t i=0; i!=numNuts; ++i)
+    {
+        const DataView &bc = prj.nutsBytecode[i];
+        if (bc.empty())
+        {
+            continue;
+        }
+
+        const NutSourceDigest digest = getNutSourceDigest(prj.nutsData[i]);
+
+        w.writeString(nutBundleNameToUtf8(prj.nuts[i]));
+        w.writeU64(digest.hash);
+        w.writeU64(digest.size);
+        w.writeU64((std::uint64_t)bc.size);
+        w.writeBytes(bc.data, bc.size);
+    }
+
+    data = std::move(w.data);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Байткод в записях не копируется - DataView записей ссылаются на данные бандла и продлевают ему жизнь
+template<typename StringType> inline
+bool parseNutBytecodeBundle(const DataView &bundle, std::unordered_map<StringType, NutBytecodeBundleEntry> &entries)
+{
+    BinaryReader r(bundle.data, bundle.size);
+
+    if ( r.readU32()!=nut_bytecode_bundle::signature
+      || r.readU32()!=nut_bytecode_bundle::version
+       )
+    {
+        return false;
+    }
+
+    std::size_t numEntries = r.readU32();
+    if (numEntries>r.getRemainingSize())
+    {
+        return false;
+    }
+
+    entries.clear();
+    entries.reserve(numEntries);
+
+    for(std::size_t i=0; i!=numEntries && r.ok(); ++i)
+    {
+        StringType nutName = nutBundleNameFromUtf8<StringType>(r.readString<std::string>());
+
+        NutBytecodeBundleEntry entry;
+        entry.sourceHash = r.readU64();
+        entry.sourceSize = r.readU64();
+
+        std::uint64_t bcSize = r.readU64();
+        if (bcSize>r.getRemainingSize())
+        {
+            return false;
+        }
+
+        entry.bytecode.data   = r.readBytes((std::size_t)bcSize);
+        entry.bytecode.size   = (std::size_t)bcSize;
+        entry.bytecode.holder = bundle.holder;
+
+        entries[nutName] = entry;
+    }
+
+    return r.ok();
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,181 @@
+/*! \file
+    \brief Binary cache of resolved nut projects
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+#include "types.h"
+#include "binary_stream.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Разобранный проект вместе с отметками всех файлов, от которых зависит результат разбора:
+// файлов проектов, nut-файлов, а также файлов-кандидатов, которые проверялись, но не подошли.
+// Если все отметки совпадают с текущим состоянием файлов, проект можно брать из кэша без разбора
+template<typename StringType>
+struct NutProjectCacheT
+{
+    StringType                                         projectName;
+    std::vector< std::pair<StringType, FileStamp> >    stamps     ; // Полные имена в VFS
+    NutProjectT<StringType>                            project    ; // Без nutsData
+
+}; // struct NutProjectCacheT
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+namespace nut_project_cache {
+
+const std::uint32_t signature = 0x3143504Eu; // "NPC1"
+const std::uint32_t version   = 1u;
+
+} // namespace nut_project_cache
+
+//----------------------------------------------------------------------------
+template<typename StringType> inline
+void serializeNutProjectCache(const NutProjectCacheT<StringType> &cache, std::vector<std::uint8_t> &data)
+{
+    BinaryWriter w;
+
+    w.writeU32(nut_project_cache::signature);
+    w.writeU32(nut_project_cache::version);
+    w.writeU32((std::uint32_t)sizeof(typename StringType::value_type));
+
+    w.writeString(cache.projectName);
+
+    w.writeU32((std::uint32_t)cache.stamps.size());
+    for(const auto &st : cache.stamps)
+    {
+        w.writeString(st.first);
+        w.writeStamp(st.second);
+    }
+
+    const NutProjectT<StringType> &prj = cache.project;
+
+    w.writeString(prj.projectFileName);
+
+    w.writeU32((std::uint32_t)prj.nuts.size());
+    for(const auto &nut : prj.nuts)
+    {
+        w.writeString(nut);
+    }
+
+    w.writeU32((std::uint32_t)prj.projectFiles.size());
+    for(const auto &prjFile : prj.projectFiles)
+    {
+        w.writeString(prjFile);
+    }
+
+    w.writeU32((std::uint32_t)prj.projectIncludes.size());
+    for(const auto &inc : prj.projectIncludes)
+    {
+        w.writeU32((std::uint32_t)inc.first );
+        w.writeU32((std::uint32_t)inc.second);
+    }
+
+    data = std::move(w.data);
+}
+
+//----------------------------------------------------------------------------
+template<typename StringType> inline
+bool deserializeNutProjectCache(const std::vector<std::uint8_t> &data, NutProjectCacheT<StringType> &cache)
+{
+    BinaryReader r(data.data(), data.size());
+
+    if ( r.readU32()!=nut_project_cache::signature
+      || r.readU32()!=nut_project_cache::version
+      || r.readU32()!=(std::uint32_t)sizeof(typename StringType::value_type)
+       )
+    {
+        return false;
+    }
+
+    cache.projectName = r.readString<StringType>();
+
+    // Количество элементов не может превышать количество оставшихся байт - защита от мусора в файле
+    std::size_t numStamps = r.readU32();
+    if (numStamps>r.getRemainingSize())
+    {
+        return false;
+    }
+
+    cache.stamps.clear();
+    cache.stamps.reserve(numStamps);
+    for(std::size_t i=0; i!=numStamps && r.ok(); ++i)
+    {
+        StringType name  = r.readString<StringType>();
+        FileStamp  stamp = r.readStamp();
+        cache.stamps.emplace_back(std::move(name), stamp);
+    }
+
+    NutProjectT<StringType> &prj = cache.project;
+    prj.clear();
+
+    prj.projectFileName = r.readString<StringType>();
+
+    std::size_t numNuts = r.readU32();
+    if (numNuts>r.getRemainingSize())
+    {
+        return false;
+    }
+
+    prj.nuts.reserve(numNuts);
+    for(std::size_t i=0; i!=numNuts && r.ok(); ++i)
+    {
+        prj.nuts.emplace_back(r.readString<StringType>());
+    }
+
+    std::size_t numPrjFiles = r.readU32();
+    if (numPrjFiles>r.getRemainingSize())
+    {
+        return false;
+    }
+
+    prj.projectFiles.reserve(numPrjFiles);
+    for(std::size_t i=0; i!=numPrjFiles && r.ok(); ++i)
+    {
+        prj.projectFiles.emplace_back(r.readString<StringType>());
+    }
+
+    std::size_t numIncludes = r.readU32();
+    if (numIncludes>r.getRemainingSize())
+    {
+        return false;
+    }
+
+    prj.projectIncludes.reserve(numIncludes);
+    for(std::size_t i=0; i!=numIncludes && r.ok(); ++i)
+    {
+        std::size_t from = r.readU32();
+        std::size_t to   = r.readU32();
+        if (from>=numPrjFiles || to>=numPrjFiles)
+        {
+            return false;
+        }
+
+        prj.projectIncludes.emplace_back(from, to);
+    }
+
+    return r.ok();
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
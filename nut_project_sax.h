@@ -0,0 +1,249 @@
+/*! \file
+    \brief Streaming (SAX) parser for JSON nut project files
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+#include "types.h"
+#include "config_text_format.h"
+
+//
+#include "nlohmann/json.hpp"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Разбор файла проекта ({"files": ["a.nut", {"include": "sub.nuts.json"}, {"include": ["x.nut", "y.nuts.json"]}]})
+// без построения DOM. Собираются только имена из "files" как есть (без преобразования путей), остальное пропускается.
+// Ошибки структуры - как у разбора через DOM: 'files' не массив или объект без 'include' - invalidFormat,
+// значение не строка - unknownFormat. Об объекте без 'include' разбор через DOM не сообщает - для него
+// выставляется quietError. Синтаксическая ошибка - syntaxError, такой текст стоит разобрать
+// универсальным (YAML-совместимым) путём
+struct NutProjectJsonSaxHandler : public nlohmann::json_sax<nlohmann::json>
+{
+    std::vector< std::pair<bool, std::string> >     items      ; // true - подключение (include), false - nut-файл
+    ErrorCode                                       errorCode  = ErrorCode::ok;
+    std::string                                     errorText  ;
+    bool                                            syntaxError= false;
+    bool                                            quietError = false; // Ошибка, о которой не сообщаем (только код возврата)
+
+protected:
+
+    std::size_t     m_depth            = 0;
+    bool            m_filesKey         = false; // Последний ключ корневого объекта - "files"
+    bool            m_inFiles          = false;
+    bool            m_inFileObject     = false;
+    bool            m_includeKey       = false; // Последний ключ объекта в "files" - "include"
+    bool            m_inIncludeArray   = false;
+    bool            m_objectHasInclude = false;
+    std::size_t     m_objectItemsStart = 0;
+
+
+    bool fail(ErrorCode err, const char *text)
+    {
+        errorCode = err;
+        errorText = text;
+        return false;
+    }
+
+    bool isFilesValue() const
+    {
+        return m_depth==1 && m_filesKey;
+    }
+
+    bool isFilesItem() const
+    {
+        return m_inFiles && m_depth==2;
+    }
+
+    bool isIncludeValue() const
+    {
+        return m_inFileObject && m_depth==3 && m_includeKey;
+    }
+
+    bool isIncludeItem() const
+    {
+        return m_inIncludeArray && m_depth==4;
+    }
+
+    // Не строковое скалярное значение
+    bool scalar()
+    {
+        if (isFilesValue())
+        {
+            return fail(ErrorCode::invalidFormat, "'files' node must be an array");
+        }
+
+        if (isFilesItem() || isIncludeValue() || isIncludeItem())
+        {
+            return fail(ErrorCode::unknownFormat, "file name must be a string");
+        }
+
+        return true;
+    }
+
+
+public:
+
+    virtual bool null() override                                        { return scalar(); }
+    virtual bool boolean(bool) override                                 { return scalar(); }
+    virtual bool number_integer(number_integer_t) override              { return scalar(); }
+    virtual bool number_unsigned(number_unsigned_t) override            { return scalar(); }
+    virtual bool number_float(number_float_t, const string_t&) override { return scalar(); }
+    virtual bool binary(binary_t&) override                             { return scalar(); }
+
+    virtual bool string(string_t &val) override
+    {
+        if (isFilesValue())
+        {
+            return fail(ErrorCode::invalidFormat, "'files' node must be an array");
+        }
+
+        if (isFilesItem())
+        {
+            items.emplace_back(false, std::move(val));
+        }
+        else if (isIncludeValue())
+        {
+            // Повторный 'include' в том же объекте заменяет предыдущий
+            items.resize(m_objectItemsStart);
+            items.emplace_back(true, std::move(val));
+            m_objectHasInclude = true;
+        }
+        else if (isIncludeItem())
+        {
+            items.emplace_back(true, std::move(val));
+        }
+
+        return true;
+    }
+
+    virtual bool start_object(std::size_t) override
+    {
+        if (isFilesValue())
+        {
+            return fail(ErrorCode::invalidFormat, "'files' node must be an array");
+        }
+
+        if (isIncludeValue() || isIncludeItem())
+        {
+            return fail(ErrorCode::unknownFormat, "file name must be a string");
+        }
+
+        if (isFilesItem())
+        {
+            m_inFileObject     = true;
+            m_includeKey       = false;
+            m_objectHasInclude = false;
+            m_objectItemsStart = items.size();
+        }
+
+        ++m_depth;
+        return true;
+    }
+
+    virtual bool end_object() override
+    {
+        --m_depth;
+
+        if (m_inFileObject && m_depth==2)
+        {
+            m_inFileObject = false;
+            if (!m_objectHasInclude)
+            {
+                quietError = true;
+                return fail(ErrorCode::invalidFormat, "object in 'files' must contain 'include'");
+            }
+        }
+
+        return true;
+    }
+
+    virtual bool start_array(std::size_t) override
+    {
+        if (isFilesValue())
+        {
+            // Повторный 'files' заменяет предыдущий
+            items.clear();
+            m_inFiles = true;
+        }
+        else if (isFilesItem() || isIncludeItem())
+        {
+            return fail(ErrorCode::unknownFormat, "file name must be a string");
+        }
+        else if (isIncludeValue())
+        {
+            items.resize(m_objectItemsStart);
+            m_inIncludeArray   = true;
+            m_objectHasInclude = true;
+        }
+
+        ++m_depth;
+        return true;
+    }
+
+    virtual bool end_array() override
+    {
+        --m_depth;
+
+        if (m_inFiles && m_depth==1)
+        {
+            m_inFiles = false;
+        }
+        else if (m_inIncludeArray && m_depth==3)
+        {
+            m_inIncludeArray = false;
+        }
+
+        return true;
+    }
+
+    virtual bool key(string_t &val) override
+    {
+        if (m_depth==1)
+        {
+            m_filesKey = val=="files";
+        }
+        else if (m_inFileObject && m_depth==3)
+        {
+            m_includeKey = val=="include";
+        }
+
+        return true;
+    }
+
+    virtual bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception &e) override
+    {
+        syntaxError = true;
+        errorCode   = ErrorCode::unknownFormat;
+        errorText   = e.what();
+        return false;
+    }
+
+}; // struct NutProjectJsonSaxHandler
+
+//----------------------------------------------------------------------------
+// Разбор JSON-текста файла проекта. false - разобрать не удалось, причина - в handler
+inline
+bool parseNutProjectJsonText(const std::string &text, NutProjectJsonSaxHandler &handler)
+{
+    // BOM nlohmann пропускает сам
+    return nlohmann::json::sax_parse(text, &handler) && handler.errorCode==ErrorCode::ok;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -0,0 +1,193 @@
+/*! \file
+    \brief Table-driven detection of nut file types by file name suffix
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+//
+#include "enums.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Определение типа nut-файла по суффиксу имени без учёта регистра.
+// Суффиксы хранятся в дереве, построенном по перевёрнутым суффиксам; имя проходится один раз с конца,
+// без копирования и без выделения памяти. Если подходят несколько суффиксов, побеждает самый длинный
+// (например, .MANIFEST.JSON важнее .JSON, а DOTNUT.APP-SELECTOR.MANIFEST.JSON важнее .MANIFEST.JSON)
+struct NutTypeSuffixMatcher
+{
+
+protected:
+
+    // Алфавит суффиксов: A-Z, '.', '-'
+    static const std::size_t alphabetSize = 28;
+
+    struct Node
+    {
+        std::int16_t    next[alphabetSize];
+        NutType         nutType = NutType::invalid; // invalid - на этом узле суффикс не заканчивается
+
+        Node()
+        {
+            for(auto &n : next)
+            {
+                n = -1;
+            }
+        }
+    };
+
+    std::vector<Node>   m_nodes;
+
+
+    template<typename CharType>
+    static int charIndex(CharType ch)
+    {
+        if (ch>=(CharType)'a' && ch<=(CharType)'z')
+        {
+            return (int)(ch-(CharType)'a');
+        }
+
+        if (ch>=(CharType)'A' && ch<=(CharType)'Z')
+        {
+            return (int)(ch-(CharType)'A');
+        }
+
+        if (ch==(CharType)'.')
+        {
+            return 26;
+        }
+
+        if (ch==(CharType)'-')
+        {
+            return 27;
+        }
+
+        return -1;
+    }
+
+    void addSuffix(const char *suffix, NutType nutType)
+    {
+        std::size_t len = 0;
+        while(suffix[len])
+        {
+            ++len;
+        }
+
+        std::size_t nodeIdx = 0;
+        for(std::size_t i=len; i!=0; --i)
+        {
+            int ci = charIndex(suffix[i-1]);
+
+            if (m_nodes[nodeIdx].next[ci]<0)
+            {
+                m_nodes[nodeIdx].next[ci] = (std::int16_t)m_nodes.size();
+                m_nodes.emplace_back();
+            }
+
+            nodeIdx = (std::size_t)m_nodes[nodeIdx].next[ci];
+        }
+
+        m_nodes[nodeIdx].nutType = nutType;
+    }
+
+
+public:
+
+    NutTypeSuffixMatcher()
+    {
+        m_nodes.reserve(256);
+        m_nodes.emplace_back(); // корень
+
+        addSuffix(".NUT"                             , NutType::nutFile          ); // single file suffix
+
+        addSuffix(".NUTSJSNPROJ"                     , NutType::dotNutProject    ); // project suffix
+        addSuffix(".NUTJSNPROJ"                      , NutType::dotNutProject    );
+        addSuffix(".NUTS.JSON"                       , NutType::dotNutProject    ); // project suffix (double ext)
+        addSuffix(".NUTSYMLPROJ"                     , NutType::dotNutProject    );
+        addSuffix(".NUTYMLPROJ"                      , NutType::dotNutProject    );
+        addSuffix(".NUTS.YAML"                       , NutType::dotNutProject    );
+
+        addSuffix("DOTNUT.APP-SELECTOR.MANIFEST.JSON", NutType::dotNutAppSelector);
+        addSuffix("DOTNUT.APP-SELECTOR.MANIFEST.YAML", NutType::dotNutAppSelector);
+
+        addSuffix(".DOTNUT-MANIFEST.JSON"            , NutType::dotNutManifect   );
+        addSuffix(".MANIFEST.JSON"                   , NutType::dotNutManifect   );
+        addSuffix(".DOTNUT-MANIFEST.YAML"            , NutType::dotNutManifect   );
+        addSuffix(".MANIFEST.YAML"                   , NutType::dotNutManifect   );
+
+        addSuffix(".JSON"                            , NutType::dotNutProject    );
+        addSuffix(".YAML"                            , NutType::dotNutProject    );
+    }
+
+    template<typename CharType>
+    NutType match(const CharType *pName, std::size_t len) const
+    {
+        NutType     result  = NutType::unknownNutType;
+        std::size_t nodeIdx = 0;
+
+        for(std::size_t i=len; i!=0; --i)
+        {
+            int ci = charIndex(pName[i-1]);
+            if (ci<0)
+            {
+                break;
+            }
+
+            std::int16_t nextIdx = m_nodes[nodeIdx].next[ci];
+            if (nextIdx<0)
+            {
+                break;
+            }
+
+            nodeIdx = (std::size_t)nextIdx;
+            if (m_nodes[nodeIdx].nutType!=NutType::invalid)
+            {
+                result = m_nodes[nodeIdx].nutType;
+            }
+        }
+
+        return result;
+    }
+
+    template<typename StringType>
+    NutType match(const StringType &name) const
+    {
+        return match(name.data(), name.size());
+    }
+
+    // Пакетная классификация: pTypes[i] = match(pNames[i]). Без выделения памяти
+    template<typename CharType>
+    void match(const std::basic_string_view<CharType> *pNames, std::size_t count, NutType *pTypes) const
+    {
+        for(std::size_t i=0; i!=count; ++i)
+        {
+            pTypes[i] = match(pNames[i].data(), pNames[i].size());
+        }
+    }
+
+}; // struct NutTypeSuffixMatcher
+
+//----------------------------------------------------------------------------
+// Строится один раз при первом обращении
+inline
+const NutTypeSuffixMatcher& getNutTypeSuffixMatcher()
+{
+    static const NutTypeSuffixMatcher matcher;
+    return matcher;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
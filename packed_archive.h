@@ -0,0 +1,659 @@
+/*! \file
+    \brief Single-file packed assets archive with hashed table of contents
+*/
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+//
+#include "defs.h"
+#include "types.h"
+#include "binary_stream.h"
+#include "buffer_pool.h"
+#include "case_fold.h"
+#include "hash_utils.h"
+#include "mapped_file.h"
+
+//
+#include "umba/string_plus.h"
+
+//
+#if defined(MARTY_ASSMAN_PACKED_ARCHIVE_LZ4)
+    #include "lz4.h"
+    #include "lz4hc.h"
+#endif
+
+#if defined(MARTY_ASSMAN_PACKED_ARCHIVE_ZSTD)
+    #include "zstd.h"
+#endif
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Формат архива (все числа - little endian):
+//
+//   Заголовок (headerSize байт)
+//     u32 signature, u32 version, u32 numEntries, u32 numHashSlots
+//     u64 tocOffset, u64 hashOffset, u64 namesOffset, u64 namesSize
+//   Данные файлов, каждый файл начинается с границы dataAlignment
+//   Таблица записей, по tocEntrySize байт на запись
+//     u64 nameHash, u32 nameOffset, u32 nameSize, u64 dataOffset, u64 storedSize, u64 dataSize, u32 codec, u32 reserved
+//     nameHash - FNV-1a имени в верхнем регистре (hashStringCaseFoldFnv1a64), чтобы на Windows имена
+//     искались без учёта регистра, как и в самой ФС; на остальных платформах имена сравниваются точно.
+//     Регистр приводится только у ASCII букв (см. caseFoldChar) - не-ASCII имена на Windows ищутся с точностью до регистра
+//     storedSize - размер в архиве, dataSize - размер после распаковки
+//   Хэш-таблица - numHashSlots (степень двойки) элементов u32: индекс записи + 1, 0 - пусто.
+//     Открытая адресация с линейным пробированием
+//   Имена файлов в UTF-8, относительно корня архива, разделитель - '/'
+namespace packed_archive {
+
+const std::uint32_t signature     = 0x4B50414Du; // "MAPK"
+const std::uint32_t version       = 3u;
+const std::size_t   headerSize    = 64u;
+const std::size_t   tocEntrySize  = 48u;
+const std::uint64_t dataAlignment = 4096u;
+
+// Способ хранения записи. Сжатые записи читаются, только если поддержка кодека включена при сборке
+const std::uint32_t codecNone     = 0u;
+const std::uint32_t codecLz4      = 1u;
+const std::uint32_t codecZstd     = 2u;
+
+// Сжатая запись сохраняется, только если она меньше несжатой хотя бы на 1/minCompressionGainDiv
+const std::uint64_t minCompressionGainDiv = 8u;
+
+// Во сколько раз распакованная запись может быть больше сжатой. С запасом выше того, чего достигают
+// LZ4 (~255:1) и zstd (~32000:1 на однородных данных); больше - оглавление испорчено
+const std::uint64_t maxCompressionRatio   = 65536u;
+
+//----------------------------------------------------------------------------
+// Диапазон [offset, offset+count*itemSize) лежит внутри [0, totalSize). Проверка без переполнений
+inline
+bool isRangeInside(std::uint64_t offset, std::uint64_t count, std::uint64_t itemSize, std::uint64_t totalSize)
+{
+    if (offset>totalSize)
+    {
+        return false;
+    }
+
+    return itemSize==0 || count<=(totalSize-offset)/itemSize;
+}
+
+//----------------------------------------------------------------------------
+// Размер распакованной записи из оглавления не доверяем: он не должен превышать ни разумной степени сжатия,
+// ни MARTY_ASSMAN_PACKED_ARCHIVE_MAX_ENTRY_SIZE, и должен помещаться в size_t
+inline
+ErrorCode checkUnpackedSize(std::uint64_t storedSize, std::uint64_t dataSize)
+{
+    if (dataSize/maxCompressionRatio>storedSize)
+    {
+        return ErrorCode::invalidFormat;
+    }
+
+    if (dataSize>(std::uint64_t)(MARTY_ASSMAN_PACKED_ARCHIVE_MAX_ENTRY_SIZE) || dataSize>(std::uint64_t)SIZE_MAX)
+    {
+        return ErrorCode::notSupported;
+    }
+
+    return ErrorCode::ok;
+}
+
+//----------------------------------------------------------------------------
+inline
+bool isCodecSupported(std::uint32_t codec)
+{
+    switch(codec)
+    {
+        case codecNone: return true;
+        #if defined(MARTY_ASSMAN_PACKED_ARCHIVE_LZ4)
+        case codecLz4 : return true;
+        #endif
+        #if defined(MARTY_ASSMAN_PACKED_ARCHIVE_ZSTD)
+        case codecZstd: return true;
+        #endif
+        default       : return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Распаковка ровно в dstSize байт
+inline
+ErrorCode decompress(std::uint32_t codec, const std::uint8_t *pSrc, std::size_t srcSize, std::uint8_t *pDst, std::size_t dstSize)
+{
+    switch(codec)
+    {
+        case codecNone:
+        {
+            if (srcSize!=dstSize)
+            {
+                return ErrorCode::invalidFormat;
+            }
+
+            std::copy(pSrc, pSrc+srcSize, pDst);
+            return ErrorCode::ok;
+        }
+
+        #if defined(MARTY_ASSMAN_PACKED_ARCHIVE_LZ4)
+        case codecLz4:
+        {
+            if (srcSize>(std::size_t)LZ4_MAX_INPUT_SIZE || dstSize>(std::size_t)LZ4_MAX_INPUT_SIZE)
+            {
+                return ErrorCode::invalidFormat;
+            }
+
+            int res = LZ4_decompress_safe((const char*)pSrc, (char*)pDst, (int)srcSize, (int)dstSize);
+            return res>=0 && (std::size_t)res==dstSize ? ErrorCode::ok : ErrorCode::invalidFormat;
+        }
+        #endif
+
+        #if defined(MARTY_ASSMAN_PACKED_ARCHIVE_ZSTD)
+        case codecZstd:
+        {
+            std::size_t res = ZSTD_decompress(pDst, dstSize, pSrc, srcSize);
+            return !ZSTD_isError(res) && res==dstSize ? ErrorCode::ok : ErrorCode::invalidFormat;
+        }
+        #endif
+
+        default:
+            return ErrorCode::notSupported;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Сжатие для построителя архива. Возвращает false, если сжать не удалось или кодек не поддерживается
+inline
+bool compress(std::uint32_t codec, const std::vector<std::uint8_t> &src, std::vector<std::uint8_t> &dst)
+{
+    switch(codec)
+    {
+        #if defined(MARTY_ASSMAN_PACKED_ARCHIVE_LZ4)
+        case codecLz4:
+        {
+            if (src.size()>(std::size_t)LZ4_MAX_INPUT_SIZE)
+            {
+                return false;
+            }
+
+            // HC - медленнее при упаковке, но распаковка такая же быстрая, а сжатие лучше
+            dst.resize((std::size_t)LZ4_compressBound((int)src.size()));
+            int res = LZ4_compress_HC((const char*)src.data(), (char*)dst.data(), (int)src.size(), (int)dst.size(), LZ4HC_CLEVEL_MAX);
+            if (res<=0)
+            {
+                return false;
+            }
+
+            dst.resize((std::size_t)res);
+            return true;
+        }
+        #endif
+
+        #if defined(MARTY_ASSMAN_PACKED_ARCHIVE_ZSTD)
+        case codecZstd:
+        {
+            dst.resize(ZSTD_compressBound(src.size()));
+            std::size_t res = ZSTD_compress(dst.data(), dst.size(), src.data(), src.size(), 19);
+            if (ZSTD_isError(res))
+            {
+                return false;
+            }
+
+            dst.resize(res);
+            return true;
+        }
+        #endif
+
+        default:
+            MARTY_ASSMAN_ARG_USED(src);
+            MARTY_ASSMAN_ARG_USED(dst);
+            return false;
+    }
+}
+
+} // namespace packed_archive
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// Открытый (отображённый в память) архив. Поиск файла - O(1), без обращений к ФС
+struct PackedArchive
+{
+
+protected:
+
+    struct TocEntry
+    {
+        std::uint64_t   nameHash   = 0;
+        std::uint32_t   nameOffset = 0;
+        std::uint32_t   nameSize   = 0;
+        std::uint64_t   dataOffset = 0;
+        std::uint64_t   storedSize = 0;
+        std::uint64_t   dataSize   = 0;
+        std::uint32_t   codec      = packed_archive::codecNone;
+    };
+
+    std::wstring                    m_nativeName ;
+    std::shared_ptr<MappedFile>     m_pMapped    ;
+    std::shared_ptr<DataBufferPool> m_pBufferPool = std::make_shared<DataBufferPool>(); // Буфера для распаковки
+    std::vector<TocEntry>           m_entries    ;
+    std::vector<std::uint32_t>      m_hashSlots  ;
+    const char                     *m_pNames     = 0;
+    std::size_t                     m_namesSize  = 0;
+
+
+    const TocEntry* findEntry(const std::string &name) const
+    {
+        if (m_hashSlots.empty())
+        {
+            return 0;
+        }
+
+        const std::uint64_t hash = hashStringCaseFoldFnv1a64(name);
+        const std::size_t   mask = m_hashSlots.size()-1;
+
+        for(std::size_t slot=(std::size_t)hash&mask, i=0; i!=m_hashSlots.size(); slot=(slot+1)&mask, ++i)
+        {
+            std::uint32_t idx = m_hashSlots[slot];
+            if (!idx)
+            {
+                return 0;
+            }
+
+            const TocEntry &e = m_entries[idx-1];
+            if (e.nameHash!=hash || e.nameSize!=name.size())
+            {
+                continue;
+            }
+
+            #if defined(WIN32) || defined(_WIN32)
+            if (CaseFoldEqual()(std::string_view(name), std::string_view(m_pNames+e.nameOffset, e.nameSize)))
+            #else
+            if (name.compare(0, name.size(), m_pNames+e.nameOffset, e.nameSize)==0)
+            #endif
+            {
+                return &e;
+            }
+        }
+
+        return 0;
+    }
+
+
+public:
+
+    ErrorCode open(const std::wstring &nativeArchiveName)
+    {
+        m_nativeName.clear();
+        m_pMapped.reset();
+        m_entries.clear();
+        m_hashSlots.clear();
+        m_pNames    = 0;
+        m_namesSize = 0;
+
+        auto pMapped = std::make_shared<MappedFile>();
+        ErrorCode err = pMapped->open(nativeArchiveName);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        const std::size_t archiveSize = pMapped->size();
+        if (archiveSize<packed_archive::headerSize)
+        {
+            return ErrorCode::invalidFormat;
+        }
+
+        BinaryReader hdr(pMapped->data(), packed_archive::headerSize);
+        if (hdr.readU32()!=packed_archive::signature || hdr.readU32()!=packed_archive::version)
+        {
+            return ErrorCode::invalidFormat;
+        }
+
+        std::uint64_t numEntries   = hdr.readU32();
+        std::uint64_t numHashSlots = hdr.readU32();
+        std::uint64_t tocOffset    = hdr.readU64();
+        std::uint64_t hashOffset   = hdr.readU64();
+        std::uint64_t namesOffset  = hdr.readU64();
+        std::uint64_t namesSize    = hdr.readU64();
+
+        if ( (numHashSlots&(numHashSlots-1))!=0 || numHashSlots<numEntries
+          || !packed_archive::isRangeInside(tocOffset  , numEntries  , packed_archive::tocEntrySize, archiveSize)
+          || !packed_archive::isRangeInside(hashOffset , numHashSlots, 4u                          , archiveSize)
+          || !packed_archive::isRangeInside(namesOffset, namesSize   , 1u                          , archiveSize)
+           )
+        {
+            return ErrorCode::invalidFormat;
+        }
+
+        BinaryReader toc(pMapped->data()+tocOffset, (std::size_t)(numEntries*packed_archive::tocEntrySize));
+        m_entries.resize((std::size_t)numEntries);
+        for(auto &e : m_entries)
+        {
+            e.nameHash   = toc.readU64();
+            e.nameOffset = toc.readU32();
+            e.nameSize   = toc.readU32();
+            e.dataOffset = toc.readU64();
+            e.storedSize = toc.readU64();
+            e.dataSize   = toc.readU64();
+            e.codec      = toc.readU32();
+            toc.readU32(); // reserved
+
+            if ( (std::uint64_t)e.nameOffset+e.nameSize > namesSize
+              || !packed_archive::isRangeInside(e.dataOffset, e.storedSize, 1u, archiveSize)
+              || (e.codec==packed_archive::codecNone && e.storedSize!=e.dataSize)
+               )
+            {
+                m_entries.clear();
+                return ErrorCode::invalidFormat;
+            }
+        }
+
+        BinaryReader hashes(pMapped->data()+hashOffset, (std::size_t)(numHashSlots*4u));
+        m_hashSlots.resize((std::size_t)numHashSlots);
+        for(auto &slot : m_hashSlots)
+        {
+            slot = hashes.readU32();
+            if (slot>numEntries)
+            {
+                m_entries.clear();
+                m_hashSlots.clear();
+                return ErrorCode::invalidFormat;
+            }
+        }
+
+        m_pNames    = (const char*)(pMapped->data()+namesOffset);
+        m_namesSize = (std::size_t)namesSize;
+        m_pMapped    = pMapped;
+        m_nativeName = nativeArchiveName;
+
+        return ErrorCode::ok;
+    }
+
+    bool isOpened() const
+    {
+        return m_pMapped!=0;
+    }
+
+    const std::wstring& getNativeFileName() const
+    {
+        return m_nativeName;
+    }
+
+    std::size_t getNumEntries() const
+    {
+        return m_entries.size();
+    }
+
+    std::string getEntryName(std::size_t idx) const
+    {
+        const TocEntry &e = m_entries[idx];
+        return std::string(m_pNames+e.nameOffset, e.nameSize);
+    }
+
+    std::uint64_t getEntrySize(std::size_t idx) const
+    {
+        return m_entries[idx].dataSize;
+    }
+
+    bool exists(const std::string &name) const
+    {
+        return findEntry(name)!=0;
+    }
+
+    // Несжатые данные отдаются без копирования, DataView держит отображение архива.
+    // Сжатые распаковываются в буфер из пула, буфер возвращается в пул вместе с последней копией DataView
+    ErrorCode readDataView(const std::string &name, DataView &view) const
+    {
+        const TocEntry *pEntry = findEntry(name);
+        if (!pEntry)
+        {
+            return ErrorCode::notFound;
+        }
+
+        const std::uint8_t *pStored = m_pMapped->data()+pEntry->dataOffset;
+
+        if (pEntry->codec==packed_archive::codecNone)
+        {
+            view.data   = pStored;
+            view.size   = (std::size_t)pEntry->dataSize;
+            view.holder = m_pMapped;
+            return ErrorCode::ok;
+        }
+
+        if (!packed_archive::isCodecSupported(pEntry->codec))
+        {
+            return ErrorCode::notSupported;
+        }
+
+        ErrorCode err = packed_archive::checkUnpackedSize(pEntry->storedSize, pEntry->dataSize);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        auto pBuf = m_pBufferPool->acquire((std::size_t)pEntry->dataSize);
+        err = packed_archive::decompress(pEntry->codec, pStored, (std::size_t)pEntry->storedSize, pBuf->data(), pBuf->size());
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        view.data   = pBuf->data();
+        view.size   = pBuf->size();
+        view.holder = pBuf;
+
+        return ErrorCode::ok;
+    }
+
+    // Копия данных файла, сжатые данные распаковываются сразу в буфер вызывающего
+    ErrorCode readData(const std::string &name, std::vector<std::uint8_t> &data) const
+    {
+        const TocEntry *pEntry = findEntry(name);
+        if (!pEntry)
+        {
+            return ErrorCode::notFound;
+        }
+
+        if (!packed_archive::isCodecSupported(pEntry->codec))
+        {
+            return ErrorCode::notSupported;
+        }
+
+        if (pEntry->codec!=packed_archive::codecNone) // Размер несжатых записей уже сверен с размером архива
+        {
+            ErrorCode err = packed_archive::checkUnpackedSize(pEntry->storedSize, pEntry->dataSize);
+            if (err!=ErrorCode::ok)
+            {
+                return err;
+            }
+        }
+
+        data.resize((std::size_t)pEntry->dataSize);
+        return packed_archive::decompress( pEntry->codec, m_pMapped->data()+pEntry->dataOffset, (std::size_t)pEntry->storedSize
+                                         , data.data(), data.size()
+                                         );
+    }
+
+}; // struct PackedArchive
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// Создание архива из списка файлов: (имя в архиве в UTF-8, имя файла в локальной ФС).
+// codec - кодек для сжатия записей; записи, которые сжимаются плохо, хранятся как есть
+inline
+ErrorCode buildPackedArchive( const std::vector< std::pair<std::string, std::wstring> > &files
+                            , const std::wstring                                         &nativeArchiveName
+                            , std::uint32_t                                               codec = packed_archive::codecNone
+                            )
+{
+    if (!packed_archive::isCodecSupported(codec))
+    {
+        return ErrorCode::notSupported;
+    }
+
+    const std::size_t numEntries = files.size();
+
+    std::size_t numHashSlots = 1;
+    while(numHashSlots<numEntries*2u)
+    {
+        numHashSlots <<= 1;
+    }
+
+    BinaryWriter w;
+    w.data.resize(packed_archive::headerSize, 0);
+
+    std::vector<std::uint64_t> dataOffsets(numEntries);
+    std::vector<std::uint64_t> storedSizes(numEntries);
+    std::vector<std::uint64_t> dataSizes  (numEntries);
+    std::vector<std::uint32_t> codecs     (numEntries, packed_archive::codecNone);
+
+    std::vector<std::uint8_t>  fileData;
+    std::vector<std::uint8_t>  compressedData;
+
+    for(std::size_t i=0; i!=numEntries; ++i)
+    {
+        std::size_t alignedSize = (std::size_t)((w.data.size()+packed_archive::dataAlignment-1)/packed_archive::dataAlignment*packed_archive::dataAlignment);
+        w.data.resize(alignedSize, 0);
+
+        ErrorCode err = readNativeBinaryFile(files[i].second, fileData);
+        if (err!=ErrorCode::ok)
+        {
+            return err;
+        }
+
+        dataOffsets[i] = (std::uint64_t)w.data.size();
+        dataSizes  [i] = (std::uint64_t)fileData.size();
+
+        if ( codec!=packed_archive::codecNone && !fileData.empty()
+          && packed_archive::compress(codec, fileData, compressedData)
+          && compressedData.size() < fileData.size() - fileData.size()/packed_archive::minCompressionGainDiv
+          && packed_archive::checkUnpackedSize(compressedData.size(), fileData.size())==ErrorCode::ok // Иначе её не прочитать
+           )
+        {
+            codecs     [i] = codec;
+            storedSizes[i] = (std::uint64_t)compressedData.size();
+            w.writeBytes(compressedData.data(), compressedData.size());
+        }
+        else
+        {
+            storedSizes[i] = (std::uint64_t)fileData.size();
+            w.writeBytes(fileData.data(), fileData.size());
+        }
+    }
+
+    std::string               names;
+    std::vector<std::uint32_t> hashSlots(numHashSlots, 0u);
+
+    const std::uint64_t tocOffset = (std::uint64_t)w.data.size();
+
+    for(std::size_t i=0; i!=numEntries; ++i)
+    {
+        const std::string  &name = files[i].first;
+        const std::uint64_t hash = hashStringCaseFoldFnv1a64(name);
+
+        w.writeU64(hash);
+        w.writeU32((std::uint32_t)names.size());
+        w.writeU32((std::uint32_t)name.size());
+        w.writeU64(dataOffsets[i]);
+        w.writeU64(storedSizes[i]);
+        w.writeU64(dataSizes[i]);
+        w.writeU32(codecs[i]);
+        w.writeU32(0u);
+
+        names.append(name);
+
+        std::size_t slot = (std::size_t)hash&(numHashSlots-1);
+        while(hashSlots[slot])
+        {
+            slot = (slot+1)&(numHashSlots-1);
+        }
+
+        hashSlots[slot] = (std::uint32_t)(i+1);
+    }
+
+    const std::uint64_t hashOffset = (std::uint64_t)w.data.size();
+    for(auto slot : hashSlots)
+    {
+        w.writeU32(slot);
+    }
+
+    const std::uint64_t namesOffset = (std::uint64_t)w.data.size();
+    w.writeBytes(names.data(), names.size());
+
+    BinaryWriter hdr;
+    hdr.writeU32(packed_archive::signature);
+    hdr.writeU32(packed_archive::version);
+    hdr.writeU32((std::uint32_t)numEntries);
+    hdr.writeU32((std::uint32_t)numHashSlots);
+    hdr.writeU64(tocOffset);
+    hdr.writeU64(hashOffset);
+    hdr.writeU64(namesOffset);
+    hdr.writeU64((std::uint64_t)names.size());
+    std::copy(hdr.data.begin(), hdr.data.end(), w.data.begin());
+
+    return writeNativeBinaryFile(nativeArchiveName, w.data);
+}
+
+//----------------------------------------------------------------------------
+// Упаковка всего содержимого каталога локальной ФС (рекурсивно)
+inline
+ErrorCode buildPackedArchiveFromDirectory( const std::wstring &nativeSourceDir
+                                         , const std::wstring &nativeArchiveName
+                                         , std::uint32_t       codec = packed_archive::codecNone
+                                         )
+{
+    std::error_code ec;
+    std::filesystem::path rootPath(nativeSourceDir);
+
+    if (!std::filesystem::is_directory(rootPath, ec))
+    {
+        return ErrorCode::notDirectory;
+    }
+
+    std::vector< std::pair<std::string, std::wstring> > files;
+
+    for(std::filesystem::recursive_directory_iterator it(rootPath, ec), end; !ec && it!=end; it.increment(ec))
+    {
+        if (!it->is_regular_file(ec))
+        {
+            continue;
+        }
+
+        std::wstring relName = it->path().lexically_relative(rootPath).generic_wstring();
+        files.emplace_back(umba::toUtf8(relName), it->path().wstring());
+    }
+
+    if (ec)
+    {
+        return ErrorCode::genericError;
+    }
+
+    // Стабильный порядок - одинаковое содержимое даёт одинаковый архив
+    std::sort(files.begin(), files.end());
+
+    return buildPackedArchive(files, nativeArchiveName, codec);
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
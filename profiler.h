@@ -0,0 +1,296 @@
+/*! \file
+    \brief Lightweight scoped timers with Chrome trace (Perfetto) JSON export
+*/
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+#include "defs.h"
+#include "types.h"
+#include "binary_stream.h"
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+struct ProfileEvent
+{
+    const char*     name     = 0; // Только строковые литералы - имя не копируется
+    std::uint64_t   startNs  = 0; // От создания профайлера, монотонные часы
+    std::uint64_t   durNs    = 0;
+    std::uint64_t   bytes    = 0; // Сколько байт прочитано этим потоком за время замера
+    std::uint32_t   threadId = 0; // Порядковый номер потока, начиная с 1
+
+}; // struct ProfileEvent
+
+//----------------------------------------------------------------------------
+// Журнал замеров времени - один на процесс (см. getProfiler()), так как замеряется и то, что выполняется
+// до создания менеджера ассетов (настройка VFS и т.п.).
+// Замеры вставляются макросами MARTY_ASSMAN_PROFILE_*, которые без MARTY_ASSMAN_PROFILING ничего не делают.
+// Со вставленными замерами запись включается/выключается во время работы (setEnabled), по умолчанию выключена -
+// выключенный замер стоит одну relaxed-загрузку флага. Количество событий ограничено (MARTY_ASSMAN_PROFILING_MAX_EVENTS),
+// лишние отбрасываются.
+// Прочитанные байты считаются по потокам (countThreadBytes) - замер получает всё, что его поток прочитал за время замера,
+// включая вложенные вызовы. Чтения в пулах потоков видны только в замерах, сделанных в этих потоках
+struct Profiler
+{
+
+protected:
+
+    typedef std::chrono::steady_clock   Clock;
+
+    std::atomic<bool>                   m_enabled        {false};
+    Clock::time_point                   m_epoch          ;
+
+    mutable std::mutex                  m_mutex          ;
+    std::vector<ProfileEvent>           m_events         ;
+    std::size_t                         m_maxEvents      = MARTY_ASSMAN_PROFILING_MAX_EVENTS;
+    std::uint64_t                       m_droppedEvents  = 0;
+
+
+    static std::uint32_t getThreadId()
+    {
+        static std::atomic<std::uint32_t> nextId{1};
+        thread_local std::uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    // Имена у нас - идентификаторы, но на всякий случай экранируем
+    static void appendJsonString(std::string &str, const char *pStr)
+    {
+        str.append(1, '\"');
+        for(; pStr && *pStr; ++pStr)
+        {
+            char ch = *pStr;
+            if (ch=='\"' || ch=='\\')
+            {
+                str.append(1, '\\');
+                str.append(1, ch);
+            }
+            else if ((unsigned char)ch<0x20)
+            {
+                str.append(1, ' ');
+            }
+            else
+            {
+                str.append(1, ch);
+            }
+        }
+        str.append(1, '\"');
+    }
+
+    // Chrome trace ожидает микросекунды, дробная часть - наносекунды
+    static void appendMicroseconds(std::string &str, std::uint64_t ns)
+    {
+        str.append(std::to_string(ns/1000u));
+        std::uint64_t frac = ns%1000u;
+        if (frac)
+        {
+            std::string fracStr = std::to_string(frac);
+            str.append(1, '.');
+            str.append(3-fracStr.size(), '0');
+            str.append(fracStr);
+        }
+    }
+
+
+public:
+
+    Profiler()
+    : m_epoch(Clock::now())
+    {}
+
+    Profiler(const Profiler &) = delete;
+    Profiler& operator=(const Profiler &) = delete;
+
+
+    bool isEnabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool bEnable)
+    {
+        m_enabled.store(bEnable, std::memory_order_relaxed);
+    }
+
+    void setMaxEvents(std::size_t maxEvents)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxEvents = maxEvents;
+    }
+
+    static std::uint64_t& threadBytes()
+    {
+        thread_local std::uint64_t bytes = 0;
+        return bytes;
+    }
+
+    static void countThreadBytes(std::uint64_t bytes)
+    {
+        threadBytes() += bytes;
+    }
+
+    std::uint64_t now() const
+    {
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now()-m_epoch).count();
+    }
+
+    void addEvent(const char *name, std::uint64_t startNs, std::uint64_t endNs, std::uint64_t bytes)
+    {
+        ProfileEvent evt;
+        evt.name     = name;
+        evt.startNs  = startNs;
+        evt.durNs    = endNs>startNs ? endNs-startNs : 0;
+        evt.bytes    = bytes;
+        evt.threadId = getThreadId();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_events.size()>=m_maxEvents)
+        {
+            ++m_droppedEvents;
+            return;
+        }
+
+        m_events.emplace_back(evt);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.clear();
+        m_droppedEvents = 0;
+    }
+
+    std::vector<ProfileEvent> getEvents() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_events;
+    }
+
+    std::uint64_t getDroppedEventsCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_droppedEvents;
+    }
+
+    // Формат Trace Event (JSON Object Format) - открывается в chrome://tracing и ui.perfetto.dev.
+    // Каждое событие - законченный интервал ("ph":"X"), прочитанные байты - в args
+    std::string toChromeTraceJson() const
+    {
+        std::vector<ProfileEvent> events = getEvents();
+
+        std::string str;
+        str.reserve(64+events.size()*128);
+        str.append("{\"traceEvents\":[");
+
+        for(std::size_t i=0; i!=events.size(); ++i)
+        {
+            const ProfileEvent &evt = events[i];
+
+            str.append(i ? ",\n" : "\n");
+            str.append("{\"name\":");
+            appendJsonString(str, evt.name);
+            str.append(",\"cat\":\"marty_assets_manager\",\"ph\":\"X\",\"ts\":");
+            appendMicroseconds(str, evt.startNs);
+            str.append(",\"dur\":");
+            appendMicroseconds(str, evt.durNs);
+            str.append(",\"pid\":1,\"tid\":");
+            str.append(std::to_string(evt.threadId));
+            str.append(",\"args\":{\"bytes\":");
+            str.append(std::to_string(evt.bytes));
+            str.append("}}");
+        }
+
+        str.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+        return str;
+    }
+
+    ErrorCode writeChromeTrace(const std::wstring &nativeFileName) const
+    {
+        std::string json = toChromeTraceJson();
+        return writeNativeBinaryFile(nativeFileName, std::vector<std::uint8_t>(json.begin(), json.end()));
+    }
+
+}; // struct Profiler
+
+//----------------------------------------------------------------------------
+inline
+Profiler& getProfiler()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+//----------------------------------------------------------------------------
+// Замер времени от создания до разрушения объекта. Решение, писать ли событие, принимается при создании
+struct ProfileScope
+{
+
+protected:
+
+    const char*      m_name   ;
+    std::uint64_t    m_startNs    = 0;
+    std::uint64_t    m_startBytes = 0;
+    bool             m_active     = false;
+
+public:
+
+    explicit ProfileScope(const char *name)
+    : m_name(name)
+    , m_active(getProfiler().isEnabled())
+    {
+        if (m_active)
+        {
+            m_startBytes = Profiler::threadBytes();
+            m_startNs    = getProfiler().now();
+        }
+    }
+
+    ~ProfileScope()
+    {
+        if (m_active)
+        {
+            Profiler &profiler = getProfiler();
+            profiler.addEvent(m_name, m_startNs, profiler.now(), Profiler::threadBytes()-m_startBytes);
+        }
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope& operator=(const ProfileScope &) = delete;
+
+}; // struct ProfileScope
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
+//----------------------------------------------------------------------------
+// MARTY_ASSMAN_PROFILE_SCOPE(var, "name")      - замер до конца текущего блока
+// MARTY_ASSMAN_PROFILE_COUNT_BYTES(bytes)      - учесть прочитанные текущим потоком данные
+#if defined(MARTY_ASSMAN_PROFILING)
+
+    #define MARTY_ASSMAN_PROFILE_SCOPE(var, name)          ::marty_assets_manager::ProfileScope var(name)
+    #define MARTY_ASSMAN_PROFILE_COUNT_BYTES(bytes)        ::marty_assets_manager::Profiler::countThreadBytes((std::uint64_t)(bytes))
+
+#else
+
+    #define MARTY_ASSMAN_PROFILE_SCOPE(var, name)          do{}while(0)
+    #define MARTY_ASSMAN_PROFILE_COUNT_BYTES(bytes)        do{}while(0)
+
+#endif
+
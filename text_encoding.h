@@ -0,0 +1,225 @@
+/*! \file
+    \brief Decoding of text bytes with BOM detection into UTF-8 for files read outside of VFS
+*/
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+namespace text_encoding {
+
+inline
+void appendUtf8(std::string &str, std::uint32_t cp)
+{
+    if (cp<0x80)
+    {
+        str.push_back((char)cp);
+    }
+    else if (cp<0x800)
+    {
+        str.push_back((char)(0xC0 | (cp>>6)));
+        str.push_back((char)(0x80 | (cp&0x3F)));
+    }
+    else if (cp<0x10000)
+    {
+        str.push_back((char)(0xE0 | (cp>>12)));
+        str.push_back((char)(0x80 | ((cp>>6)&0x3F)));
+        str.push_back((char)(0x80 | (cp&0x3F)));
+    }
+    else
+    {
+        str.push_back((char)(0xF0 | (cp>>18)));
+        str.push_back((char)(0x80 | ((cp>>12)&0x3F)));
+        str.push_back((char)(0x80 | ((cp>>6)&0x3F)));
+        str.push_back((char)(0x80 | (cp&0x3F)));
+    }
+}
+
+inline
+bool isValidUtf8(const std::uint8_t *p, std::size_t size)
+{
+    std::size_t i = 0;
+    while(i!=size)
+    {
+        const std::uint8_t b = p[i];
+        if (b<0x80)
+        {
+            ++i;
+            continue;
+        }
+
+        std::size_t   len = 0;
+        std::uint32_t cp  = 0;
+        std::uint32_t minCp = 0;
+
+        if      ((b&0xE0)==0xC0) { len = 2; cp = b&0x1F; minCp = 0x80;    }
+        else if ((b&0xF0)==0xE0) { len = 3; cp = b&0x0F; minCp = 0x800;   }
+        else if ((b&0xF8)==0xF0) { len = 4; cp = b&0x07; minCp = 0x10000; }
+        else
+        {
+            return false;
+        }
+
+        if (size-i<len)
+        {
+            return false;
+        }
+
+        for(std::size_t k=1; k!=len; ++k)
+        {
+            if ((p[i+k]&0xC0)!=0x80)
+            {
+                return false;
+            }
+
+            cp = (cp<<6) | (p[i+k]&0x3F);
+        }
+
+        // Избыточная запись, суррогаты и значения за пределами Unicode
+        if (cp<minCp || (cp>=0xD800 && cp<=0xDFFF) || cp>0x10FFFF)
+        {
+            return false;
+        }
+
+        i += len;
+    }
+
+    return true;
+}
+
+inline
+bool decodeUtf16(const std::uint8_t *p, std::size_t size, bool bigEndian, std::string &utf8)
+{
+    if (size%2)
+    {
+        return false;
+    }
+
+    auto unit = [&](std::size_t idx) -> std::uint32_t
+                {
+                    return bigEndian ? (std::uint32_t)((p[idx]<<8) | p[idx+1]) : (std::uint32_t)(p[idx] | (p[idx+1]<<8));
+                };
+
+    utf8.clear();
+    utf8.reserve(size/2);
+
+    for(std::size_t i=0; i!=size; i+=2)
+    {
+        std::uint32_t cp = unit(i);
+        if (cp>=0xD800 && cp<=0xDBFF)
+        {
+            if (size-i<4)
+            {
+                return false;
+            }
+
+            const std::uint32_t lo = unit(i+2);
+            if (lo<0xDC00 || lo>0xDFFF)
+            {
+                return false;
+            }
+
+            cp = 0x10000 + ((cp-0xD800)<<10) + (lo-0xDC00);
+            i += 2;
+        }
+        else if (cp>=0xDC00 && cp<=0xDFFF)
+        {
+            return false;
+        }
+
+        appendUtf8(utf8, cp);
+    }
+
+    return true;
+}
+
+inline
+bool decodeUtf32(const std::uint8_t *p, std::size_t size, bool bigEndian, std::string &utf8)
+{
+    if (size%4)
+    {
+        return false;
+    }
+
+    utf8.clear();
+    utf8.reserve(size/4);
+
+    for(std::size_t i=0; i!=size; i+=4)
+    {
+        const std::uint32_t cp = bigEndian
+                               ? (std::uint32_t)p[i+3] | ((std::uint32_t)p[i+2]<<8) | ((std::uint32_t)p[i+1]<<16) | ((std::uint32_t)p[i]<<24)
+                               : (std::uint32_t)p[i] | ((std::uint32_t)p[i+1]<<8) | ((std::uint32_t)p[i+2]<<16) | ((std::uint32_t)p[i+3]<<24);
+
+        if ((cp>=0xD800 && cp<=0xDFFF) || cp>0x10FFFF)
+        {
+            return false;
+        }
+
+        appendUtf8(utf8, cp);
+    }
+
+    return true;
+}
+
+} // namespace text_encoding
+
+//----------------------------------------------------------------------------
+// Перекодирует байты текстового файла в UTF-8 без BOM. Кодировка определяется по BOM (UTF-8, UTF-16 LE/BE,
+// UTF-32 LE/BE), текст без BOM должен быть корректным UTF-8.
+// Используется там, где файл читается мимо VFS (упакованные архивы) - IFileSystem::readTextFile умеет
+// определять и однобайтные кодировки, здесь такой текст не угадывается, а отвергается: false - invalidFormat
+inline
+bool decodeTextBytesToUtf8(const void *pData, std::size_t size, std::string &utf8)
+{
+    const std::uint8_t *p = (const std::uint8_t*)pData;
+
+    if (size>=4 && p[0]==0xFF && p[1]==0xFE && p[2]==0x00 && p[3]==0x00)
+    {
+        return text_encoding::decodeUtf32(p+4, size-4, false, utf8);
+    }
+
+    if (size>=4 && p[0]==0x00 && p[1]==0x00 && p[2]==0xFE && p[3]==0xFF)
+    {
+        return text_encoding::decodeUtf32(p+4, size-4, true, utf8);
+    }
+
+    if (size>=2 && p[0]==0xFF && p[1]==0xFE)
+    {
+        return text_encoding::decodeUtf16(p+2, size-2, false, utf8);
+    }
+
+    if (size>=2 && p[0]==0xFE && p[1]==0xFF)
+    {
+        return text_encoding::decodeUtf16(p+2, size-2, true, utf8);
+    }
+
+    if (size>=3 && p[0]==0xEF && p[1]==0xBB && p[2]==0xBF)
+    {
+        p    += 3;
+        size -= 3;
+    }
+
+    if (!text_encoding::isValidUtf8(p, size))
+    {
+        return false;
+    }
+
+    utf8.assign((const char*)p, size);
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+
@@ -5,9 +5,15 @@
 #pragma once
 
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <utility>
 
 //
 #include "marty_virtual_fs/i_filesystem.h"
@@ -45,6 +51,71 @@ typedef marty_virtual_fs::ErrorCode    ErrorCode;
 
 
 
+//----------------------------------------------------------------------------
+// Отметка состояния файла - для проверки, изменился ли файл
+struct FileStamp
+{
+    bool            exists = false;
+    std::uint64_t   size   = 0;
+    std::int64_t    mtime  = 0; // Время модификации в единицах std::filesystem::file_time_type, сравнивается только на равенство
+
+    bool operator==(const FileStamp &other) const
+    {
+        return exists==other.exists && size==other.size && mtime==other.mtime;
+    }
+
+    bool operator!=(const FileStamp &other) const
+    {
+        return !operator==(other);
+    }
+
+}; // struct FileStamp
+
+
+
+//----------------------------------------------------------------------------
+// Неизменяемый разделяемый буфер с данными файла (используется кэшем ассетов)
+typedef std::shared_ptr<const std::vector<std::uint8_t> >    SharedDataBuffer;
+
+// Неизменяемый разделяемый разобранный JSON (используется кэшем конфигов)
+typedef std::shared_ptr<const nlohmann::json>                SharedJson;
+
+//------------------------------
+// Статистика кэша разобранных конфигов
+struct ConfJsonCacheStats
+{
+    std::uint64_t   hits       = 0;
+    std::uint64_t   misses     = 0;
+    std::size_t     numEntries = 0;
+};
+
+
+//----------------------------------------------------------------------------
+// Представление данных файла только для чтения - указатель, размер и владелец данных.
+// Владельцем может быть отображение файла в память или разделяемый буфер,
+// данные валидны, пока жив holder (или любая его копия)
+struct DataView
+{
+    const std::uint8_t            *data = 0;
+    std::size_t                    size = 0;
+    std::shared_ptr<const void>    holder  ;
+
+    bool empty() const { return size==0; }
+
+    const std::uint8_t* begin() const { return data; }
+    const std::uint8_t* end  () const { return data+size; }
+
+    void clear()
+    {
+        data = 0;
+        size = 0;
+        holder.reset();
+    }
+
+}; // struct DataView
+
+
+
 //----------------------------------------------------------------------------
 template<typename StringType>
 struct NutProjectT
@@ -53,12 +124,19 @@ struct NutProjectT
 
     std::vector<StringType>    nuts           ; // nut filenames
     std::vector<StringType>    nutsData       ;
+    std::vector<DataView>      nutsBytecode   ; // Скомпилированный байткод из бандла, параллельно nuts. Пустой - байткода нет или он устарел
+
+    std::vector<StringType>    projectFiles   ; // Файлы проектов, из которых собран проект - основной и все подключенные, в порядке загрузки
+    std::vector< std::pair<std::size_t, std::size_t> >  projectIncludes; // Граф подключений - пары индексов в projectFiles (кто подключает, кого подключает)
 
     void clear()
     {
         projectFileName.clear();
         nuts           .clear();
         nutsData       .clear();
+        nutsBytecode   .clear();
+        projectFiles   .clear();
+        projectIncludes.clear();
     }
 
 };
@@ -68,6 +146,81 @@ typedef NutProjectT<std::string>     NutProjectA;
 typedef NutProjectT<std::wstring>    NutProjectW;
 
 //----------------------------------------------------------------------------
+// Разобранный файл проекта без раскрытия подключений - полные имена в VFS в порядке следования
+template<typename StringType>
+struct NutProjectFileT
+{
+    StringType                                      fileName;
+    FileStamp                                       stamp   ; // Отметка на момент чтения. exists==false - отметку получить нельзя
+    std::vector< std::pair<bool, StringType> >      items   ; // true - подключение (include), false - nut-файл
+
+};
+
+//------------------------------
+// Загруженный проект вместе с отметками файлов, для инкрементальной перезагрузки (reloadNutProjectState)
+template<typename StringType>
+struct NutProjectStateT
+{
+    NutProjectT<StringType>                             project     ;
+
+    bool                                                loaded      = false;
+    std::vector< std::pair<StringType, FileStamp> >     probedStamps; // Кандидаты в имя основного файла проекта, которые не подошли
+    std::vector< NutProjectFileT<StringType> >          parsedFiles ; // Параллельно project.projectFiles
+    std::vector<FileStamp>                              nutStamps   ; // Параллельно project.nuts
+    std::vector<std::uint64_t>                          nutHashes   ; // Параллельно project.nuts, hashStringFnv1a64 текста
+
+};
+
+//------------------------------
+// Что изменилось при перезагрузке проекта
+template<typename StringType>
+struct NutProjectChangesT
+{
+    bool                        nutsListChanged = false; // Изменились состав или порядок nut-файлов
+    std::vector<StringType>     reparsedProjectFiles   ; // Файлы проектов, которые пришлось перечитать
+    std::vector<std::size_t>    changedNuts            ; // Индексы в project.nuts - новые nut-файлы и файлы с изменившимся текстом
+    std::vector<StringType>     removedNuts            ; // nut-файлы, которых больше нет в проекте
+
+    bool empty() const
+    {
+        return !nutsListChanged && reparsedProjectFiles.empty() && changedNuts.empty() && removedNuts.empty();
+    }
+
+};
+
+//------------------------------
+typedef NutProjectStateT<std::string>        NutProjectStateA;
+typedef NutProjectStateT<std::wstring>       NutProjectStateW;
+typedef NutProjectChangesT<std::string>      NutProjectChangesA;
+typedef NutProjectChangesT<std::wstring>     NutProjectChangesW;
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// Результаты асинхронного чтения. Все, кто запросил один и тот же файл, пока он читался, получают один и тот же результат
+struct AsyncDataResult
+{
+    ErrorCode           errorCode = ErrorCode::ok;
+    SharedDataBuffer    data     ;
+};
+
+struct AsyncJsonResult
+{
+    ErrorCode                               errorCode = ErrorCode::ok;
+    SharedJson                              json     ;
+};
+
+//------------------------------
+typedef std::shared_future<AsyncDataResult>              AsyncDataFuture;
+typedef std::shared_future<AsyncJsonResult>              AsyncJsonFuture;
+
+// Колбэки вызываются в потоке ввода-вывода менеджера ассетов
+typedef std::function<void(const AsyncDataResult&)>      AsyncDataCallback;
+typedef std::function<void(const AsyncJsonResult&)>      AsyncJsonCallback;
+
+//----------------------------------------------------------------------------
 
 
 
@@ -0,0 +1,256 @@
+/*! \file
+    \brief Simple worker thread pool for parallel assets loading
+*/
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace marty_assets_manager {
+
+
+
+//----------------------------------------------------------------------------
+// Пул рабочих потоков с общей очередью задач.
+// Задачи не должны бросать исключений - они перехватываются и теряются.
+struct WorkerPool
+{
+
+protected:
+
+    // Очередь задач. Потоки держат её сами, а не через пул: если пул разрушается из своей же задачи,
+    // этот поток после возврата из задачи работает уже с одной очередью
+    struct TaskQueue
+    {
+        std::deque< std::function<void()> >   tasks   ;
+        std::mutex                            mutex   ;
+        std::condition_variable               cv      ;
+        bool                                  stopping = false;
+
+        // Достаёт задачу. false - очередь пуста и больше задач не будет (или wait==false и очередь пуста)
+        bool pop(std::function<void()> &task, bool wait)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (wait)
+            {
+                cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            }
+
+            if (tasks.empty())
+            {
+                return false;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            return true;
+        }
+    };
+
+    std::shared_ptr<TaskQueue>            m_pQueue  ;
+    std::vector<std::thread>              m_threads ;
+
+
+    static void runTask(const std::function<void()> &task)
+    {
+        try
+        {
+            task();
+        }
+        catch(...)
+        {
+        }
+    }
+
+    static void workerProc(std::shared_ptr<TaskQueue> pQueue)
+    {
+        std::function<void()> task;
+        while(pQueue->pop(task, true))
+        {
+            runTask(task);
+            task = nullptr; // Захваченное задачей отпускается до ожидания следующей
+        }
+    }
+
+
+    // Общее состояние parallelFor. Живёт, пока жив хоть один помощник
+    struct ParallelForState
+    {
+        std::size_t                 count    = 0;
+        std::atomic<std::size_t>    nextIdx  {0};
+        std::atomic<std::size_t>    doneCount{0};
+        std::mutex                  mutex    ;
+        std::condition_variable     cv       ;
+        std::exception_ptr          firstException;
+        std::size_t                 firstExceptionIdx = 0;
+        std::function<void(std::size_t)> func;
+
+        void run()
+        {
+            for(;;)
+            {
+                std::size_t idx = nextIdx.fetch_add(1);
+                if (idx>=count)
+                {
+                    return;
+                }
+
+                try
+                {
+                    func(idx);
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!firstException || idx<firstExceptionIdx)
+                    {
+                        firstException    = std::current_exception();
+                        firstExceptionIdx = idx;
+                    }
+                }
+
+                if (doneCount.fetch_add(1)+1==count)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    cv.notify_all();
+                }
+            }
+        }
+    };
+
+
+public:
+
+    explicit WorkerPool(std::size_t numThreads)
+    : m_pQueue(std::make_shared<TaskQueue>())
+    {
+        if (numThreads<1)
+        {
+            numThreads = 1;
+        }
+
+        m_threads.reserve(numThreads);
+        for(std::size_t i=0; i!=numThreads; ++i)
+        {
+            m_threads.emplace_back(&WorkerPool::workerProc, m_pQueue);
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool& operator=(const WorkerPool &) = delete;
+
+    // Выполняет все поставленные задачи и дожидается потоков - после выхода ни одна задача пула уже
+    // не выполняется и не будет выполнена. Можно вызывать и из задачи (колбэка) этого же пула: тогда
+    // вызывающий поток сам выполняет оставшиеся задачи наравне с остальными, дожидается остальных потоков
+    // и отпускается только его собственный std::thread - вернувшись из задачи, он найдёт очередь пустой и завершится
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_pQueue->mutex);
+            m_pQueue->stopping = true;
+        }
+
+        m_pQueue->cv.notify_all();
+
+        const std::thread::id curId = std::this_thread::get_id();
+        bool inWorkerThread = false;
+        for(const auto &t : m_threads)
+        {
+            if (t.get_id()==curId)
+            {
+                inWorkerThread = true;
+            }
+        }
+
+        if (inWorkerThread)
+        {
+            std::function<void()> task;
+            while(m_pQueue->pop(task, false))
+            {
+                runTask(task);
+                task = nullptr;
+            }
+        }
+
+        for(auto &t : m_threads)
+        {
+            if (t.get_id()==curId)
+            {
+                t.detach();
+            }
+            else
+            {
+                t.join();
+            }
+        }
+    }
+
+    std::size_t getNumThreads() const
+    {
+        return m_threads.size();
+    }
+
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_pQueue->mutex);
+            m_pQueue->tasks.emplace_back(std::move(task));
+        }
+
+        m_pQueue->cv.notify_one();
+    }
+
+    // Вызывает func(i) для i из [0, count), раскидывая вызовы по потокам пула.
+    // Вызывающий поток тоже участвует в работе, поэтому вложенные вызовы из задач пула не блокируются намертво.
+    // Если func бросает исключения, после завершения всех вызовов пробрасывается исключение с наименьшим индексом.
+    template<typename Func>
+    void parallelFor(std::size_t count, Func func)
+    {
+        if (count==0)
+        {
+            return;
+        }
+
+        auto pState   = std::make_shared<ParallelForState>();
+        pState->count = count;
+        pState->func  = func;
+
+        std::size_t numHelpers = std::min(count-1, m_threads.size());
+        for(std::size_t i=0; i!=numHelpers; ++i)
+        {
+            submit([pState]() { pState->run(); });
+        }
+
+        pState->run();
+
+        {
+            std::unique_lock<std::mutex> lock(pState->mutex);
+            pState->cv.wait(lock, [&]() { return pState->doneCount.load()==count; });
+        }
+
+        if (pState->firstException)
+        {
+            std::rethrow_exception(pState->firstException);
+        }
+    }
+
+}; // struct WorkerPool
+
+//----------------------------------------------------------------------------
+
+
+
+} // namespace marty_assets_manager
+